@@ -33,11 +33,13 @@
 #include <string.h>
 #include <errno.h>
 #include <unistd.h>
+#include <signal.h>
 #include <sys/time.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include <sys/ipc.h>
 #include <sys/sem.h>
+#include <sys/mman.h>
 
 #include "atop.h"
 #include "photoproc.h"
@@ -59,11 +61,43 @@ static	long 	maxshadowrec;   /* number of records per shadow file      */
 
 static	char	*pacctdir = PACCTDIR;
 
+/*
+** ring buffer of atopacctd (preferred above the shadow files)
+*/
+static	struct pacctring	*acctring;	/* mapped ring buffer	  */
+static	unsigned long long	ringtail;	/* own read cursor	  */
+static	char			ringused;	/* boolean: ring attached */
+
+/*
+** number of records behind the head that can safely be read from the
+** ring buffer; the oldest slots might be overwritten by atopacctd
+** while being copied
+*/
+#define	RINGSAFE(rp)	((rp)->nrecs - (rp)->nrecs / 8)
+
+/*
+** buffer to read the accounting records in chunks
+*/
+#define	ACCTCHUNK	1024	/* maximum number of records per read	  */
+
+static union {
+	struct acct	v2[ACCTCHUNK];
+	struct acct_v3	v3[ACCTCHUNK];
+} acctchunkbuf;
+
+static	char	*acctchunk = (char *)&acctchunkbuf;
+
 static count_t 	acctexp (comp_t  ct);
 static int	acctvers(int);
 static void	acctrestarttrial(void);
 static void	switchshadow(void);
+static void	acctfill(struct tstat *, struct acct *);
+static void	acctfill_v3(struct tstat *, struct acct_v3 *);
 static int	atopacctd(int);
+static int	acctringattach(int);
+static void	acctringdetach(void);
+static unsigned long	acctringcnt(void);
+static unsigned long	acctringread(struct tstat *, int);
 
 /*
 ** possible process accounting files used by (ps)acct package
@@ -380,6 +414,12 @@ atopacctd(int swon)
 
 	acctfd = -1;	// reset to not being open
 
+	/*
+	** the ring buffer avoids polling of the shadow files
+	*/
+	if ( acctringattach(swon) == 0 )
+		return 0;
+
 	/*
  	** open semaphore group that has been initialized by atopacctd
 	** semaphore 0: 100 counting down to reflect number of users of atopacctd
@@ -500,6 +540,200 @@ atopacctd(int swon)
 	return -1;	// try another accounting mechanism
 }
 
+/*
+** try to attach to the ring buffer maintained by the atopacctd daemon
+** swon:	1 - initial switch on (start reading at current head)
+**		0 - attach again after the atopacct service has been
+**		    restarted (start reading at the oldest record)
+**
+** return value: 0 (attached) or -1 (no ring buffer available)
+*/
+static int
+acctringattach(int swon)
+{
+	struct pacctring	*rp;
+	struct stat		ringstat;
+	char			ringpath[512];
+	int			rfd, semid, maxcnt = 40;
+
+	/*
+	** verify that the atopacctd daemon is running, because the
+	** ring buffer of a killed daemon might still exist
+	*/
+	if ( (semid = semget(PACCTPRVKEY, 0, 0)) == -1 ||
+	     semctl(semid, 0, GETVAL, 0) <= 0              )
+		return -1;
+
+	snprintf(ringpath, sizeof ringpath, "%s/%s", pacctdir, PACCTRING);
+
+	if (! droprootprivs() )
+		mcleanstop(42, "failed to drop root privs\n");
+
+	if ( (rfd = open(ringpath, O_RDONLY)) == -1)
+	{
+		regainrootprivs();
+		return -1;
+	}
+
+	if (fstat(rfd, &ringstat) == -1 ||
+	    ringstat.st_size < RINGHDRSZ + RINGDATASZ)
+	{
+		(void) close(rfd);
+		regainrootprivs();
+		return -1;
+	}
+
+	rp = mmap(NULL, RINGHDRSZ + RINGDATASZ, PROT_READ, MAP_SHARED, rfd, 0);
+
+	if (rp == MAP_FAILED)
+	{
+		(void) close(rfd);
+		regainrootprivs();
+		return -1;
+	}
+
+	/*
+	** the layout of the records is only known after the daemon
+	** has read the first record, so force a record to be written
+	*/
+	if (swon && __atomic_load_n(&rp->magic, __ATOMIC_ACQUIRE) == RINGMAGIC &&
+	           !__atomic_load_n(&rp->recsize, __ATOMIC_ACQUIRE))
+	{
+		if ( fork() == 0 )
+			exit(0);
+
+		(void) wait((int *) 0);
+
+		while (!__atomic_load_n(&rp->recsize, __ATOMIC_ACQUIRE) &&
+								--maxcnt)
+			usleep(50000);
+	}
+
+	if (__atomic_load_n(&rp->magic, __ATOMIC_ACQUIRE) != RINGMAGIC ||
+	    __atomic_load_n(&rp->recsize, __ATOMIC_ACQUIRE) == 0        ||
+	    (rp->version != 2 && rp->version != 3)                      ||
+	    rp->recsize != (rp->version == 2 ? sizeof(struct acct) :
+	                                       sizeof(struct acct_v3))    )
+	{
+		(void) munmap(rp, RINGHDRSZ + RINGDATASZ);
+		(void) close(rfd);
+		regainrootprivs();
+		return -1;
+	}
+
+	acctring     = rp;
+	acctfd       = rfd;		// to detect removal of the ring
+	acctrecsz    = rp->recsize;
+	acctversion  = rp->version;
+	ringtail     = swon ? __atomic_load_n(&rp->head, __ATOMIC_ACQUIRE) : 0;
+	ringused     = 1;
+	maxshadowrec = 0;
+
+	supportflags |= ACCTACTIVE;
+
+	regainrootprivs();
+	return 0;
+}
+
+/*
+** release the ring buffer
+*/
+static void
+acctringdetach(void)
+{
+	(void) munmap(acctring, RINGHDRSZ + RINGDATASZ);
+	(void) close(acctfd);
+
+	acctring = NULL;
+	acctfd   = -1;
+}
+
+/*
+** get the number of records in the ring buffer that have not been read
+** (records that have been overwritten already are skipped)
+*/
+static unsigned long
+acctringcnt(void)
+{
+	unsigned long long	head;
+
+	head = __atomic_load_n(&acctring->head, __ATOMIC_ACQUIRE);
+
+	if (head - ringtail > RINGSAFE(acctring))
+		ringtail = head - RINGSAFE(acctring);
+
+	return head - ringtail;
+}
+
+/*
+** read the process records from the ring buffer,
+** that are written since the previous read
+*/
+static unsigned long
+acctringread(struct tstat *accproc, int nrprocs)
+{
+	struct tstat		*api = accproc;
+	unsigned long long	head;
+	char			*ringdata = (char *)acctring + RINGHDRSZ;
+	int			nrexit = 0, nrec, skip, i;
+
+	while (nrexit < nrprocs && (nrec = acctringcnt()) > 0)
+	{
+		if (nrec > nrprocs - nrexit)
+			nrec = nrprocs - nrexit;
+
+		if (nrec > ACCTCHUNK)
+			nrec = ACCTCHUNK;
+
+		/*
+		** copy the next chunk of records
+		*/
+		for (i=0; i < nrec; i++)
+			memcpy(acctchunk + i * acctrecsz, ringdata +
+				((ringtail + i) % acctring->nrecs) * acctrecsz,
+				acctrecsz);
+
+		/*
+		** the oldest records might have been overwritten by
+		** the daemon in the meantime: drop those
+		*/
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+		head = __atomic_load_n(&acctring->head, __ATOMIC_ACQUIRE);
+		skip = 0;
+
+		if (head - ringtail > RINGSAFE(acctring))
+		{
+			skip = head - ringtail - RINGSAFE(acctring);
+
+			if (skip > nrec)
+				skip = nrec;
+		}
+
+		ringtail += nrec;
+
+		/*
+		** fill process info from accounting-records
+		*/
+		switch (acctversion)
+		{
+		   case 2:
+			for (i=skip; i < nrec; i++, api++)
+				acctfill(api, (struct acct *)acctchunk + i);
+			break;
+
+		   case 3:
+			for (i=skip; i < nrec; i++, api++)
+				acctfill_v3(api, (struct acct_v3 *)acctchunk + i);
+			break;
+		}
+
+		nrexit += nrec - skip;
+	}
+
+	return nrexit;
+}
+
 /*
 ** determine the version of the accounting-record layout/length
 ** and reposition the seek-pointer to the end of the accounting file
@@ -618,8 +852,14 @@ acctswoff(void)
 	}
 
 	/*
-	** anyhow close the accounting-file again
+	** anyhow close the accounting-file (or ring buffer) again
 	*/
+	if (acctring)
+	{
+		(void) munmap(acctring, RINGHDRSZ + RINGDATASZ);
+		acctring = NULL;
+	}
+
 	(void) close(acctfd);	/* close account file again */
 	acctfd = -1;
 
@@ -635,6 +875,28 @@ acctprocnt(void)
 {
 	struct stat	statacc;
 
+	/*
+	** handle atopacctd-based process accounting on bases of
+	** the ring buffer
+	*/
+	if (ringused)
+	{
+		/*
+		** ring buffer removed by stopping the atopacct service?
+		*/
+		if (acctring &&
+		    (fstat(acctfd, &statacc) == -1 || statacc.st_nlink == 0))
+			acctringdetach();
+
+		if (!acctring && atopacctd(0))
+			return 0;	// reacquire failed
+
+		if (acctring)
+			return acctringcnt();
+
+		ringused = 0;		// reacquired via shadow files
+	}
+
 	/*
  	** handle atopacctd-based process accounting on bases of
 	** fixed-chunk shadow files
@@ -798,7 +1060,11 @@ acctrepos(unsigned int noverflow)
 	if (acctfd == -1)
 		return;
 
-	if (maxshadowrec)
+	if (acctring)
+	{
+		ringtail += noverflow;
+	}
+	else if (maxshadowrec)
 	{
 		int	i;
 		off_t	virtoffset  = acctsize + noverflow * acctrecsz;
@@ -873,10 +1139,9 @@ acctphotoproc(struct tstat *accproc, int nrprocs)
 {
 	register int 		nrexit;
 	register struct tstat 	*api;
-	struct acct 		acctrec;
-	struct acct_v3 		acctrec_v3;
 	struct stat		statacc;
-	int			filled;
+	ssize_t			nread;
+	int			nrec, wanted, i;
 
 	/*
 	** if accounting not supported, skip call
@@ -884,6 +1149,9 @@ acctphotoproc(struct tstat *accproc, int nrprocs)
 	if (acctfd == -1)
 		return 0;
 
+	if (acctring)
+		return acctringread(accproc, nrprocs);
+
 	/*
 	** determine the size of the (current) account file
 	*/
@@ -891,7 +1159,8 @@ acctphotoproc(struct tstat *accproc, int nrprocs)
 		return 0;
 
 	/*
-	** check all exited processes in accounting file
+	** check all exited processes in accounting file,
+	** reading the records in chunks of (at most) ACCTCHUNK records
 	*/
 	for  (nrexit=0, api=accproc; nrexit < nrprocs; )
 	{
@@ -945,74 +1214,55 @@ acctphotoproc(struct tstat *accproc, int nrprocs)
 		}
 
 		/*
-		** read the next record
+		** determine the number of records for the next chunk:
+		** never beyond the known end of a shadow file or a
+		** rotated file, so a switch to the next file
+		** is only needed at a chunk boundary
+		*/
+		wanted = nrprocs - nrexit;
+
+		if (wanted > ACCTCHUNK)
+			wanted = ACCTCHUNK;
+
+		if ((maxshadowrec || pacctcur) && statacc.st_size > acctsize &&
+		    (statacc.st_size - acctsize) / acctrecsz < wanted)
+			wanted = (statacc.st_size - acctsize) / acctrecsz;
+
+		if (wanted == 0)	// only a partial record available
+			wanted = 1;
+
+		/*
+		** read the next chunk of records
+		*/
+		if ( (nread = read(acctfd, acctchunk, wanted * acctrecsz)) <= 0)
+			break;	/* unexpected end of account file */
+
+		nrec = nread / acctrecsz;
+
+		if (nread % acctrecsz)	/* partial record: read again later */
+			(void) lseek(acctfd, -(nread % acctrecsz), SEEK_CUR);
+
+		if (nrec == 0)
+			break;
+
+		/*
+		** fill process info from accounting-records
 		*/
 		switch (acctversion)
 		{
 		   case 2:
-			if ( read(acctfd, &acctrec, acctrecsz) < acctrecsz )
-				break;	/* unexpected end of account file */
-
-			/*
-			** fill process info from accounting-record
-			*/
-			api->gen.state  = 'E';
-			api->gen.nthr   = 1;
-			api->gen.isproc = 1;
-			api->gen.pid    = 0;
-			api->gen.tgid   = 0;
-			api->gen.ppid   = 0;
-			api->gen.excode = acctrec.ac_exitcode;
-			api->gen.ruid   = acctrec.ac_uid16;
-			api->gen.rgid   = acctrec.ac_gid16;
-			api->gen.btime  = acctrec.ac_btime;
-			api->gen.elaps  = acctrec.ac_etime;
-			api->cpu.stime  = acctexp(acctrec.ac_stime);
-			api->cpu.utime  = acctexp(acctrec.ac_utime);
-			api->mem.minflt = acctexp(acctrec.ac_minflt);
-			api->mem.majflt = acctexp(acctrec.ac_majflt);
-			api->dsk.rio    = acctexp(acctrec.ac_rw);
-
-			safe_strcpy(api->gen.name, acctrec.ac_comm, sizeof api->gen.name);
-			filled = 1;
+			for (i=0; i < nrec; i++, api++)
+				acctfill(api, (struct acct *)acctchunk + i);
 			break;
 
 		   case 3:
-			if ( read(acctfd, &acctrec_v3, acctrecsz) < acctrecsz )
-				break;	/* unexpected end of account file */
-
-			/*
-			** fill process info from accounting-record
-			*/
-			api->gen.state  = 'E';
-			api->gen.pid    = acctrec_v3.ac_pid;
-			api->gen.tgid   = acctrec_v3.ac_pid;
-			api->gen.ppid   = acctrec_v3.ac_ppid;
-			api->gen.nthr   = 1;
-			api->gen.isproc = 1;
-			api->gen.excode = acctrec_v3.ac_exitcode;
-			api->gen.ruid   = acctrec_v3.ac_uid;
-			api->gen.rgid   = acctrec_v3.ac_gid;
-			api->gen.btime  = acctrec_v3.ac_btime;
-			api->gen.elaps  = acctrec_v3.ac_etime;
-			api->cpu.stime  = acctexp(acctrec_v3.ac_stime);
-			api->cpu.utime  = acctexp(acctrec_v3.ac_utime);
-			api->mem.minflt = acctexp(acctrec_v3.ac_minflt);
-			api->mem.majflt = acctexp(acctrec_v3.ac_majflt);
-			api->dsk.rio    = acctexp(acctrec_v3.ac_rw);
-
-			safe_strcpy(api->gen.name, acctrec_v3.ac_comm, sizeof api->gen.name);
-			filled = 1;
+			for (i=0; i < nrec; i++, api++)
+				acctfill_v3(api, (struct acct_v3 *)acctchunk + i);
 			break;
 		}
 
-		if (filled == 1) {
-			nrexit++;
-			api++;
-			acctsize += acctrecsz;
-
-			filled = 0;
-		}
+		nrexit   += nrec;
+		acctsize += nrec * acctrecsz;
 	}
 
 	if (acctsize > ACCTMAXFILESZ && !maxshadowrec)
@@ -1021,6 +1271,247 @@ acctphotoproc(struct tstat *accproc, int nrprocs)
 	return nrexit;
 }
 
+/*
+** streaming aggregation of exited processes that exceed the maximum
+** number of exited processes per sample (MAXACCTPROCS)
+**
+** instead of skipping these processes, their accounting records
+** are read in chunks and folded into summary entries per program name,
+** real user and container/pod (the cgroup of an exited process is not
+** known any more), so the memory stays bounded (atoprc keyword
+** 'acctaggregate' defines the maximum number of summary entries)
+**
+** every summary entry is a tstat with state 'E' that contains the
+** deviations (the resource consumption since the previous sample)
+** of all processes folded into it, and the number of these processes
+** in gen.naggr
+*/
+unsigned long	acctaggrmax;		/* maximum number of summary entries */
+
+static struct tstat	aggrchunk[ACCTCHUNK];	/* chunk of exited processes */
+static unsigned int	*aggrhash;		/* index+1 in summary entries */
+static unsigned int	aggrhashsize;		/* power of 2		       */
+
+static unsigned int
+aggrhashcalc(struct tstat *tp)
+{
+	unsigned int	hash = 2166136261U;		// FNV-1a
+	char		*p;
+
+	for (p=tp->gen.name; *p; p++)
+		hash = (hash ^ (unsigned char)*p) * 16777619U;
+
+	for (p=tp->gen.utsname; *p; p++)
+		hash = (hash ^ (unsigned char)*p) * 16777619U;
+
+	return (hash ^ tp->gen.ruid) * 16777619U;
+}
+
+/*
+** fold one exited process (with its deviations already calculated)
+** into the proper summary entry
+*/
+static void
+aggrfold(struct tstat *aggr, unsigned long *naggr, struct tstat *tp)
+{
+	struct tstat	*ap;
+	unsigned int	slot, ix;
+
+	for (slot = aggrhashcalc(tp) & (aggrhashsize-1); ;
+	     slot = (slot+1) & (aggrhashsize-1))
+	{
+		if ( (ix = aggrhash[slot]) == 0)	// free slot: new entry
+			break;
+
+		ap = aggr + ix - 1;
+
+		if (ap->gen.ruid == tp->gen.ruid                &&
+		    strcmp(ap->gen.name,    tp->gen.name)    == 0 &&
+		    strcmp(ap->gen.utsname, tp->gen.utsname) == 0   )
+			goto fold;
+	}
+
+	/*
+	** no summary entry yet for this combination:
+	** when all entries are in use, the last entry is used as
+	** catch-all entry for all remaining combinations
+	*/
+	if (*naggr >= acctaggrmax - 1)
+	{
+		ap = aggr + acctaggrmax - 1;
+
+		if (ap->gen.naggr == 0)
+		{
+			memset(ap, 0, sizeof *ap);
+			ap->gen.state  = 'E';
+			ap->gen.isproc = 1;
+			ap->gen.nthr   = 1;
+			ap->gen.ruid   = -1;
+			ap->gen.rgid   = -1;
+			ap->gen.btime  = tp->gen.btime;
+			safe_strcpy(ap->gen.name, "<other>", sizeof ap->gen.name);
+			(*naggr)++;
+		}
+
+		goto fold;
+	}
+
+	aggrhash[slot] = *naggr + 1;
+
+	ap = aggr + (*naggr)++;
+
+	memset(ap, 0, sizeof *ap);
+	ap->gen.state  = 'E';
+	ap->gen.isproc = 1;
+	ap->gen.nthr   = 1;
+	ap->gen.ruid   = tp->gen.ruid;
+	ap->gen.rgid   = tp->gen.rgid;
+	ap->gen.btime  = tp->gen.btime;
+	safe_strcpy(ap->gen.name,    tp->gen.name,    sizeof ap->gen.name);
+	safe_strcpy(ap->gen.utsname, tp->gen.utsname, sizeof ap->gen.utsname);
+
+    fold:
+	ap->gen.naggr++;
+
+	if (tp->gen.btime < ap->gen.btime)	// earliest start time
+		ap->gen.btime = tp->gen.btime;
+
+	ap->cpu.utime   += tp->cpu.utime;
+	ap->cpu.stime   += tp->cpu.stime;
+	ap->mem.minflt  += tp->mem.minflt;
+	ap->mem.majflt  += tp->mem.majflt;
+	ap->dsk.rio     += tp->dsk.rio;
+}
+
+/*
+** read 'noverflow' exited processes from the accounting file
+** and fold them into at most acctaggrmax summary entries in 'aggr'
+**
+** return value: number of summary entries
+*/
+unsigned long
+acctaggregate(struct tstat *aggr, unsigned long noverflow)
+{
+	struct tstat	*tp, prestat;
+	struct pinfo	*pinfo;
+	unsigned long	naggr = 0, nread, i;
+	int		found;
+
+	if (acctaggrmax == 0)
+		return 0;
+
+	/*
+	** (re)initialize the hash list with at least
+	** twice the number of slots as summary entries
+	*/
+	if (!aggrhash)
+	{
+		for (aggrhashsize=64; aggrhashsize < acctaggrmax*2; )
+			aggrhashsize *= 2;
+
+		aggrhash = calloc(aggrhashsize, sizeof *aggrhash);
+
+		ptrverify(aggrhash, "Malloc failed for %u aggregation slots\n",
+					aggrhashsize);
+	}
+
+	memset(aggrhash, 0, aggrhashsize * sizeof *aggrhash);
+
+	/*
+	** exited processes without PID (version 2 of the accounting
+	** record) are searched in the RESIDUE-list, like deviattask does
+	*/
+	pdb_makeresidue();
+
+	while (noverflow > 0)
+	{
+		memset(aggrchunk, 0, sizeof aggrchunk);
+
+		nread = acctphotoproc(aggrchunk,
+			noverflow < ACCTCHUNK ? noverflow : ACCTCHUNK);
+
+		if (nread == 0)
+			break;
+
+		noverflow -= nread;
+
+		for (i=0, tp=aggrchunk; i < nread; i++, tp++)
+		{
+			/*
+			** calculate the deviations related to the last
+			** registered sample of this process (if known)
+			** and remove the process from the process database
+			*/
+			if (tp->gen.pid)
+			{
+				found = pdb_gettask(tp->gen.pid, 1,
+						tp->gen.btime, &pinfo);
+			}
+			else
+			{
+				/*
+				** the RESIDUE-list still contains the
+				** tasks that are alive, so a match with
+				** a task that still exists (e.g. a sibling
+				** with the same name and start time) is
+				** not accepted
+				*/
+				found = tp->gen.btime <= pretime		&&
+				        pdb_srchresidue(tp, &pinfo)		&&
+				        kill(pinfo->tstat.gen.pid, 0) == -1	&&
+				        errno == ESRCH;
+			}
+
+			if (found)
+			{
+				prestat = pinfo->tstat;
+
+				tp->cpu.utime  = tp->cpu.utime > prestat.cpu.utime ?
+					tp->cpu.utime - prestat.cpu.utime : 0;
+				tp->cpu.stime  = tp->cpu.stime > prestat.cpu.stime ?
+					tp->cpu.stime - prestat.cpu.stime : 0;
+				tp->mem.minflt = tp->mem.minflt > prestat.mem.minflt ?
+					tp->mem.minflt - prestat.mem.minflt : 0;
+				tp->mem.majflt = tp->mem.majflt > prestat.mem.majflt ?
+					tp->mem.majflt - prestat.mem.majflt : 0;
+				tp->dsk.rio    = tp->dsk.rio >
+					      prestat.dsk.rio + prestat.dsk.wio ?
+					tp->dsk.rio - prestat.dsk.rio -
+					              prestat.dsk.wio : 0;
+
+				safe_strcpy(tp->gen.utsname, prestat.gen.utsname,
+						sizeof tp->gen.utsname);
+
+				pdb_deltask(prestat.gen.pid, prestat.gen.isproc);
+			}
+
+			aggrfold(aggr, &naggr, tp);
+		}
+	}
+
+	/*
+	** skip the records that could not be read
+	*/
+	if (noverflow)
+		acctrepos(noverflow);
+
+	return naggr;
+}
+
+/*
+** atoprc keyword 'acctaggregate': maximum number of summary entries
+** for exited processes beyond MAXACCTPROCS (0 = skip these processes)
+*/
+void
+do_acctaggregate(char *tagname, char *tagvalue)
+{
+	if ( !numeric(tagvalue) )
+		mcleanstop(1, "atoprc: %s value %s not a (positive) numeric\n",
+				tagname, tagvalue);
+
+	acctaggrmax = atol(tagvalue);
+}
+
 /*
 ** when the size of the private accounting file exceeds a certain limit,
 ** it might be useful to stop process accounting, truncate the
@@ -1111,6 +1602,58 @@ acctexp(comp_t ct)
         return val;
 }
 
+/*
+** fill process info from an accounting record (version 2)
+*/
+static void
+acctfill(struct tstat *api, struct acct *acctrec)
+{
+	api->gen.state  = 'E';
+	api->gen.nthr   = 1;
+	api->gen.isproc = 1;
+	api->gen.pid    = 0;
+	api->gen.tgid   = 0;
+	api->gen.ppid   = 0;
+	api->gen.excode = acctrec->ac_exitcode;
+	api->gen.ruid   = acctrec->ac_uid16;
+	api->gen.rgid   = acctrec->ac_gid16;
+	api->gen.btime  = acctrec->ac_btime;
+	api->gen.elaps  = acctrec->ac_etime;
+	api->cpu.stime  = acctexp(acctrec->ac_stime);
+	api->cpu.utime  = acctexp(acctrec->ac_utime);
+	api->mem.minflt = acctexp(acctrec->ac_minflt);
+	api->mem.majflt = acctexp(acctrec->ac_majflt);
+	api->dsk.rio    = acctexp(acctrec->ac_rw);
+
+	safe_strcpy(api->gen.name, acctrec->ac_comm, sizeof api->gen.name);
+}
+
+/*
+** fill process info from an accounting record (version 3)
+*/
+static void
+acctfill_v3(struct tstat *api, struct acct_v3 *acctrec_v3)
+{
+	api->gen.state  = 'E';
+	api->gen.pid    = acctrec_v3->ac_pid;
+	api->gen.tgid   = acctrec_v3->ac_pid;
+	api->gen.ppid   = acctrec_v3->ac_ppid;
+	api->gen.nthr   = 1;
+	api->gen.isproc = 1;
+	api->gen.excode = acctrec_v3->ac_exitcode;
+	api->gen.ruid   = acctrec_v3->ac_uid;
+	api->gen.rgid   = acctrec_v3->ac_gid;
+	api->gen.btime  = acctrec_v3->ac_btime;
+	api->gen.elaps  = acctrec_v3->ac_etime;
+	api->cpu.stime  = acctexp(acctrec_v3->ac_stime);
+	api->cpu.utime  = acctexp(acctrec_v3->ac_utime);
+	api->mem.minflt = acctexp(acctrec_v3->ac_minflt);
+	api->mem.majflt = acctexp(acctrec_v3->ac_majflt);
+	api->dsk.rio    = acctexp(acctrec_v3->ac_rw);
+
+	safe_strcpy(api->gen.name, acctrec_v3->ac_comm, sizeof api->gen.name);
+}
+
 /*
 ** switch to the next accounting shadow file
 */
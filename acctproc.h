@@ -30,6 +30,10 @@ void		acctswoff(void);
 unsigned long 	acctprocnt(void);
 unsigned long	acctphotoproc(struct tstat *, int);
 void 		acctrepos(unsigned int);
+unsigned long	acctaggregate(struct tstat *, unsigned long);
+void		do_acctaggregate(char *, char *);
+
+extern unsigned long	acctaggrmax;
 
 /*
 ** maximum number of records to be read from process accounting file
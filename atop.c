@@ -140,7 +140,6 @@
 #include <sys/time.h>
 #include <sys/resource.h>
 #include <regex.h>
-#include <glib.h>
 #include <sys/inotify.h>
 
 #include "atop.h"
@@ -209,8 +208,6 @@ int 		osrel;
 int 		osvers;
 int 		ossub;
 
-extern GHashTable *ghash_net;
-
 int		supportflags;	/* supported features             	*/
 char		**argvp;
 
@@ -291,6 +288,12 @@ static struct {
 	{	"almostcrit",		do_almostcrit,		0, },
 	{	"atopsarflags",		do_atopsarflags,	0, },
 	{	"perfevents",		do_perfevents,		0, },
+	{	"perfextra",		do_perfextra,		0, },
+	{	"perfprocs",		do_perfprocs,		0, },
+	{	"cgroupprocs",		do_cgroupprocs,		0, },
+	{	"psitrigger",		do_psitrigger,		0, },
+	{	"acctaggregate",	do_acctaggregate,	0, },
+	{	"netflows",		do_netflows,		0, },
 	{	"pacctdir",		do_pacctdir,		1, },
 };
 
@@ -801,6 +804,12 @@ engine(void)
 	if (interval > 0)
 		alarm(interval);
 
+	/*
+	** register the PSI triggers (if defined) that cause
+	** an extra sample when a stall threshold is exceeded
+	*/
+	psitrigger_start();
+
 	if (midnightflag)
 	{
 		time_t		timenow = time(0);
@@ -970,23 +979,35 @@ engine(void)
 		*/
 		if (nprocexit > 0)
 		{
-			curpexit = malloc(nprocexit * sizeof(struct tstat));
+			unsigned long	nalloc = nprocexit;
+
+			if (noverflow)		// room for summary entries
+				nalloc += acctaggrmax;
+
+			curpexit = malloc(nalloc * sizeof(struct tstat));
 
 			ptrverify(curpexit,
 			          "Malloc failed for %lu exited processes\n",
-			          nprocexit);
+			          nalloc);
 
-			memset(curpexit, 0, nprocexit * sizeof(struct tstat));
+			memset(curpexit, 0, nalloc * sizeof(struct tstat));
 
 			nprocexit = acctphotoproc(curpexit, nprocexit);
 
 			/*
- 			** reposition offset in accounting file when not
-			** all exited processes have been read (i.e. skip
-			** those processes)
+ 			** when not all exited processes have been read,
+			** fold the remaining processes into summary
+			** entries (if wanted) or reposition the offset in
+			** the accounting file (i.e. skip those processes)
 			*/
 			if (noverflow)
-				acctrepos(noverflow);
+			{
+				if (acctaggrmax)
+					nprocexit += acctaggregate(curpexit+nprocexit,
+								   noverflow);
+				else
+					acctrepos(noverflow);
+			}
 		}
 		else
 		{
@@ -1007,11 +1028,11 @@ engine(void)
 		deviattask(curtpres, ntaskpres, curpexit, nprocexit,
 		                     &devtstat, devsstat);
 
-		if (supportflags & NETATOPBPF)
-		{
-			g_hash_table_destroy(ghash_net);
-			ghash_net = NULL;
-		}
+		/*
+		** select the processes for which hardware counters
+		** will be gathered during the next interval
+		*/
+		perfproc_select(&devtstat);
 
 		/*
 		** calculate cgroup-level v2 deviations
@@ -1056,7 +1077,7 @@ engine(void)
 			curtime = getboot() / hertz;	// reset current time
 
 			/* set current (will be 'previous') counters to 0 */
-			memset(cursstat, 0, sizeof(struct sstat));
+			sstat_reset(cursstat);
 
 			/* remove all tasks in database */
 			pdb_makeresidue();
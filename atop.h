@@ -55,6 +55,8 @@ struct devtstat;
 struct sstat;
 struct cgchainer;
 struct netpertask;
+struct taskcount;
+struct netperflow;
 
 /* 
 ** miscellaneous flags
@@ -244,16 +246,25 @@ void		netatop_bpf_ipopen(void);
 void		netatop_bpf_probe(void);
 void		netatop_bpf_gettask(void);
 void		netatop_bpf_exitfind(unsigned long, struct tstat *, struct tstat *);
+struct taskcount	*netatop_bpf_findtask(pid_t);
+int		netatop_bpf_findflows(pid_t, struct netperflow **);
+char		*netatop_bpf_flowaddr(struct netperflow *, char *, int);
+void		do_netflows(char *, char *);
 
 void		set_oom_score_adj(void);
 int		run_in_guest(void);
 
 void		getusr1(int), getusr2(int);
+int		psitrigger_start(void);
+void		do_psitrigger(char *, char *);
 void		do_pacctdir(char *, char *);
 void		do_atopsarflags(char *, char *);
 
+struct taskstats;
 int		netlink_open(void);
 int		netlink_recv(int, int);
+int		netlink_recvstats(int, struct taskstats *, int, int);
+int		netlink_setrcvbuf(int, int);
 
 int		getutsname(struct tstat *);
 void		resetutsname(void);
@@ -24,6 +24,16 @@
 **   any more. As soon as at least one client is activated again, the
 **   atopacctd daemon start writing shadow files again.
 **
+** - Apart from the shadow files, every record is also stored in a
+**   memory-mapped ring buffer of fixed size. Clients that map the ring
+**   buffer keep their own read cursor and do not have to poll the
+**   shadow files (and do not register as user of the shadow files).
+**
+** Alternatively (flag -t) the accounting records are not read from
+** the source file, but they are built from the taskstats messages
+** that the kernel sends via NETLINK for every exiting task. In that case
+** process accounting is not switched on at all.
+**
 ** The directory /run is used as the default top-directory. An
 ** alternative top-directory can be specified as command line argument
 ** (in that case, also modify /etc/atoprc to inform atop as a client).
@@ -59,6 +69,7 @@
 #include <sys/mman.h>
 #include <sys/statvfs.h>
 #include <sys/wait.h>
+#include <linux/taskstats.h>
 
 #include "atop.h"
 #include "photoproc.h"
@@ -75,6 +86,17 @@
 #define POLLSEC		1	// timeout (sec) when NETLINK fails
 
 #define GCINTERVAL      60      // garbage collection interval (seconds)
+#define STATSINTERVAL	10	// statistics file interval (seconds)
+
+#define	NLRCVBUFMIN	(256*1024)	// initial NETLINK receive buffer
+#define	NLRCVBUFMAX	(64*1024*1024)	// maximum NETLINK receive buffer
+
+#define	TSBATCH		64	// taskstats messages per receive call
+#define	TSPENDHASH	256	// hash size for thread groups pending
+
+#ifndef	AGROUP
+#define	AGROUP		0x20	// taskstats: last task of thread group
+#endif
 
 /*
 ** Semaphore-handling
@@ -114,14 +136,70 @@ static char		*pacctdir    = PACCTDIR;
 
 static int		cleanup_and_go = 0;
 
+static struct pacctring	*ring;		// mapped ring buffer
+static char		*ringdata;	// first record slot in ring buffer
+
+static int			arecsize;	// size of accounting record
+static unsigned long long	stotsize;	// size of current shadow file
+static unsigned long long	maxshadowsz;	// maximum size shadow file
+
+/*
+** taskstats mode: accumulated statistics of the threads that exited
+** for thread groups (processes) that are still alive
+*/
+static char		tsmode;		// boolean: taskstats mode
+static long		clktck;		// clock ticks per second
+
+struct tspending {
+	struct tspending	*next;
+	__u32			tgid;
+	struct taskstats	sum;
+};
+
+static struct tspending	*tspending[TSPENDHASH];
+
+/*
+** statistics of the daemon itself, written regularly to the
+** statistics file to verify if the transfer keeps up with the
+** termination rate of processes
+*/
+static struct {
+	time_t			start;		// start time of daemon
+	unsigned long long	records;	// records passed in total
+	unsigned long long	overruns;	// NETLINK overruns in total
+	unsigned long long	shadows;	// shadow files created in total
+	int			rcvbuf;		// NETLINK receive buffer size
+
+	time_t			ivstart;	// start of current interval
+	unsigned long long	ivrecords;	// records passed in interval
+	unsigned long long	ivoverruns;	// overruns in interval
+	unsigned long long	ivlatsum;	// sum latency (usec) interval
+	unsigned long long	ivlatcnt;	// number of latencies interval
+	unsigned long long	ivlatmax;	// max latency (usec) interval
+} acctdstats;
+
 /*
 ** function prototypes
 */
 static int	awaitprocterm(int, int, int, char *, int *,
 				unsigned long *, unsigned long *);
+static int	awaittaskstats(int, int, int *,
+				unsigned long *, unsigned long *);
+static int	passrecords(char *, int, int, int *,
+				unsigned long *, unsigned long *);
+static void	setrecsize(int, int);
+static int	tsexit(struct taskstats *, struct acct_v3 *);
+static void	tsexpire(void);
+static void	tsrecord(struct taskstats *, struct acct_v3 *);
+static comp_t	tscomp(unsigned long long);
+static void	nloverrun(int);
+static void	statlatency(struct timespec *);
+static void	writestats(void);
 static int	swonpacct(int, char *);
 static int	createshadow(long);
 static int	pass2shadow(int, char *, int);
+static int	createring(void);
+static void	pass2ring(char *, int);
 static void	gcshadows(unsigned long *, unsigned long);
 static void	setcurrent(long);
 static int	acctsize(struct acct *);
@@ -141,14 +219,24 @@ main(int argc, char *argv[])
 	struct sembuf		semincr = {0, +1, SEM_UNDO};
 
 	char			shadowdir[128], shadowpath[128];
-	char			accountpath[128];
+	char			accountpath[128], ringpath[128];
 	unsigned long		oldshadow = 0, curshadow = 0;
 	int 			shadowbusy = 0;
-	time_t			gclast = time(0);
+	time_t			gclast = time(0), tslast = gclast;
 
 	struct sigaction	sigcleanup;
 	int			liResult;
 
+	/*
+	** taskstats mode wanted?
+	*/
+	if (argc > 1 && strcmp(argv[1], "-t") == 0)
+	{
+		tsmode = 1;
+		argc--;
+		argv++;
+	}
+
 	/*
 	** argument passed?
 	*/
@@ -168,7 +256,7 @@ main(int argc, char *argv[])
 			else
 			{
 				fprintf(stderr,
-				     	"Usage: atopacctd [-v|topdirectory]\n"
+				     	"Usage: atopacctd [-v|[-t] topdirectory]\n"
 					"Default topdirectory: %s\n", PACCTDIR);
 				exit(1);
 			}
@@ -185,7 +273,7 @@ main(int argc, char *argv[])
 		if (argc != 1)
 		{
 			fprintf(stderr,
-			     	"Usage: atopacctd [-v|topdirectory]\n"
+			     	"Usage: atopacctd [-v|[-t] topdirectory]\n"
 				"Default topdirectory: %s\n", PACCTDIR);
 			exit(1);
 		}
@@ -207,7 +295,7 @@ main(int argc, char *argv[])
 	if ( stat(pacctdir, &dirstat) == -1 )
 	{
 		perror(pacctdir);
-		fprintf(stderr, "Usage: atopacctd [-v|topdirectory]\n"
+		fprintf(stderr, "Usage: atopacctd [-v|[-t] topdirectory]\n"
 				"Default topdirectory: %s\n", PACCTDIR);
 		exit(2);
 	}
@@ -407,6 +495,15 @@ main(int argc, char *argv[])
 	sfd = createshadow(curshadow);
 	setcurrent(curshadow);
 
+	/*
+	** create the ring buffer as alternative for the shadow files
+	*/
+	if ( createring() == -1)
+	{
+		kill(parentpid, SIGTERM);
+		exit(5);
+	}
+
 	/*
 	** open syslog interface 
 	*/
@@ -431,17 +528,36 @@ main(int argc, char *argv[])
 		exit(5);
 	}
 
+	acctdstats.rcvbuf = netlink_setrcvbuf(nfd, NLRCVBUFMIN);
+	acctdstats.start  = acctdstats.ivstart = time(0);
+
+	writestats();
+
 	/*
 	** switch on accounting - inital
+	**
+	** in taskstats mode the layout of the records is known
+	** beforehand and process accounting is not needed
 	*/
-	if ( swonpacct(afd, accountpath) == -1)
+	if (tsmode)
 	{
-		(void) unlink(accountpath);
-		kill(parentpid, SIGTERM);
-		exit(6);
+		clktck = sysconf(_SC_CLK_TCK);
+
+		setrecsize(sizeof(struct acct_v3), 3);
+
+		syslog(LOG_INFO, "accounting via taskstats");
 	}
+	else
+	{
+		if ( swonpacct(afd, accountpath) == -1)
+		{
+			(void) unlink(accountpath);
+			kill(parentpid, SIGTERM);
+			exit(6);
+		}
 
-	syslog(LOG_INFO, "accounting to %s", accountpath);
+		syslog(LOG_INFO, "accounting to %s", accountpath);
+	}
 
 	/*
 	** signal handling
@@ -478,7 +594,11 @@ main(int argc, char *argv[])
 		** await termination of (at least) one process and
 		** copy the process accounting record(s)
 		*/
-		state = awaitprocterm(nfd, afd, sfd, accountpath,
+		if (tsmode)
+			state = awaittaskstats(nfd, sfd,
+					&shadowbusy, &oldshadow, &curshadow);
+		else
+			state = awaitprocterm(nfd, afd, sfd, accountpath,
 					&shadowbusy, &oldshadow, &curshadow);
 
 		if (state == -1)	// irrecoverable error?
@@ -501,12 +621,33 @@ main(int argc, char *argv[])
 			gcshadows(&oldshadow, curshadow);
 			gclast = time(0);
 		}
+
+		/*
+		** regularly remove the thread groups of which the
+		** final message has been lost (overrun)
+		*/
+		if ( tsmode &&
+			(time(&curtime) > tslast + GCINTERVAL ||
+		               curtime  < tslast                ) )
+		{
+			tsexpire();
+			tslast = time(0);
+		}
+
+		/*
+		** refresh the statistics file
+		*/
+		if (time(&curtime) >= acctdstats.ivstart + STATSINTERVAL ||
+		                curtime  <  acctdstats.ivstart                )
+			writestats();
 	}
 
 	/*
 	** cleanup and terminate
 	*/
-	(void) acct((char *) 0);	// disable process accounting
+	if (!tsmode)
+		(void) acct((char *) 0);	// disable process accounting
+
 	(void) unlink(accountpath);	// remove source file
 
 	for (; oldshadow <= curshadow; oldshadow++)	// remove shadow files
@@ -526,6 +667,14 @@ main(int argc, char *argv[])
 	(void) unlink(shadowpath);	// remove file 'current'
 	(void) rmdir(shadowdir);	// remove shadow.d directory
 
+	snprintf(ringpath, sizeof ringpath, "%s/%s", pacctdir, PACCTRING);
+
+	(void) unlink(ringpath);	// remove ring buffer
+
+	snprintf(ringpath, sizeof ringpath, "%s/%s", pacctdir, PACCTSTATS);
+
+	(void) unlink(ringpath);	// remove statistics file
+
 	if (cleanup_and_go)
 	{
 		syslog(LOG_NOTICE, "Terminated by signal %d\n", cleanup_and_go);
@@ -556,14 +705,14 @@ static int
 awaitprocterm(int nfd, int afd, int sfd, char *accountpath,
 	int *shadowbusyp, unsigned long *oldshadowp, unsigned long *curshadowp)
 {
-	static int			arecsize, netlinkactive = 1;
-	static unsigned long long	atotsize, stotsize, maxshadowsz;
+	static int			netlinkactive = 1;
+	static unsigned long long	atotsize;
 	static time_t			reclast;
 	struct timespec			retrytimer = {0, RETRYMS/2*1000000};
 	int				retrycount = RETRYCNT;
-	int				asz, rv, ssz;
+	int				asz, rv, arecvers;
 	char				abuf[16000];
-	int				partsz, remsz;
+	struct timespec			tstart;
 
 	/*
 	** neutral state:
@@ -601,9 +750,12 @@ awaitprocterm(int nfd, int afd, int sfd, char *accountpath,
 			{
 		   	   // acceptable errors that might indicate that
 		   	   // processes have terminated
+		   	   case ENOBUFS:
+				nloverrun(nfd);
+				break;
+
 		   	   case EINTR:
 		   	   case ENOMEM:
-		   	   case ENOBUFS:
 				break;
 	
 		   	   default:
@@ -645,6 +797,8 @@ awaitprocterm(int nfd, int afd, int sfd, char *accountpath,
 		retrycount = 1;
 	}
 
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+
 	/*
  	** read new process accounting record(s)
 	** such record(s) may not immediately be available (timing matter),
@@ -689,11 +843,10 @@ awaitprocterm(int nfd, int afd, int sfd, char *accountpath,
 	*/
 	if (!arecsize)
 	{
-		arecsize = acctsize((struct acct *)abuf);
-
-		if (arecsize)
+		if ( (rv = acctsize((struct acct *)abuf)) )
 		{
-			maxshadowsz = maxshadowrec * arecsize;
+			arecvers = ((struct acct *)abuf)->ac_version & 0x0f;
+			setrecsize(rv, arecvers);
 		}
 		else
 		{
@@ -703,6 +856,17 @@ awaitprocterm(int nfd, int afd, int sfd, char *accountpath,
 		}
 	}
 
+	/*
+	** a partially written record is read again next time
+	*/
+	if (asz % arecsize)
+	{
+		(void) lseek(afd, -(asz % arecsize), SEEK_CUR);
+
+		if ( (asz -= asz % arecsize) == 0)
+			return 0;
+	}
+
 	/*
  	** truncate process accounting file regularly
 	*/
@@ -717,6 +881,397 @@ awaitprocterm(int nfd, int afd, int sfd, char *accountpath,
 		}
 	}
 
+	rv = passrecords(abuf, asz, sfd, shadowbusyp, oldshadowp, curshadowp);
+
+	statlatency(&tstart);
+
+	return rv;
+}
+
+/*
+** wait for at least one task termination, build process accounting
+** records from the taskstats messages and pass them
+**
+** return code:	0 - no process accounting record built
+**              1 - at least one process accounting record built
+**             -1 - irrecoverable failure
+*/
+static int
+awaittaskstats(int nfd, int sfd,
+	int *shadowbusyp, unsigned long *oldshadowp, unsigned long *curshadowp)
+{
+	static struct taskstats	tsbuf[TSBATCH];
+	static struct acct_v3	recbuf[TSBATCH];
+	struct timespec		tstart;
+	int			ntasks, nrecs, i, rv;
+
+	if ( (ntasks = netlink_recvstats(nfd, tsbuf, TSBATCH, 0)) < 0)
+	{
+		switch (-ntasks)
+		{
+		   // acceptable errors (messages have been lost)
+		   case ENOBUFS:
+			nloverrun(nfd);
+			return 0;
+
+		   case EINTR:
+		   case ENOMEM:
+			return 0;
+
+		   default:
+			syslog(LOG_ERR, "unexpected error on NETLINK: %s\n",
+							strerror(-ntasks));
+			return -1;
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+
+	for (i=0, nrecs=0; i < ntasks; i++)
+	{
+		if ( tsexit(&tsbuf[i], &recbuf[nrecs]) )
+			nrecs++;
+	}
+
+	if (nrecs == 0)
+		return 0;
+
+	rv = passrecords((char *)recbuf, nrecs * sizeof(struct acct_v3),
+				sfd, shadowbusyp, oldshadowp, curshadowp);
+
+	statlatency(&tstart);
+
+	return rv;
+}
+
+/*
+** overrun of the NETLINK receive buffer: messages have been dropped
+** by the kernel, so enlarge the receive buffer (if possible)
+*/
+static void
+nloverrun(int nfd)
+{
+	int	newsz;
+
+	acctdstats.overruns++;
+	acctdstats.ivoverruns++;
+
+	if (acctdstats.rcvbuf <= 0 || acctdstats.rcvbuf >= NLRCVBUFMAX)
+		return;
+
+	/*
+	** the kernel reports the doubled value of the requested size
+	** (administration overhead)
+	*/
+	newsz = netlink_setrcvbuf(nfd, acctdstats.rcvbuf);
+
+	if (newsz > acctdstats.rcvbuf)
+	{
+		syslog(LOG_NOTICE, "NETLINK receive buffer enlarged to %d "
+		                   "bytes after overrun\n", newsz);
+		acctdstats.rcvbuf = newsz;
+	}
+	else
+	{
+		acctdstats.rcvbuf = NLRCVBUFMAX;	// no further trials
+	}
+}
+
+/*
+** register the latency between the notification of a process
+** termination and the moment that the records have been passed
+*/
+static void
+statlatency(struct timespec *tstart)
+{
+	struct timespec		tend;
+	unsigned long long	lat;
+
+	clock_gettime(CLOCK_MONOTONIC, &tend);
+
+	lat = (tend.tv_sec  - tstart->tv_sec)  * 1000000LL +
+	      (tend.tv_nsec - tstart->tv_nsec) / 1000;
+
+	acctdstats.ivlatsum += lat;
+	acctdstats.ivlatcnt++;
+
+	if (acctdstats.ivlatmax < lat)
+		acctdstats.ivlatmax = lat;
+}
+
+/*
+** write the statistics file (replaced as a whole) and
+** start a new interval
+*/
+static void
+writestats(void)
+{
+	char	statspath[128], tmppath[160];
+	time_t	now = time(0);
+	long	ivsecs = now > acctdstats.ivstart ? now - acctdstats.ivstart : 1;
+	FILE	*fp;
+
+	snprintf(statspath, sizeof statspath, "%s/%s", pacctdir, PACCTSTATS);
+	snprintf(tmppath,   sizeof tmppath,   "%s.tmp", statspath);
+
+	if ( (fp = fopen(tmppath, "w")) )
+	{
+		fprintf(fp, "mode            %s\n",
+					tsmode ? "taskstats" : "accounting");
+		fprintf(fp, "uptime          %ld\n", now - acctdstats.start);
+		fprintf(fp, "records         %llu\n", acctdstats.records);
+		fprintf(fp, "overruns        %llu\n", acctdstats.overruns);
+		fprintf(fp, "shadowfiles     %llu\n", acctdstats.shadows);
+		fprintf(fp, "rcvbuf          %d\n",   acctdstats.rcvbuf);
+		fprintf(fp, "interval        %ld\n",  ivsecs);
+		fprintf(fp, "recordrate      %.1f\n",
+				(double)acctdstats.ivrecords / ivsecs);
+		fprintf(fp, "intoverruns     %llu\n", acctdstats.ivoverruns);
+		fprintf(fp, "latencyavg      %llu\n", acctdstats.ivlatcnt ?
+				acctdstats.ivlatsum / acctdstats.ivlatcnt : 0);
+		fprintf(fp, "latencymax      %llu\n", acctdstats.ivlatmax);
+
+		if (fclose(fp) == 0)
+			(void) rename(tmppath, statspath);
+		else
+			(void) unlink(tmppath);
+	}
+
+	if (acctdstats.ivoverruns)
+		syslog(LOG_WARNING, "%llu NETLINK overruns during last %ld "
+		                    "seconds\n", acctdstats.ivoverruns, ivsecs);
+
+	acctdstats.ivstart    = now;
+	acctdstats.ivrecords  = 0;
+	acctdstats.ivoverruns = 0;
+	acctdstats.ivlatsum   = 0;
+	acctdstats.ivlatcnt   = 0;
+	acctdstats.ivlatmax   = 0;
+}
+
+/*
+** handle the taskstats of one exited task
+**
+** the statistics of a thread are accumulated in the pending
+** administration of its thread group until the last thread of
+** the group exits (flagged by the kernel as AGROUP, since
+** taskstats version 12); without this flag every task is
+** considered to be a process
+**
+** return value: 1 - process accounting record built in 'rec'
+**               0 - no process finished yet
+*/
+static int
+tsexit(struct taskstats *ts, struct acct_v3 *rec)
+{
+	struct tspending	*tp, **tpp;
+	__u32			tgid = 0;
+	int			groupend = 1;
+
+#if	TASKSTATS_VERSION >= 12
+	if (ts->version >= 12)
+	{
+		tgid     = ts->ac_tgid;
+		groupend = ts->ac_flag & AGROUP;
+	}
+#endif
+
+	if (!tgid)
+	{
+		tsrecord(ts, rec);
+		return 1;
+	}
+
+	for (tpp = &tspending[tgid % TSPENDHASH]; (tp = *tpp); tpp = &tp->next)
+	{
+		if (tp->tgid == tgid)
+			break;
+	}
+
+	if (!tp)
+	{
+		if (groupend)		// single-threaded process
+		{
+			ts->ac_pid = tgid;
+			tsrecord(ts, rec);
+			return 1;
+		}
+
+		if ( (tp = malloc(sizeof *tp)) == NULL)
+		{
+			syslog(LOG_ERR, "malloc failed for thread group\n");
+			return 0;
+		}
+
+		tp->next = NULL;
+		tp->tgid = tgid;
+		tp->sum  = *ts;
+
+		*tpp = tp;
+	}
+	else
+	{
+		/*
+		** accumulate the counters of this thread; the
+		** identity of the process is taken from the leader
+		*/
+		tp->sum.ac_utime  += ts->ac_utime;
+		tp->sum.ac_stime  += ts->ac_stime;
+		tp->sum.ac_minflt += ts->ac_minflt;
+		tp->sum.ac_majflt += ts->ac_majflt;
+
+		if (tp->sum.hiwater_vm < ts->hiwater_vm)
+			tp->sum.hiwater_vm = ts->hiwater_vm;
+
+		if (ts->ac_pid == tgid)
+		{
+			tp->sum.ac_flag     = ts->ac_flag;
+			tp->sum.ac_exitcode = ts->ac_exitcode;
+			tp->sum.ac_uid      = ts->ac_uid;
+			tp->sum.ac_gid      = ts->ac_gid;
+			tp->sum.ac_ppid     = ts->ac_ppid;
+			tp->sum.ac_btime    = ts->ac_btime;
+			tp->sum.ac_etime    = ts->ac_etime;
+
+			memcpy(tp->sum.ac_comm, ts->ac_comm, sizeof ts->ac_comm);
+		}
+	}
+
+	if (!groupend)
+		return 0;
+
+	/*
+	** last thread of the group: process finished
+	*/
+	tp->sum.ac_pid = tgid;
+
+#if	TASKSTATS_VERSION >= 12
+	if (ts->ac_tgetime)		// walltime of thread group
+		tp->sum.ac_etime = ts->ac_tgetime;
+#endif
+
+	tsrecord(&tp->sum, rec);
+
+	*tpp = tp->next;
+	free(tp);
+
+	return 1;
+}
+
+/*
+** remove the accumulated statistics of thread groups that do not
+** exist any more: the message of the last thread (AGROUP flag) has
+** been lost due to an overrun of the NETLINK receive buffer, so
+** otherwise these entries would never be freed
+*/
+static void
+tsexpire(void)
+{
+	struct tspending	*tp, **tpp;
+	int			i;
+
+	for (i=0; i < TSPENDHASH; i++)
+	{
+		for (tpp = &tspending[i]; (tp = *tpp); )
+		{
+			if (kill(tp->tgid, 0) == -1 && errno == ESRCH)
+			{
+				*tpp = tp->next;
+				free(tp);
+			}
+			else
+			{
+				tpp = &tp->next;
+			}
+		}
+	}
+}
+
+/*
+** convert taskstats into a process accounting record (version 3)
+*/
+static void
+tsrecord(struct taskstats *ts, struct acct_v3 *rec)
+{
+	memset(rec, 0, sizeof *rec);
+
+	rec->ac_flag     = ts->ac_flag & ~AGROUP;
+	rec->ac_version  = 3;
+	rec->ac_exitcode = ts->ac_exitcode;
+	rec->ac_uid      = ts->ac_uid;
+	rec->ac_gid      = ts->ac_gid;
+	rec->ac_pid      = ts->ac_pid;
+	rec->ac_ppid     = ts->ac_ppid;
+	rec->ac_btime    = ts->ac_btime;
+	rec->ac_etime    = (float)ts->ac_etime * clktck / 1000000;
+	rec->ac_utime    = tscomp(ts->ac_utime * clktck / 1000000);
+	rec->ac_stime    = tscomp(ts->ac_stime * clktck / 1000000);
+	rec->ac_mem      = tscomp(ts->hiwater_vm);
+	rec->ac_minflt   = tscomp(ts->ac_minflt);
+	rec->ac_majflt   = tscomp(ts->ac_majflt);
+
+	memcpy(rec->ac_comm, ts->ac_comm, sizeof rec->ac_comm - 1);
+}
+
+/*
+** encode a value in the comp_t format of process accounting
+** (13 bits mantissa and 3 bits base-8 exponent)
+*/
+static comp_t
+tscomp(unsigned long long value)
+{
+	int	exp = 0;
+
+	while (value > 0x1fff)
+	{
+		value >>= 3;
+
+		if (++exp > 7)
+			return 0xffff;
+	}
+
+	return (exp << 13) | value;
+}
+
+/*
+** determine the layout of the process accounting records:
+** calculate the maximum size for each shadow file and publish
+** the layout in the ring buffer (the record size last, because
+** clients wait for it)
+*/
+static void
+setrecsize(int recsize, int version)
+{
+	arecsize    = recsize;
+	maxshadowsz = maxshadowrec * recsize;
+
+	ring->version = version;
+	ring->nrecs   = RINGDATASZ / recsize;
+
+	__atomic_store_n(&ring->recsize, recsize, __ATOMIC_RELEASE);
+}
+
+/*
+** pass process accounting records to the ring buffer and
+** (if clients are using them) to the shadow files
+**
+** return code:	1 - records passed
+*/
+static int
+passrecords(char *abuf, int asz, int sfd,
+	int *shadowbusyp, unsigned long *oldshadowp, unsigned long *curshadowp)
+{
+	int	ssz, partsz, remsz;
+
+	acctdstats.records   += asz / arecsize;
+	acctdstats.ivrecords += asz / arecsize;
+
+	/*
+	** store the records in the ring buffer (no matter
+	** if any client is using it)
+	*/
+	pass2ring(abuf, asz);
+
 	/*
  	** determine if any client is using the shadow
 	** accounting files; if not, verify if clients
@@ -842,6 +1397,8 @@ createshadow(long seq)
 		exit(5);
 	}
 
+	acctdstats.shadows++;
+
 	return sfd;
 }
 
@@ -901,6 +1458,70 @@ pass2shadow(int sfd, char *sbuf, int ssz)
 }
 
 
+/*
+** create the ring buffer file and map it
+**
+** return value: 0 (success) or -1 (failure)
+*/
+static int
+createring(void)
+{
+	int	rfd;
+	char	ringpath[128];
+
+	snprintf(ringpath, sizeof ringpath, "%s/%s", pacctdir, PACCTRING);
+
+	(void) unlink(ringpath);	// in case atopacctd previously killed
+
+	if ( (rfd = open(ringpath, O_RDWR|O_CREAT|O_EXCL, 0644)) == -1)
+	{
+		perror(ringpath);
+		return -1;
+	}
+
+	if ( ftruncate(rfd, RINGHDRSZ + RINGDATASZ) == -1)
+	{
+		perror(ringpath);
+		(void) close(rfd);
+		(void) unlink(ringpath);
+		return -1;
+	}
+
+	ring = mmap(NULL, RINGHDRSZ + RINGDATASZ, PROT_READ|PROT_WRITE,
+							MAP_SHARED, rfd, 0);
+
+	(void) close(rfd);	// mapping remains
+
+	if (ring == MAP_FAILED)
+	{
+		perror("mmap ring buffer");
+		(void) unlink(ringpath);
+		return -1;
+	}
+
+	ringdata = (char *)ring + RINGHDRSZ;
+
+	__atomic_store_n(&ring->magic, RINGMAGIC, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+/*
+** transfer complete process accounting records to the ring buffer
+** and publish them by incrementing the head afterwards
+*/
+static void
+pass2ring(char *rbuf, int rsz)
+{
+	unsigned long long	head = ring->head;
+	int			recsize = ring->recsize;
+
+	for (; rsz >= recsize; rsz -= recsize, rbuf += recsize, head++)
+		memcpy(ringdata + (head % ring->nrecs) * recsize, rbuf, recsize);
+
+	__atomic_store_n(&ring->head, head, __ATOMIC_RELEASE);
+}
+
 /*
 ** switch on the process accounting mechanism
 **   first parameter:	file descriptor of open accounting file
@@ -65,4 +65,35 @@
 
 #define MAXSHADOWREC	10000 	// number of accounting records per shadow file
 
+/*
+** statistics of atopacctd (rewritten regularly)
+*/
+#define PACCTSTATS	"pacct_stats"		// file name in PACCTDIR
+
+/*
+** memory-mapped ring buffer (alternative for the shadow files)
+**
+** atopacctd is the only writer: every accounting record is stored
+** in slot (head % nrecs) after which head is incremented.
+** Every client (atop) keeps its own read cursor, i.e. the number of
+** records consumed so far. When a client lags more than nrecs records
+** behind head, the oldest records have been overwritten and are lost
+** for that client.
+*/
+#define PACCTRING	"pacct_ring"		// file name in PACCTDIR
+
+#define RINGMAGIC	0xa7ac0001
+#define RINGHDRSZ	4096			// header size (first page)
+#define RINGDATASZ	(16*1024*1024)		// data size (records)
+
+struct pacctring {
+	unsigned int		magic;
+	unsigned short		recsize;	// size of accounting record
+						// (0 = not yet known)
+	unsigned char		version;	// version of accounting record
+	unsigned char		ifuture;
+	unsigned long		nrecs;		// number of record slots
+	unsigned long long	head;		// total records written
+};
+
 #endif
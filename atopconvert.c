@@ -150,6 +150,20 @@ void	scpu_to_213(void *, void *, count_t, count_t);
 void	smem_to_213(void *, void *, count_t, count_t);
 void	sifb_to_213(void *, void *, count_t, count_t);
 
+void	scpu_to_214(void *, void *, count_t, count_t);
+void	sint_to_214(void *, void *, count_t, count_t);
+void	sdsk_to_214(void *, void *, count_t, count_t);
+void	snfs_to_214(void *, void *, count_t, count_t);
+void	scfs_to_214(void *, void *, count_t, count_t);
+void	smnu_to_214(void *, void *, count_t, count_t);
+void	scnu_to_214(void *, void *, count_t, count_t);
+
+void	cggen_to_214(void *, void *, count_t, count_t);
+void	cgconf_to_214(void *, void *, count_t, count_t);
+void	cgcpu_to_214(void *, void *, count_t, count_t);
+void	cgmem_to_214(void *, void *, count_t, count_t);
+void	cgdsk_to_214(void *, void *, count_t, count_t);
+
 
 ///////////////////////////////////////////////////////////////
 // Conversion functions
@@ -831,6 +845,176 @@ sifb_to_213(void *old, void *new, count_t oldsize, count_t newsize)
 	}
 }
 
+// From version 2.14 the per-entity arrays in the sstat structure
+// are dynamically allocated: only the entries in use are stored
+// in the raw log, behind the fixed part of the sstat structure.
+// The following conversion functions copy the fixed part and
+// let the array pointer refer to the array of the old structure
+// (packed into the output sample by writesamp).
+//
+void
+scpu_to_214(void *old, void *new, count_t oldsize, count_t newsize)
+{
+	struct cpustat_213	*c213 = old;
+	struct cpustat		*c214 = new;
+
+	memcpy(c214, c213, offsetof(struct cpustat, cpu));
+
+	c214->cpu = (struct percpu *)c213->cpu;
+}
+
+void
+sint_to_214(void *old, void *new, count_t oldsize, count_t newsize)
+{
+	struct intfstat_213	*i213 = old;
+	struct intfstat		*i214 = new;
+
+	i214->nrintf = i213->nrintf;
+	i214->intf   = (struct perintf *)i213->intf;
+}
+
+void
+sdsk_to_214(void *old, void *new, count_t oldsize, count_t newsize)
+{
+	struct dskstat_213	*d213 = old;
+	struct dskstat		*d214 = new;
+
+	d214->ndsk = d213->ndsk;
+	d214->nmdd = d213->nmdd;
+	d214->nlvm = d213->nlvm;
+
+	d214->dsk  = (struct perdsk *)d213->dsk;
+	d214->mdd  = (struct perdsk *)d213->mdd;
+	d214->lvm  = (struct perdsk *)d213->lvm;
+}
+
+void
+snfs_to_214(void *old, void *new, count_t oldsize, count_t newsize)
+{
+	struct nfsstat_213	*n213 = old;
+	struct nfsstat		*n214 = new;
+
+	memcpy(&(n214->client), &(n213->client), sizeof n214->client);
+
+	n214->nfsmounts.nrmounts = n213->nfsmounts.nrmounts;
+	n214->nfsmounts.nfsmnt   = (struct pernfsmount *)n213->nfsmounts.nfsmnt;
+}
+
+void
+scfs_to_214(void *old, void *new, count_t oldsize, count_t newsize)
+{
+	struct contstat_213	*c213 = old;
+	struct contstat		*c214 = new;
+
+	c214->nrcontainer = c213->nrcontainer;
+	c214->cont        = (struct percontainer *)c213->cont;
+}
+
+void
+smnu_to_214(void *old, void *new, count_t oldsize, count_t newsize)
+{
+	struct memnuma_213	*n213 = old;
+	struct memnuma		*n214 = new;
+
+	n214->nrnuma = n213->nrnuma;
+	n214->numa   = (struct mempernuma *)n213->numa;
+}
+
+void
+scnu_to_214(void *old, void *new, count_t oldsize, count_t newsize)
+{
+	struct cpunuma_213	*n213 = old;
+	struct cpunuma		*n214 = new;
+
+	n214->nrnuma = n213->nrnuma;
+	n214->numa   = (struct cpupernuma *)n213->numa;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Specific functions that convert an old cstat sub-structure to
+// a new sub-structure (cgroup level)
+// /////////////////////////////////////////////////////////////////
+void
+cggen_to_214(void *old, void *new, count_t oldsize, count_t newsize)
+{
+	struct cggen		*g214 = new;
+
+	justcopy(old, new, oldsize, newsize);
+
+	g214->nrtasks	= -1;	// undefined
+}
+
+void
+cgconf_to_214(void *old, void *new, count_t oldsize, count_t newsize)
+{
+	struct cgconf		*c214 = new;
+
+	justcopy(old, new, oldsize, newsize);
+
+	c214->pidsmax	= -2;	// undefined
+}
+
+void
+cgcpu_to_214(void *old, void *new, count_t oldsize, count_t newsize)
+{
+	struct cgcpu_213	*c213 = old;
+	struct cgcpu		*c214 = new;
+
+	c214->utime	= c213->utime;
+	c214->stime	= c213->stime;
+	c214->somepres	= c213->somepres;
+	c214->fullpres	= c213->fullpres;
+
+	// new counters undefined
+	//
+	c214->nrthrottled = -1;
+	c214->thrtime	  = -1;
+}
+
+void
+cgmem_to_214(void *old, void *new, count_t oldsize, count_t newsize)
+{
+	struct cgmem_213	*m213 = old;
+	struct cgmem		*m214 = new;
+
+	m214->current	= m213->current;
+	m214->anon	= m213->anon;
+	m214->file	= m213->file;
+	m214->kernel	= m213->kernel;
+	m214->shmem	= m213->shmem;
+	m214->somepres	= m213->somepres;
+	m214->fullpres	= m213->fullpres;
+
+	// new counters undefined
+	//
+	m214->pgmajflt	= -1;
+	m214->wsrefault	= -1;
+	m214->actfile	= -1;
+	m214->inactfile	= -1;
+	m214->slab	= -1;
+	m214->sock	= -1;
+	m214->evhigh	= -1;
+	m214->evmax	= -1;
+	m214->evoom	= -1;
+	m214->evoomkill	= -1;
+}
+
+void
+cgdsk_to_214(void *old, void *new, count_t oldsize, count_t newsize)
+{
+	struct cgdsk_213	*d213 = old;
+	struct cgdsk		*d214 = new;
+
+	d214->rbytes	= d213->rbytes;
+	d214->wbytes	= d213->wbytes;
+	d214->rios	= d213->rios;
+	d214->wios	= d213->wios;
+	d214->somepres	= d213->somepres;
+	d214->fullpres	= d213->fullpres;
+
+	d214->ndisks	= 0;	// no I/O per disk
+}
+
 
 ///////////////////////////////////////////////////////////////
 // conversion definition for various structs in sstat and tstat
@@ -1511,6 +1695,51 @@ struct convertall {
 		{sizeof(struct cgdsk_213),
 	              offsetof(struct cstat_213, dsk),   justcopy},
 	},
+
+	{SETVERSION(2,14), // 2.13 --> 2.14
+		 sizeof(struct sstat),		&sstat,
+		 sizeof(struct tstat), 		NULL,
+		 sizeof(struct cstat),		&cstat,		NULL,
+
+		{sizeof(struct cpustat),  	&sstat.cpu,	   scpu_to_214},
+		{sizeof(struct memstat),  	&sstat.mem,	   justcopy},
+		{sizeof(struct netstat),  	&sstat.net,	   justcopy},
+		{sizeof(struct intfstat), 	&sstat.intf,	   sint_to_214},
+		{sizeof(struct dskstat),  	&sstat.dsk,	   sdsk_to_214},
+		{sizeof(struct nfsstat),  	&sstat.nfs,	   snfs_to_214},
+		{sizeof(struct contstat), 	&sstat.cfs,	   scfs_to_214},
+		{sizeof(struct wwwstat),  	&sstat.www,	   justcopy},
+		{sizeof(struct pressure),  	&sstat.psi,	   justcopy},
+		{sizeof(struct gpustat),  	&sstat.gpu,	   justcopy},
+		{sizeof(struct ifbstat),  	&sstat.ifb,	   justcopy},
+		{sizeof(struct memnuma), 	&sstat.memnuma,	   smnu_to_214},
+		{sizeof(struct cpunuma),  	&sstat.cpunuma,	   scnu_to_214},
+		{sizeof(struct llcstat),  	&sstat.llc,	   justcopy},
+
+		{sizeof(struct gen),
+			offsetof(struct tstat, gen),	justcopy},
+		{sizeof(struct cpu),
+			offsetof(struct tstat, cpu),	justcopy},
+		{sizeof(struct dsk),
+			offsetof(struct tstat, dsk),	justcopy},
+		{sizeof(struct mem),
+			offsetof(struct tstat, mem),	justcopy},
+		{sizeof(struct net),
+			offsetof(struct tstat, net),	justcopy},
+		{sizeof(struct gpu),
+			offsetof(struct tstat, gpu),	justcopy},
+
+		{sizeof(struct cggen),
+		      offsetof(struct cstat, gen),   cggen_to_214},
+		{sizeof(struct cgconf),
+		      offsetof(struct cstat, conf),  cgconf_to_214},
+		{sizeof(struct cgcpu),
+	              offsetof(struct cstat, cpu),   cgcpu_to_214},
+		{sizeof(struct cgmem),
+	              offsetof(struct cstat, mem),   cgmem_to_214},
+		{sizeof(struct cgdsk),
+	              offsetof(struct cstat, dsk),   cgdsk_to_214},
+	},
 };
 
 int	numconvs = sizeof convs / sizeof(struct convertall);
@@ -1762,6 +1991,8 @@ convert_samples(int ifd, int ofd, struct rawheader *irh, int ivix, int ovix, int
 	int			i, t, c, ctotlen;
 	count_t			count = 0;
 	pid_t			*cgpidlist = NULL;
+	void			*sstatbuf;
+	unsigned long		sstatlen;
 
 	while ( read(ifd, &irr, irh->rawreclen) == irh->rawreclen)
 	{
@@ -1833,6 +2064,7 @@ convert_samples(int ifd, int ofd, struct rawheader *irh, int ivix, int ovix, int
 			do_sconvert(&(convs[i].sifb),   &(convs[i+1].sifb));
 			do_sconvert(&(convs[i].smnum),  &(convs[i+1].smnum));
 			do_sconvert(&(convs[i].scnum),  &(convs[i+1].scnum));
+			do_sconvert(&(convs[i].sllc),   &(convs[i+1].sllc));
 			do_sconvert(&(convs[i].swww),   &(convs[i+1].swww));
 
 			// convert process-level statistics to newer version
@@ -1986,15 +2218,38 @@ convert_samples(int ifd, int ofd, struct rawheader *irh, int ivix, int ovix, int
 			}
 		}
 
-		// write new sample to output file
+		// prepare target sstat before writing: from version 2.14
+		// the fixed part is followed by the arrays in use
 		//
 		orr = irr;
 
-		writesamp(ofd, &orr, convs[ovix].sstat, convs[ovix].sstatlen,
+		if (convs[ovix].version >= SETVERSION(2,14))
+		{
+			sstatlen = sstat_packlen(convs[ovix].sstat);
+			sstatbuf = malloc(sstatlen);
+
+			ptrverify(sstatbuf, "Malloc failed for packed sstat\n");
+
+			sstat_pack(convs[ovix].sstat, sstatbuf);
+
+			orr.soriglen = sstatlen;
+		}
+		else
+		{
+			sstatlen = convs[ovix].sstatlen;
+			sstatbuf = convs[ovix].sstat;
+		}
+
+		// write new sample to output file
+		//
+		writesamp(ofd, &orr, sstatbuf,          sstatlen,
 		                     convs[ovix].tstat, convs[ovix].tstatlen,
 		                     convs[ovix].cstat, ctotlen,
 				     cgpidlist, cgroupsv2);
 
+		if (sstatbuf != convs[ovix].sstat)
+			free(sstatbuf);			// cleanup packed sstat
+
 		free(convs[ovix].tstat);		// cleanup target tstats
 
 		if (cgroupsv2)
@@ -2333,7 +2588,7 @@ writesamp(int ofd, struct rawrecord *rr,
 	 pid_t *cgpidlist,	int cgroupsv2)
 {
 	int			rv;
-	Byte			scompbuf[sstatlen], *pcompbuf, *ccompbuf;
+	Byte			scompbuf[compressBound(sstatlen)], *pcompbuf, *ccompbuf;
 	unsigned long		scomplen = sizeof scompbuf;
 	unsigned long		pcomplen = tstatlen * rr->ndeviat;
 	unsigned long		ccomplen = cstattotlen;
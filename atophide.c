@@ -79,7 +79,7 @@ static void	writeout(int, void *, int);
 static void	writesamp(int, struct rawrecord *,
 			void *, int, void *, int, int,
 			void *, int, void *, int);
-static int	getrawsstat(int, struct sstat *, int);
+static int	getrawsstat(int, struct sstat *, int, unsigned int);
 static int	getrawtstat(int, struct tstat *, int, int);
 
 static void	testcompval(int, char *);
@@ -138,10 +138,11 @@ main(int argc, char *argv[])
 	struct rawheader	rh;
 	struct rawrecord        rr;
 
-	struct sstat		sstat;
+	static struct sstat	sstat;
 	struct tstat		*tstatp;
 	struct cstat		*cstatp;
-	char			*istatp;
+	char			*istatp, *sstatp;
+	unsigned long		sstatlen;
 
 	int			ifd, ofd=0, writecnt = 0, anonflag = 0;
 	int			i, c, numallowedcoms = sizeof allowedcoms/sizeof(char *);
@@ -279,7 +280,7 @@ main(int argc, char *argv[])
 
                 // read compressed system-level statistics and decompress
                 //
-                if ( !getrawsstat(ifd, &sstat, rr.scomplen) )
+                if ( !getrawsstat(ifd, &sstat, rr.scomplen, rr.soriglen) )
                         exit(7);
 
                 // read compressed process-level statistics and decompress
@@ -313,16 +314,28 @@ main(int argc, char *argv[])
 		if (anonflag)
 			anonymize(&sstat, tstatp, rr.ndeviat);
 
+		// pack system-level stats again
+		//
+		sstatlen = sstat_packlen(&sstat);
+		sstatp   = malloc(sstatlen);
+
+                ptrverify(sstatp, "Malloc failed for packed system stats\n");
+
+		sstat_pack(&sstat, sstatp);
+
+		rr.soriglen = sstatlen;
+
 		// write record header, system-level stats, process-level stats,
 		// cgroup-level stats and pidlist
 		//
-		writesamp(ofd, &rr, &sstat, sizeof sstat,
+		writesamp(ofd, &rr, sstatp, sstatlen,
 		                    tstatp, sizeof *tstatp, rr.ndeviat,
 				    cstatp, rr.ccomplen,
 				    istatp, rr.icomplen);
 
                 // cleanup
                 // 
+                free(sstatp);
                 free(tstatp);
                 free(cstatp);
                 free(istatp);
@@ -581,30 +594,45 @@ prusage(char *name)
 // Function to read the system-level statistics from the current offset
 //
 static int
-getrawsstat(int rawfd, struct sstat *sp, int complen)
+getrawsstat(int rawfd, struct sstat *sp, int complen, unsigned int origlen)
 {
-	Byte		*compbuf;
-	unsigned long	uncomplen = sizeof(struct sstat);
+	Byte		*compbuf, *origbuf;
+	unsigned long	uncomplen = origlen;
 	int		rv;
 
 	compbuf = malloc(complen);
+	origbuf = malloc(origlen);
 
 	ptrverify(compbuf, "Malloc failed for reading compressed sysstats\n");
+	ptrverify(origbuf, "Malloc failed for reading packed sysstats\n");
 
 	if ( read(rawfd, compbuf, complen) < complen)
 	{
 		free(compbuf);
+		free(origbuf);
 		fprintf(stderr,
 			"Failed to read %d bytes for system\n", complen);
 		return 0;
 	}
 
-	rv = uncompress((Byte *)sp, &uncomplen, compbuf, complen);
+	rv = uncompress(origbuf, &uncomplen, compbuf, complen);
 
 	testcompval(rv, "uncompress");
 
 	free(compbuf);
 
+	// unpack into the fixed part and the dynamic arrays
+	//
+	rv = sstat_unpack(sp, origbuf, uncomplen);
+
+	free(origbuf);
+
+	if (!rv)
+	{
+		fprintf(stderr, "Inconsistent system-level stats\n");
+		return 0;
+	}
+
 	return 1;
 }
 
@@ -650,7 +678,7 @@ writesamp(int ofd, struct rawrecord *rr,
 	 void *istat, int istatlen)
 {
 	int			rv;
-	Byte			scompbuf[sstatlen], *pcompbuf;
+	Byte			scompbuf[compressBound(sstatlen)], *pcompbuf;
 	unsigned long		scomplen = sizeof scompbuf;
 	unsigned long		pcomplen = tstatlen * ntask;
 
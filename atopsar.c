@@ -793,7 +793,7 @@ reportraw(time_t curtime, int numsecs,
  		sampsum   = summarycnt + 1;
 		totalsec  = 0;
 		totalexit = 0;
-		memset(&totsyst, 0, sizeof totsyst);
+		sstat_reset(&totsyst);
 
 		return '\0';
 	}
@@ -879,7 +879,7 @@ reportraw(time_t curtime, int numsecs,
  		sampsum   = summarycnt + sampcnt;
 		totalsec  = 0;
 		totalexit = 0;
-		memset(&totsyst, 0, sizeof totsyst);
+		sstat_reset(&totsyst);
 
 		return '\0';
 	}
@@ -979,7 +979,7 @@ reportraw(time_t curtime, int numsecs,
 		 	sampsum   = summarycnt + sampcnt;
 			totalsec  = 0;
 			totalexit = 0;
-			memset(&totsyst, 0, sizeof totsyst);
+			sstat_reset(&totsyst);
 		}
 		else
 		{
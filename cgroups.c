@@ -42,6 +42,11 @@
 #include <time.h>
 #include <stdlib.h>
 #include <regex.h>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stddef.h>
 
 #include "atop.h"
 #include "cgroups.h"
@@ -51,17 +56,45 @@
 #include "showlinux.h"
 
 static void		cgcalcdeviate(void);
+static void		cgdskdeviate(struct cgdsk *, struct cgdsk *);
+static void		cgkeysinit(void);
 
 static void		cgrewind(struct cgchainer **);
 static struct cgchainer	*cgnext(struct cgchainer **, struct cgchainer **);
-static void		cgwipe(struct cgchainer **, struct cgchainer **,
-			       struct cgchainer **, struct cgchainer **);
 
-static unsigned long	walkcgroup(char *, struct cgchainer *, int, long, int, int);
-static void		getconfig(struct cstat *, struct cstat *);
-static int		readconfigval(char *, count_t []);
-static void		getmetrics(struct cstat *);
-static void		getpressure(char *, count_t *, count_t *);
+struct cgnode;
+
+static void		cgtreeupdate(void);
+static void		cgtreebuild(void);
+static struct cgnode	*cgnodenew(struct cgnode *, char *);
+static void		cgnodescan(struct cgnode *, char *, int);
+static void		cgnodefree(struct cgnode *);
+static void		cgnodecreate(struct cgnode *, char *);
+static void		cgnoderemove(struct cgnode *, char *);
+
+struct cgarena;
+
+static void		cgarenareset(struct cgarena *);
+static unsigned int	cgarenachain(struct cgarena *);
+static unsigned long	cgarenacstat(struct cgarena *, int);
+static unsigned long	cgarenapids(struct cgarena *, unsigned long);
+static void		cglinkarray(struct cgchainer *, int, char *, char *);
+static void		cgpidinvalidate(void);
+
+struct cgwalk;
+
+static unsigned long	walkcgroup(struct cgwalk *, int, struct cgnode *,
+				int, long, int, int);
+static unsigned long	walkparallel(struct cgwalk *, int, struct cgnode *,
+				int, long, int, int);
+static void		*cgwalker(void *);
+static char		*readcgfile(int, char *);
+static char		*nextline(char **);
+static void		getconfig(int, struct cgconf *);
+static int		readconfigval(int, char *, count_t []);
+static void		getmetrics(int, struct cstat *);
+static void		getiostat(char *, struct cstat *);
+static void		getpressure(int, char *, count_t *, count_t *);
 
 static long		hashcalc(char *, long, int);
 static void		hashadd(struct cgchainer *[], struct cgchainer *);
@@ -69,7 +102,9 @@ static struct cgchainer	*hashfind(struct cgchainer *[], long);
 
 static int		cgroupfilter(struct cstat *, int, char);
 
+#ifndef CGROUPROOT
 #define	CGROUPROOT	"/sys/fs/cgroup"
+#endif
 
 #define	CGROUPNHASH	128	// power of 2
 #define	CGROUPMASK	(CGROUPNHASH-1)
@@ -86,7 +121,8 @@ static int		cgroupfilter(struct cstat *, int, char);
 //  
 //   this chain is built while gathering the current information by the
 //   walkcgroup() function
-//   this function mallocs one cgchainer struct and one cstat struct
+//   this function takes one cgchainer struct and one cstat struct
+//   per cgroup from the current arena (see below)
 //
 // - previous linked list
 //   --------------------
@@ -101,304 +137,1255 @@ static int		cgroupfilter(struct cstat *, int, char);
 //   this administration consists of an array(!) of cgchainer structs in which
 //   the cgchainer struct are still chained to the next element in the array
 //
+// - persistent cgroup tree
+//   -----------------------
+//   the structure of the cgroup tree (directories only) is maintained
+//   between samples, together with the configuration values per cgroup;
+//   modifications are detected via inotify (one watch per cgroup
+//   directory), so the directories do not have to be read again with
+//   every sample and configuration files are only read again after
+//   they have been written
+//
+//   when inotify can not be used (e.g. insufficient watches), the tree
+//   is rebuilt with every sample; when events have been lost, the tree
+//   is rebuilt once
+//
+struct cgnode {
+	struct cgnode	*parent;
+	struct cgnode	*child;		// first child
+	struct cgnode	*lastchild;	// last child (to append new one)
+	struct cgnode	*sibling;	// next child of parent
+	struct cgnode	*wdnext;	// next in watch descriptor hash list
+	int		wd;		// inotify watch descriptor (-1 = none)
+	char		confvalid;	// cached configuration still valid?
+	struct cgconf	conf;		// cached configuration
+	unsigned int	nbelow;		// number of cgroups in subtree
+					// (previous walk, top level only)
+	char		name[];		// directory name
+};
+
+#define	CGWDNHASH	1024
+#define	CGWATCHMASK	(IN_CREATE|IN_DELETE|IN_MOVED_FROM|IN_MOVED_TO| \
+			 IN_CLOSE_WRITE|IN_ONLYDIR)
+
+static struct cgnode	*cgtreeroot,		// top of tree
+			*cgwdhash[CGWDNHASH];
+
+static int		cgrootfd   = -1;	// descriptor of top directory
+static int		cginotfd   = -1;	// inotify descriptor
+static char		cgtreevalid;		// tree up-to-date via inotify?
+static char		cgnowatch;		// inotify not usable
+static char		cgwatchfail;		// failed to add watch
+
+
+// - arenas
+//   ------
+//   the cgchainer structs, cstat structs and pid lists of the current,
+//   previous and deviation administration are each allocated from an
+//   arena: three contiguous areas that only grow when needed and that
+//   are reused for later samples (releasing all structs of a sample
+//   is just a reset of the arena)
+//
+//   the cstat structs and the pid lists of an arena are contiguous,
+//   so the deviation arena can be compressed in place for the raw file
+//
+struct cgarena {
+	struct cgchainer *chain;	// array of cgchainer structs
+	unsigned int	nchain;		// number of cgchainer structs
+	unsigned int	maxchain;	// allocated cgchainer structs
+
+	char		*cstats;	// contiguous cstat structs
+	unsigned long	cstatlen;	// total size of all cstat structs
+	unsigned long	maxcstat;	// allocated size
+
+	pid_t		*pids;		// contiguous pid lists
+	unsigned long	npids;		// number of pids
+	unsigned long	maxpids;	// allocated pids
+};
+
+#define	CGCSTAT(a, off)	((struct cstat *)((a)->cstats + (off)))
+
+static struct cgarena	cgarenas[2],	// current and previous (alternating)
+			cgdevarena;	// deviations
+
+// current cgroup admi
+//
+static struct cgarena	*cgcurarena = &cgarenas[0];
+
+static struct cgchainer	*cgcurfirst;	// first in linked list
+
+// - walking the tree
+//   ---------------
+//   the top level subtrees (like system.slice, user.slice and
+//   kubepods.slice) are walked in parallel by several walker threads,
+//   each storing the cgroups in its own arena with sequence numbers
+//   relative to the subtree; afterwards the subtrees are merged into
+//   the current arena in the order of a sequential walk and renumbered,
+//   so the sequence numbers are exactly the same as for a sequential walk
+//
+struct cgwalk {
+	struct cgarena	*arena;		// arena to store cgroups
+	int		sequence;	// maintain sequence number to be
+					// assigned to every cgchainer struct
+					//
+					// later on this value can be used
+					// as index in the deviation array
+};
+
+#define	CGMAXWALKERS	8
+
+struct cgsubtree {
+	struct cgnode	*np;		// top node of subtree
+	int		walker;		// walker that collected the subtree
+	unsigned int	firstchain;	// location in arena of walker
+	unsigned int	nchain;
+	unsigned long	firstcstat;
+	unsigned long	cstatlen;
+	unsigned long	firstpid;
+	unsigned long	npids;
+	unsigned long	nprocs;		// processes in entire subtree
+};
+
+static struct cgarena	cgwalkarenas[CGMAXWALKERS];
+
+static __thread char	*cgfilebuf;	// file buffer per walker thread
+static __thread size_t	cgfilesize;
+
+static struct {
+	pthread_mutex_t		lock;
+	struct cgsubtree	**order;	// subtrees, biggest first
+	int			nsubtrees;
+	int			nextsubtree;	// next subtree to be walked
+	int			parentfd;
+	long			upperhash;
+	int			upperlen;
+	int			depth;
+} cgpar = {PTHREAD_MUTEX_INITIALIZER};
+
+// previous cgroup admi
+//
+static struct cgarena	*cgprearena = &cgarenas[1];
+
+static struct cgchainer	*cgprefirst,	// first in linked list
+			*cgprecursor,
+			*cgprehash[CGROUPNHASH];
+
+// deviation cgroup admi
+//
+static struct cgchainer	*cgdevfirst;	// pointer to array (!)
+
+
+// Check if cgroup v2 is supported on this machine
+//
+// Return value:	1 - yes
+// 			0 - no
+//
+int
+cgroupv2support(void)
+{
+	FILE	*fp;
+	char	line[128];
+
+	// check if this kernel offers cgroups version 2
+	//
+	if ( (fp = fopen("/proc/1/cgroup", "r")) )
+	{
+		while (fgets(line, sizeof line, fp))
+		{
+			if (memcmp(line, "0::", 3) == 0) // equal?
+			{
+				supportflags |= CGROUPV2;
+				break;
+			}
+		}
+
+		fclose(fp);
+	}
+
+	return (supportflags&CGROUPV2) > 0;
+}
+
+
+// Gather all metrics from the entire cgroup tree,
+// creating a chain of cgchainer structs
+//
+void
+photocgroup(void)
+{
+	struct cgarena	*ap;
+	struct cgwalk	walk;
+
+	// move current cgroup chain to previous cgroup chain and
+	// reuse the arena of the previous chain (not needed any more)
+	// for the new current chain
+	//
+	ap         = cgprearena;
+	cgprearena = cgcurarena;
+	cgcurarena = ap;
+
+	cgprefirst  = cgcurfirst;
+	cgprecursor = NULL;
+
+	memset(cgprehash, 0, sizeof cgprehash);
+
+	cgwipecur();
+
+	// wipe deviation cgroup memory 
+	//
+	cgarenareset(&cgdevarena);
+	cgdevfirst = NULL;
+
+	// open top directory of cgroup fs (all files and directories
+	// underneath are opened relative to their directory descriptor)
+	//
+	if (cgrootfd == -1 &&
+	    (cgrootfd = open(CGROUPROOT, O_RDONLY|O_DIRECTORY|O_CLOEXEC)) == -1)
+		mcleanstop(54, "failed to open " CGROUPROOT "\n");
+
+	// bring the tree structure up-to-date
+	//
+	cgtreeupdate();
+
+	// gather the metrics of all cgroups in the tree
+	//
+	cgkeysinit();
+
+	walk.arena    = cgcurarena;
+	walk.sequence = 0;
+
+	walkcgroup(&walk, cgrootfd, cgtreeroot, -1, 0, 0, 0);
+
+	// now that the arena does not grow any more,
+	// chain the cgchainer structs and let them refer
+	// to their cstat struct and pid list
+	//
+	ap = cgcurarena;
+
+	if (ap->nchain)
+	{
+		cglinkarray(ap->chain, ap->nchain, ap->cstats, (char *)ap->pids);
+		cgcurfirst = ap->chain;
+	}
+}
+
+
+// Reset an arena (all structs released)
+//
+static void
+cgarenareset(struct cgarena *ap)
+{
+	ap->nchain   = 0;
+	ap->cstatlen = 0;
+	ap->npids    = 0;
+}
+
+
+// Allocate a (zeroed) cgchainer struct from an arena
+//
+// Return value:	index in the cgchainer array
+//
+static unsigned int
+cgarenachain(struct cgarena *ap)
+{
+	if (ap->nchain == ap->maxchain)
+	{
+		ap->maxchain = ap->maxchain ? ap->maxchain * 2 : 256;
+		ap->chain    = realloc(ap->chain,
+				sizeof(struct cgchainer) * ap->maxchain);
+		ptrverify(ap->chain, "Malloc failed for %u cgchainers\n",
+				ap->maxchain);
+	}
+
+	memset(&ap->chain[ap->nchain], 0, sizeof(struct cgchainer));
+
+	return ap->nchain++;
+}
+
+
+// Allocate a (zeroed) cstat struct of the given length from an arena
+//
+// Return value:	offset in the cstat area
+//
+static unsigned long
+cgarenacstat(struct cgarena *ap, int cstatlen)
+{
+	unsigned long	off = ap->cstatlen;
+
+	if (off + cstatlen > ap->maxcstat)
+	{
+		ap->maxcstat = ap->maxcstat ? ap->maxcstat * 2 : 256 * 1024;
+
+		while (off + cstatlen > ap->maxcstat)
+			ap->maxcstat *= 2;
+
+		ap->cstats = realloc(ap->cstats, ap->maxcstat);
+		ptrverify(ap->cstats, "Malloc failed for cstats (%lu bytes)\n",
+				ap->maxcstat);
+	}
+
+	memset(ap->cstats + off, 0, cstatlen);
+
+	ap->cstatlen += cstatlen;
+
+	return off;
+}
+
+
+// Allocate a pid list with the given number of pids from an arena
+//
+// Return value:	index in the pid area
+//
+static unsigned long
+cgarenapids(struct cgarena *ap, unsigned long npids)
+{
+	unsigned long	ix = ap->npids;
+
+	if (ix + npids > ap->maxpids)
+	{
+		ap->maxpids = ap->maxpids ? ap->maxpids * 2 : 4096;
+
+		while (ix + npids > ap->maxpids)
+			ap->maxpids *= 2;
+
+		ap->pids = realloc(ap->pids, sizeof(pid_t) * ap->maxpids);
+		ptrverify(ap->pids, "Malloc failed for pid lists (%lu pids)\n",
+				ap->maxpids);
+	}
+
+	ap->npids += npids;
+
+	return ix;
+}
+
+
+// Bring the persistent cgroup tree up-to-date, either by handling
+// the pending inotify events or by rebuilding the entire tree
+//
+static void
+cgtreeupdate(void)
+{
+	char			evbuf[16384]
+				__attribute__ ((aligned(__alignof__(struct inotify_event))));
+	struct inotify_event	*ev;
+	struct cgnode		*np;
+	ssize_t			n;
+	char			*p;
+
+	if (!cgtreevalid)
+	{
+		cgtreebuild();
+		return;
+	}
+
+	while ( (n = read(cginotfd, evbuf, sizeof evbuf)) > 0)
+	{
+		for (p = evbuf; p < evbuf + n; p += sizeof *ev + ev->len)
+		{
+			ev = (struct inotify_event *)p;
+
+			if (ev->mask & IN_Q_OVERFLOW)	// events lost?
+			{
+				cgtreevalid = 0;
+				continue;
+			}
+
+			// search node belonging to watch descriptor
+			//
+			for (np = cgwdhash[ev->wd % CGWDNHASH]; np; np = np->wdnext)
+			{
+				if (np->wd == ev->wd)
+					break;
+			}
+
+			if (!np || ev->len == 0)  // removed already or self event
+				continue;
+
+			if (ev->mask & IN_ISDIR)
+			{
+				if (ev->mask & (IN_CREATE|IN_MOVED_TO))
+					cgnodecreate(np, ev->name);
+
+				if (ev->mask & (IN_DELETE|IN_MOVED_FROM))
+					cgnoderemove(np, ev->name);
+			}
+			else if (ev->mask & IN_CLOSE_WRITE)
+			{
+				// file written, like cpu.max or memory.max
+				//
+				np->confvalid = 0;
+			}
+		}
+	}
+
+	if (cgwatchfail)	// failed to add watch for new cgroup?
+		cgtreevalid = 0;
+
+	if (!cgtreevalid)
+		cgtreebuild();
+}
+
+
+// Build the entire persistent cgroup tree
+//
+static void
+cgtreebuild(void)
+{
+	char	path[PATH_MAX];
+
+	if (cgtreeroot)
+		cgnodefree(cgtreeroot);
+
+	memset(cgwdhash, 0, sizeof cgwdhash);
+
+	// start with a new inotify instance (implicitly removing
+	// all existing watches)
+	//
+	if (cginotfd != -1)
+		close(cginotfd);
+
+	cginotfd    = cgnowatch ? -1 : inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+	cgwatchfail = 0;
+
+	cgtreeroot = cgnodenew(NULL, ".");
+
+	safe_strcpy(path, CGROUPROOT, sizeof path);
+	cgnodescan(cgtreeroot, path, strlen(path));
+
+	if (cginotfd != -1 && !cgwatchfail)
+	{
+		cgtreevalid = 1;
+	}
+	else	// inotify not usable: rebuild tree with every sample
+	{
+		if (cginotfd != -1)
+			close(cginotfd);
+
+		cginotfd    = -1;
+		cgnowatch   = 1;
+		cgtreevalid = 0;
+	}
+}
+
+
+// Create a new node in the cgroup tree as last child of the parent
+//
+static struct cgnode *
+cgnodenew(struct cgnode *parent, char *name)
+{
+	struct cgnode	*np;
+
+	np = calloc(1, sizeof(struct cgnode) + strlen(name) + 1);
+	ptrverify(np, "Malloc failed for cgroup node\n");
+
+	strcpy(np->name, name);
+
+	np->wd     = -1;
+	np->parent = parent;
+
+	if (parent)
+	{
+		if (parent->lastchild)
+			parent->lastchild->sibling = np;
+		else
+			parent->child = np;
+
+		parent->lastchild = np;
+	}
+
+	return np;
+}
+
+
+// Add a watch for the directory of a node and add nodes for
+// all subdirectories recursively
+// (the watch is added before reading the directory, so a subdirectory
+// that is created meanwhile is either found or reported as event)
+//
+static void
+cgnodescan(struct cgnode *np, char *path, int pathlen)
+{
+	DIR		*dirp;
+	struct dirent	*entp;
+	int		namelen;
+
+	if (cginotfd != -1)
+	{
+		if ( (np->wd = inotify_add_watch(cginotfd, path, CGWATCHMASK)) != -1)
+		{
+			np->wdnext = cgwdhash[np->wd % CGWDNHASH];
+			cgwdhash[np->wd % CGWDNHASH] = np;
+		}
+		else
+		{
+			cgwatchfail = 1;
+		}
+	}
+
+	if ( (dirp = opendir(path)) == NULL)
+		return;
+
+	while ( (entp = readdir(dirp)) )
+	{
+		// skip dot files/directories and non-directories
+		//
+		if (entp->d_name[0] == '.' || entp->d_type != DT_DIR)
+			continue;
+
+		namelen = strlen(entp->d_name);
+
+		if (pathlen + namelen + 2 > PATH_MAX)
+			continue;
+
+		path[pathlen] = '/';
+		strcpy(path+pathlen+1, entp->d_name);
+
+		cgnodescan(cgnodenew(np, entp->d_name), path, pathlen+namelen+1);
+
+		path[pathlen] = '\0';
+	}
+
+	closedir(dirp);
+}
+
+
+// Free a node and all nodes underneath
+//
+static void
+cgnodefree(struct cgnode *np)
+{
+	struct cgnode	*cnp, *cnpnext, **npp;
+
+	for (cnp = np->child; cnp; cnp = cnpnext)
+	{
+		cnpnext = cnp->sibling;
+		cgnodefree(cnp);
+	}
+
+	// remove from watch descriptor hash list
+	//
+	if (np->wd != -1)
+	{
+		for (npp = &cgwdhash[np->wd % CGWDNHASH]; *npp; npp = &(*npp)->wdnext)
+		{
+			if (*npp == np)
+			{
+				*npp = np->wdnext;
+				break;
+			}
+		}
+	}
+
+	free(np);
+}
+
+
+// Handle a new subdirectory below the directory of a node
+//
+static void
+cgnodecreate(struct cgnode *np, char *name)
+{
+	struct cgnode	*cnp, *pnp;
+	char		path[PATH_MAX], *names[CGRMAXDEPTH];
+	int		n = 0, len;
+
+	// subdirectory already found while scanning?
+	//
+	for (cnp = np->child; cnp; cnp = cnp->sibling)
+	{
+		if (strcmp(cnp->name, name) == 0)
+			return;
+	}
+
+	// assemble full path name of new directory
+	//
+	for (pnp = np; pnp->parent && n < CGRMAXDEPTH; pnp = pnp->parent)
+		names[n++] = pnp->name;
+
+	len = snprintf(path, sizeof path, "%s", CGROUPROOT);
+
+	while (n > 0 && len < sizeof path)
+		len += snprintf(path+len, sizeof path - len, "/%s", names[--n]);
+
+	if (len < sizeof path)
+		len += snprintf(path+len, sizeof path - len, "/%s", name);
+
+	if (len >= sizeof path)
+		return;
+
+	cgnodescan(cgnodenew(np, name), path, len);
+}
+
+
+// Handle a removed subdirectory below the directory of a node
+//
+static void
+cgnoderemove(struct cgnode *np, char *name)
+{
+	struct cgnode	*cnp, *prev = NULL;
+
+	for (cnp = np->child; cnp; prev = cnp, cnp = cnp->sibling)
+	{
+		if (strcmp(cnp->name, name) == 0)
+			break;
+	}
+
+	if (!cnp)
+		return;
+
+	if (prev)
+		prev->sibling = cnp->sibling;
+	else
+		np->child = cnp->sibling;
+
+	if (np->lastchild == cnp)
+		np->lastchild = prev;
+
+	cgnodefree(cnp);
+}
+
+
+// Gather statistics from one cgroup directory level
+// and walk the directory tree further downwards by nested calls.
+// Every call to this function will add one struct to the current
+// cgroup chain.
+//
+// Return value:	number of processes in this dir and the dirs underneath
+// 			-1 = fail
+//
+static unsigned long
+walkcgroup(struct cgwalk *wp, int parentfd, struct cgnode *np, int parentseq,
+         long upperhash, int upperlen, int depth)
+{
+	struct cgnode	*cnp;
+	struct cgarena	*ap = wp->arena;
+	struct cstat	*csp;
+	char		*dirname = np->name;
+
+	int		namelen = strlen(dirname);
+	int 		cstatlen, i, dirfd, sequence;
+
+	unsigned long	procsbelow=0, proccnt=0, hash, cstatoff, pidix;
+
+	char		*buf, *line, *p;
+
+	// open new directory
+	//
+	if ( (dirfd = openat(parentfd, dirname,
+				O_RDONLY|O_DIRECTORY|O_CLOEXEC)) == -1)
+		return 0;
+
+	// --------------------------------------------
+	// gather statistics for this cgroup directory
+	// --------------------------------------------
+	// - create new cgchainer struct in the current arena
+	//   (chained after the entire tree has been walked)
+	//
+	cgarenachain(ap);
+
+	// - create corresponding cstat struct
+	//   with a rounded length to avoid unaligned structs later on
+	//
+	//   the arena might be moved by later allocations, so the
+	//   offset of the cstat struct is used to refer to it
+	//
+        cstatlen = sizeof(struct cstat) + namelen + 1;
+
+	if (cstatlen & 0x7)	// length is not 64-bit multiple?
+		cstatlen = ((cstatlen >> 3) + 1) << 3;	// round up to 64-bit
+
+	cstatoff = cgarenacstat(ap, cstatlen);
+
+	// - read the list of processes in this cgroup directory
+	//   at once, count the number of lines (one PID per line)
+	//   and store the PIDs in the pid area of the arena
+	//
+	if ( (buf = readcgfile(dirfd, "cgroup.procs")) )
+	{
+		for (p=buf; (p = strchr(p, '\n')); p++)
+			proccnt++;
+
+		if (proccnt)
+		{
+			pidix = cgarenapids(ap, proccnt);
+
+			for (i=0, p=buf; (line = nextline(&p)) && i < proccnt; i++)
+				ap->pids[pidix+i] = strtol(line, NULL, 10);
+		}
+	}
+
+	// - fill basic info in current cstat struct
+	//
+	csp = CGCSTAT(ap, cstatoff);
+
+	safe_strcpy(csp->cgname, dirname, namelen+1);	// copy directory name
+
+	if (*dirname == '.')			// top directory?
+	{
+		csp->cgname[0] = '\0';		// wipe name
+		namelen        = 0;
+	}
+
+	hash = hashcalc(csp->cgname, upperhash, upperlen);
+
+	sequence = wp->sequence++;		// assign unique sequence number
+
+	csp->gen.structlen   = cstatlen;
+	csp->gen.sequence    = sequence;
+	csp->gen.parentseq   = parentseq;
+	csp->gen.depth       = depth;
+	csp->gen.nprocs      = proccnt;
+	csp->gen.namelen     = namelen;
+	csp->gen.fullnamelen = upperlen + namelen; // excluding slashes
+	csp->gen.namehash    = hash;
+
+	// - gather and store current cgroup configuration
+	//   (only read again when modified)
+	//
+	if (!np->confvalid)
+	{
+		getconfig(dirfd, &np->conf);
+		np->confvalid = cgtreevalid;
+	}
+
+	csp->conf = np->conf;
+
+	// - gather and store current cgroup metrics
+	//
+	getmetrics(dirfd, csp);
+
+	// --------------------------------------------
+	// walk subdirectories by nested calls
+	// (top level subtrees preferably in parallel)
+	// --------------------------------------------
+	//
+	if (depth == 0 && np->child && np->child != np->lastchild)
+	{
+		procsbelow = walkparallel(wp, dirfd, np, sequence,
+				hash, upperlen+namelen, depth+1);
+	}
+	else
+	{
+		for (cnp = np->child; cnp; cnp = cnp->sibling)
+			procsbelow += walkcgroup(wp, dirfd, cnp, sequence,
+					hash, upperlen+namelen, depth+1);
+	}
+
+	close(dirfd);
+
+	CGCSTAT(ap, cstatoff)->gen.procsbelow = procsbelow;
+
+	return procsbelow + proccnt;
+}
+
+
+// Walk the subtrees underneath a node by several walker threads
+// and merge the results into the arena of the caller.
+//
+// Return value:	number of processes in all subtrees
+//
+static unsigned long
+walkparallel(struct cgwalk *wp, int dirfd, struct cgnode *np, int parentseq,
+         long upperhash, int upperlen, int depth)
+{
+	static struct cgsubtree	*subtrees;
+	static struct cgsubtree	**order;
+	static int		maxsubtrees;
+
+	struct cgnode		*cnp;
+	struct cgsubtree	*stp;
+	struct cgarena		*src, *dst = wp->arena;
+	struct cstat		*csp;
+	pthread_t		tids[CGMAXWALKERS];
+	sigset_t		allsigs, oldsigs;
+	unsigned long		procsbelow = 0, off, pidix;
+	unsigned int		n;
+	int			nsubtrees = 0, nwalkers, nthreads = 0, i, j;
+	int			base;
+
+	// build list of subtrees
+	//
+	for (cnp = np->child; cnp; cnp = cnp->sibling)
+		nsubtrees++;
+
+	if (nsubtrees > maxsubtrees)
+	{
+		maxsubtrees = nsubtrees;
+
+		subtrees = realloc(subtrees, maxsubtrees * sizeof *subtrees);
+		ptrverify(subtrees, "Malloc failed for %d cgroup subtrees\n",
+						maxsubtrees);
+
+		order = realloc(order, maxsubtrees * sizeof *order);
+		ptrverify(order, "Malloc failed for %d cgroup subtrees\n",
+						maxsubtrees);
+	}
+
+	memset(subtrees, 0, nsubtrees * sizeof *subtrees);
+
+	// sort the subtrees on their size during the previous walk
+	// (biggest first) so the walkers finish at about the same time
+	//
+	for (i=0, cnp = np->child; cnp; cnp = cnp->sibling, i++)
+	{
+		subtrees[i].np = cnp;
+
+		for (j=i; j > 0 && order[j-1]->np->nbelow < cnp->nbelow; j--)
+			order[j] = order[j-1];
+
+		order[j] = &subtrees[i];
+	}
+
+	// determine number of walkers
+	//
+	nwalkers = sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (nwalkers > CGMAXWALKERS)
+		nwalkers = CGMAXWALKERS;
+
+	if (nwalkers > nsubtrees)
+		nwalkers = nsubtrees;
+
+	if (nwalkers < 1)
+		nwalkers = 1;
+
+	for (i=0; i < nwalkers; i++)
+		cgarenareset(&cgwalkarenas[i]);
+
+	cgpar.order       = order;
+	cgpar.nsubtrees   = nsubtrees;
+	cgpar.nextsubtree = 0;
+	cgpar.parentfd    = dirfd;
+	cgpar.upperhash   = upperhash;
+	cgpar.upperlen    = upperlen;
+	cgpar.depth       = depth;
+
+	// start the additional walker threads with all signals blocked
+	// (signals should be handled by the main thread only);
+	// when a thread can not be created, the remaining walkers
+	// handle its share
+	//
+	sigfillset(&allsigs);
+	pthread_sigmask(SIG_SETMASK, &allsigs, &oldsigs);
+
+	for (i=1; i < nwalkers; i++)
+	{
+		if (pthread_create(&tids[nthreads], NULL, cgwalker,
+						(void *)(long)i) != 0)
+			break;
+
+		nthreads++;
+	}
+
+	pthread_sigmask(SIG_SETMASK, &oldsigs, NULL);
+
+	// the current thread acts as walker 0
+	//
+	cgwalker((void *)0L);
+
+	for (i=0; i < nthreads; i++)
+		pthread_join(tids[i], NULL);
+
+	// merge the subtrees into the arena of the caller
+	// in the order of a sequential walk, adapting
+	// the sequence numbers (relative to the subtree)
+	//
+	base = wp->sequence;
+
+	for (i=0, stp=subtrees; i < nsubtrees; i++, stp++)
+	{
+		src = &cgwalkarenas[stp->walker];
+
+		for (n=0; n < stp->nchain; n++)
+			cgarenachain(dst);
+
+		off = cgarenacstat(dst, stp->cstatlen);
+
+		memcpy(dst->cstats + off, src->cstats + stp->firstcstat,
+							stp->cstatlen);
+
+		for (; off < dst->cstatlen; off += csp->gen.structlen)
+		{
+			csp = CGCSTAT(dst, off);
+
+			if (csp->gen.parentseq == -1)	// top of subtree?
+				csp->gen.parentseq  = parentseq;
+			else
+				csp->gen.parentseq += base;
+
+			csp->gen.sequence += base;
+		}
+
+		if (stp->npids)
+		{
+			pidix = cgarenapids(dst, stp->npids);
+
+			memcpy(dst->pids + pidix, src->pids + stp->firstpid,
+						stp->npids * sizeof(pid_t));
+		}
+
+		base       += stp->nchain;
+		procsbelow += stp->nprocs;
+
+		stp->np->nbelow = stp->nchain;
+	}
+
+	wp->sequence = base;
+
+	return procsbelow;
+}
+
+
+// Walker: take the next subtree that has not been walked yet
+// until all subtrees have been walked
+//
+static void *
+cgwalker(void *arg)
+{
+	int			walker = (long)arg, i;
+	struct cgwalk		walk;
+	struct cgarena		*ap = &cgwalkarenas[walker];
+	struct cgsubtree	*stp;
+
+	walk.arena = ap;
+
+	while (1)
+	{
+		pthread_mutex_lock(&cgpar.lock);
+		i = cgpar.nextsubtree++;
+		pthread_mutex_unlock(&cgpar.lock);
+
+		if (i >= cgpar.nsubtrees)
+			break;
+
+		stp = cgpar.order[i];
+
+		stp->walker     = walker;
+		stp->firstchain = ap->nchain;
+		stp->firstcstat = ap->cstatlen;
+		stp->firstpid   = ap->npids;
+
+		walk.sequence   = 0;	// relative to subtree
+
+		stp->nprocs     = walkcgroup(&walk, cgpar.parentfd, stp->np, -1,
+					cgpar.upperhash, cgpar.upperlen,
+					cgpar.depth);
+
+		stp->nchain     = ap->nchain   - stp->firstchain;
+		stp->cstatlen   = ap->cstatlen - stp->firstcstat;
+		stp->npids      = ap->npids    - stp->firstpid;
+	}
+
+	// release file buffer of an additional thread
+	//
+	if (walker)
+	{
+		free(cgfilebuf);
+		cgfilebuf  = NULL;
+		cgfilesize = 0;
+	}
+
+	return NULL;
+}
+
 
-// current cgroup admi
+// ===========================================================
+// Table-driven extraction of counters from cgroup files
+// ===========================================================
+// the keys that are relevant in a cgroup file are defined in a table;
+// on first use a perfect hash is created for these keys (i.e. a seed
+// and a number of slots for which every key maps to its own slot),
+// so every line in a file costs one hash calculation and at most
+// one string comparison, regardless of the number of keys
 //
-static struct cgchainer	*cgcurfirst,	// first in linked list
-			*cgcurlast,	// last  in linked list
-			*cgcurcursor;
+struct cgkey {
+	char	*name;
+	int	offset;		// offset of counter in target struct
+	char	inpages;	// convert value from bytes to pages
+	int	namelen;	// filled during initialization
+};
 
-static unsigned int	cgcursize; 	// total size of all cstat structs
-static unsigned int	cgcurnum; 	// number of cstat structs
-static unsigned int	cgcurprocs; 	// number of processes in current list
+struct cgkeytab {
+	struct cgkey	*keys;
+	int		nkeys;
+	unsigned int	seed;
+	unsigned int	mask;		// number of slots - 1
+	signed char	*slots;		// index in keys per slot, -1 = none
+};
 
-static int		cgcursequence;	// maintain sequence number to be
-					// assigned to every cgchainer struct
-					//
-					// later on this value can be used
-					// as index in the deviation array
+#define	CGKEYS(k)	{k, sizeof k / sizeof k[0]}
 
-// previous cgroup admi
+// cpu.stat
 //
-static struct cgchainer	*cgprefirst,	// first in linked list
-			*cgprelast,	// last  in linked list
-			*cgprecursor,
-			*cgprehash[CGROUPNHASH];
+static struct cgkey cpustatkey[] = {
+	{"user_usec",			offsetof(struct cstat, cpu.utime),	0},
+	{"system_usec",			offsetof(struct cstat, cpu.stime),	0},
+	{"nr_throttled",		offsetof(struct cstat, cpu.nrthrottled),0},
+	{"throttled_usec",		offsetof(struct cstat, cpu.thrtime),	0},
+};
 
-// deviation cgroup admi
+// memory.stat
+// (workingset_refault is split into an anon and a file
+// counter by newer kernels, which are accumulated)
 //
-static struct cgchainer	*cgdevfirst,	// pointer to array (!)
-			*cgdevcursor;
+static struct cgkey memstatkey[] = {
+	{"anon",			offsetof(struct cstat, mem.anon),	1},
+	{"file",			offsetof(struct cstat, mem.file),	1},
+	{"kernel",			offsetof(struct cstat, mem.kernel),	1},
+	{"shmem",			offsetof(struct cstat, mem.shmem),	1},
+	{"sock",			offsetof(struct cstat, mem.sock),	1},
+	{"slab",			offsetof(struct cstat, mem.slab),	1},
+	{"active_file",			offsetof(struct cstat, mem.actfile),	1},
+	{"inactive_file",		offsetof(struct cstat, mem.inactfile),	1},
+	{"pgmajfault",			offsetof(struct cstat, mem.pgmajflt),	0},
+	{"workingset_refault",		offsetof(struct cstat, mem.wsrefault),	0},
+	{"workingset_refault_anon",	offsetof(struct cstat, mem.wsrefault),	0},
+	{"workingset_refault_file",	offsetof(struct cstat, mem.wsrefault),	0},
+};
 
+// io.stat (per disk)
+//
+static struct cgkey iostatkey[] = {
+	{"rbytes",			offsetof(struct cgperdsk, rbytes),	0},
+	{"wbytes",			offsetof(struct cgperdsk, wbytes),	0},
+	{"rios",			offsetof(struct cgperdsk, rios),	0},
+	{"wios",			offsetof(struct cgperdsk, wios),	0},
+};
 
-// Check if cgroup v2 is supported on this machine
+// memory.events
 //
-// Return value:	1 - yes
-// 			0 - no
+static struct cgkey memeventkey[] = {
+	{"high",			offsetof(struct cstat, mem.evhigh),	0},
+	{"max",				offsetof(struct cstat, mem.evmax),	0},
+	{"oom",				offsetof(struct cstat, mem.evoom),	0},
+	{"oom_kill",			offsetof(struct cstat, mem.evoomkill),	0},
+};
+
+static struct cgkeytab	cpustatkeys = CGKEYS(cpustatkey),
+			memstatkeys = CGKEYS(memstatkey),
+			memeventkeys= CGKEYS(memeventkey),
+			iostatkeys  = CGKEYS(iostatkey);
+
+// Hash function for key names (FNV-1a with seed)
 //
-int
-cgroupv2support(void)
+static unsigned int
+cgkeyhash(char *p, int len, unsigned int seed)
 {
-	FILE	*fp;
-	char	line[128];
+	unsigned int	hash = 2166136261U ^ seed;
 
-	// check if this kernel offers cgroups version 2
-	//
-	if ( (fp = fopen("/proc/1/cgroup", "r")) )
+	while (len--)
 	{
-		while (fgets(line, sizeof line, fp))
-		{
-			if (memcmp(line, "0::", 3) == 0) // equal?
-			{
-				supportflags |= CGROUPV2;
-				break;
-			}
-		}
-
-		fclose(fp);
+		hash ^= (unsigned char)*p++;
+		hash *= 16777619;
 	}
 
-	return (supportflags&CGROUPV2) > 0;
+	return hash;
 }
 
-
-// Gather all metrics from the entire cgroup tree,
-// creating a chain of cgchainer structs
+// Create the perfect hash for a key table by searching
+// for a seed that maps all keys to a unique slot
+// (if not found, the number of slots is doubled)
 //
-void
-photocgroup(void)
+static void
+cgkeyinit(struct cgkeytab *ktp)
 {
-	char		origdir[4096];
+	unsigned int	nslots, seed, slot;
+	int		i;
 
-	// wipe previous cgroup chain (not needed any more)
-	//
-	cgwipe(&cgprefirst, &cgprelast, &cgprecursor, cgprehash);
-
-	// move current cgroup chain to previous cgroup chain
-	//
-	cgprefirst  = cgcurfirst;
-	cgprelast   = cgcurlast;
+	for (i=0; i < ktp->nkeys; i++)
+		ktp->keys[i].namelen = strlen(ktp->keys[i].name);
 
-	cgcurfirst  = cgcurlast = cgcurcursor = NULL;
+	for (nslots = 4; nslots < ktp->nkeys * 2; nslots *= 2)
+		;
 
-	// wipe deviation cgroup memory 
-	// - wipe all contiguous cstat structs (start address in first cgchainer)
-	// - wipe pidlist (start address in first cgchainer)
-	// - wipe all contiguous cgchainer structs
-	//
-	if (cgdevfirst)
+	for (;; nslots *= 2)
 	{
-		free(cgdevfirst->cstat);
-		free(cgdevfirst->proclist);
-		free(cgdevfirst);
-	}
+		ktp->slots = realloc(ktp->slots, nslots);
+		ptrverify(ktp->slots, "Malloc failed for cgroup key table\n");
 
-	// save current directory and move to top directory
-	// of cgroup fs
-	//
-	if ( getcwd(origdir, sizeof origdir) == NULL)
-		mcleanstop(53, "failed to save current dir\n");
+		for (seed=0; seed < 1024; seed++)
+		{
+			memset(ktp->slots, -1, nslots);
 
-	if ( chdir(CGROUPROOT) == -1)
-		mcleanstop(54, "failed to change to " CGROUPROOT "\n");
+			for (i=0; i < ktp->nkeys; i++)
+			{
+				slot = cgkeyhash(ktp->keys[i].name,
+				                 ktp->keys[i].namelen, seed) &
+								(nslots-1);
 
-	// read all subdirectory names below the cgroup top directory
-	//
-	cgcursequence = 0;
-	cgcursize     = 0;
-	cgcurnum      = 0;
-	cgcurprocs    = 0;
+				if (ktp->slots[slot] != -1)	// collision?
+					break;
 
-	walkcgroup(".", NULL, -1, 0, 0, 0);
+				ktp->slots[slot] = i;
+			}
 
-	// return to original directory
-	//
-	if ( chdir(origdir) == -1)
-		mcleanstop(55, "cannot change to %s\n", origdir);
+			if (i == ktp->nkeys)	// all keys unique slot?
+			{
+				ktp->seed = seed;
+				ktp->mask = nslots - 1;
+				return;
+			}
+		}
+	}
 }
 
-
-// Gather statistics from one cgroup directory level
-// and walk the directory tree further downwards by nested calls.
-// Every call to this function will add one struct to the current
-// cgroup chain.
-//
-// Return value:	number of processes in this dir and the dirs underneath
-// 			-1 = fail
+// Initialize all key tables (once)
 //
-static unsigned long
-walkcgroup(char *dirname, struct cgchainer *cparent, int parentseq,
-         long upperhash, int upperlen, int depth)
+static void
+cgkeysinit(void)
 {
-	FILE		*fp;
-	DIR		*dirp;
-	struct dirent	*entp;
-
-	int		namelen = strlen(dirname);
-	int 		cstatlen, i;
+	static int	initialized;
 
-	unsigned long	procsbelow=0, proccnt=0, hash;
+	if (initialized)
+		return;
 
-	struct cgchainer	*ccp;
+	cgkeyinit(&cpustatkeys);
+	cgkeyinit(&memstatkeys);
+	cgkeyinit(&memeventkeys);
+	cgkeyinit(&iostatkeys);
 
-	// change to new directory
-	//
-	if ( chdir(dirname) == -1)
-		return -1;
+	initialized = 1;
+}
 
-	// --------------------------------------------
-	// gather statistics for this cgroup directory
-	// --------------------------------------------
-	// - create new cgchainer struct
-	//
-	ccp = calloc(1, sizeof(struct cgchainer));
-	ptrverify(ccp, "Malloc failed for current cgchainer\n");
+// Search a key in a key table
+//
+// Return value:	pointer to key definition
+//			NULL = irrelevant key
+//
+static struct cgkey *
+cgkeyfind(struct cgkeytab *ktp, char *name, int namelen)
+{
+	struct cgkey	*kp;
+	int		i;
 
-	// - add cgchainer to current chain
-	//
-	if (cgcurfirst)
-	{
-		cgcurlast->next = ccp;
-		cgcurlast       = ccp;
-	}
-	else
-	{
-		cgcurfirst = ccp;
-		cgcurlast  = ccp;
-	}
+	i = ktp->slots[cgkeyhash(name, namelen, ktp->seed) & ktp->mask];
 
-	// - create corresponding cstat struct
-	//   with a rounded length to avoid unaligned structs later on
-	//
-        cstatlen = sizeof(struct cstat) + namelen + 1;
+	if (i == -1)
+		return NULL;
 
-	if (cstatlen & 0x7)	// length is not 64-bit multiple?
-		cstatlen = ((cstatlen >> 3) + 1) << 3;	// round up to 64-bit
+	kp = &(ktp->keys[i]);
 
-	ccp->cstat = calloc(1, cstatlen);
-	ptrverify(ccp->cstat, "Malloc failed for cstat of %d bytes\n", cstatlen);
+	if (kp->namelen != namelen || memcmp(kp->name, name, namelen) != 0)
+		return NULL;
 
-	cgcursize += cstatlen;
-	cgcurnum++;
+	return kp;
+}
 
-	// - count number of processes in this cgroup directory
-	//
-	if ( (fp = fopen("cgroup.procs", "r")) )
-	{
-		char line[64];
+// Set all counters of a key table to undefined
+//
+static void
+cgkeyundef(struct cgkeytab *ktp, void *target)
+{
+	int	i;
 
-		while (fgets(line, sizeof line, fp))
-			proccnt++;
+	for (i=0; i < ktp->nkeys; i++)
+		*(count_t *)((char *)target + ktp->keys[i].offset) = -1;
+}
 
-		fclose(fp);
-	}
+// Handle the contents of a file with lines in the format 'key value'
+// and store the values of the relevant keys in the target struct
+// (counters with the same offset are accumulated)
+//
+static void
+cgkeyparse(struct cgkeytab *ktp, char *buf, void *target)
+{
+	struct cgkey	*kp;
+	char		*line, *p;
+	count_t		value, *cp;
 
-	// - create corresponding pid list to cgchainer
-	//   and fill it with the PIDs
-	//
-	if (proccnt)
+	while ((line = nextline(&buf)))
 	{
-        	ccp->proclist = malloc(sizeof(pid_t) * proccnt);
-		ptrverify(ccp->proclist, "Malloc failed for proclist (%d pids)\n", proccnt);
+		if ( (p = strchr(line, ' ')) == NULL)
+			continue;
 
-		i = 0;
+		if ( (kp = cgkeyfind(ktp, line, p - line)) == NULL)
+			continue;
 
-		if ( (fp = fopen("cgroup.procs", "r")) )
-		{
-			char line[64];
+		value = strtoll(p+1, NULL, 10);
 
-			while (fgets(line, sizeof line, fp))
-			{
-				// number of processes might have expanded since counting
-				// 
-				// this is expected to be a rare situation that will be
-				// solved by a realloc() to expand the pid list
-				//
-				if (i >= proccnt)
-				{
-					proccnt = i+1;
+		if (kp->inpages)
+			value /= pagesize;
 
-					ccp->proclist = realloc(ccp->proclist, sizeof(pid_t) * proccnt);
-					ptrverify(ccp->proclist, "Realloc failed for proclist (%d pids)\n", proccnt);
-				}
+		cp = (count_t *)((char *)target + kp->offset);
 
-				// store pid
-				//
-				*(ccp->proclist+i) = strtol(line, NULL, 10);
-				i++;
-			}
+		if (*cp == -1)
+			*cp = value;
+		else
+			*cp += value;
+	}
+}
 
-			fclose(fp);
-		}
 
-		proccnt = i;	// number of processes might have shrunk since counting
+// Read the contents of a file in the given cgroup directory
+// into a buffer that is reused for every file (so the contents
+// must have been processed before the next file is read).
+//
+// Return value:	pointer to null-terminated contents
+//			NULL = file could not be opened or read
+//
 
-		cgcurprocs += proccnt;
-	}
-	else	// no processes in cgroup.procs
-	{
-		ccp->proclist = NULL;
-	}
+static char *
+readcgfile(int dirfd, char *fname)
+{
+	size_t	len = 0;
+	ssize_t	n;
+	int	fd;
 
-	// - fill basic info in current cgchainer
-	//
-	safe_strcpy(ccp->cstat->cgname, dirname, namelen+1);	// copy directory name
+	if ( (fd = openat(dirfd, fname, O_RDONLY|O_CLOEXEC)) == -1)
+		return NULL;
 
-	if (*dirname == '.')			// top directory?
+	while (1)
 	{
-		ccp->cstat->cgname[0] = '\0';	// wipe name
-		namelen               = 0;
-	}
-
-	hash = hashcalc(ccp->cstat->cgname, upperhash, upperlen);
+		// take care that at least one page (and the
+		// terminating null byte) fits in the buffer
+		//
+		if (cgfilesize - len < 4096 + 1)
+		{
+			cgfilesize = cgfilesize ? cgfilesize * 2 : 16384;
+			cgfilebuf  = realloc(cgfilebuf, cgfilesize);
+			ptrverify(cgfilebuf, "Malloc failed for cgroup file buffer\n");
+		}
 
-	ccp->cstat->gen.structlen   = cstatlen;
-	ccp->cstat->gen.sequence    = cgcursequence++;	// assign unique sequence number
-	ccp->cstat->gen.parentseq   = parentseq;
-	ccp->cstat->gen.depth       = depth;
-	ccp->cstat->gen.nprocs      = proccnt;
-	ccp->cstat->gen.namelen     = namelen;
-	ccp->cstat->gen.fullnamelen = upperlen + namelen; // excluding slashes
-	ccp->cstat->gen.namehash    = hash;
+		if ( (n = read(fd, cgfilebuf+len, cgfilesize-len-1)) <= 0)
+			break;
 
-	// - gather and store current cgroup configuration
-	//
-	getconfig(ccp->cstat, cparent ? cparent->cstat : NULL);
+		len += n;
+	}
 
-	// - gather and store current cgroup metrics
-	//
-	getmetrics(ccp->cstat);
+	close(fd);
 
-	// --------------------------------------------
-	// walk subdirectories by nested calls
-	// --------------------------------------------
-	//
-	dirp = opendir(".");
+	if (n == -1)
+		return NULL;
 
-	while ( (entp = readdir(dirp)) )
-	{
-		// skip dot files/directories
-		//
-		if (entp->d_name[0] == '.')
-			continue;
+	cgfilebuf[len] = '\0';
 
-		// check if this entry represents a subdirectory
-		// to be walked as well
-		//
-		if (entp->d_type == DT_DIR)
-			procsbelow += walkcgroup(entp->d_name,
-				ccp, ccp->cstat->gen.sequence,
-				hash, upperlen+namelen, depth+1);
-	}
+	return cgfilebuf;
+}
 
-	closedir(dirp);
+// Get the next line from a buffer: the newline is replaced
+// by a null byte and the buffer pointer is moved to the next line.
+//
+// Return value:	pointer to line
+//			NULL = no more lines
+//
+static char *
+nextline(char **bufp)
+{
+	char	*line = *bufp, *p;
 
-	if ( chdir("..") == -1)
-		return -1;
+	if (*line == '\0')
+		return NULL;
 
-	ccp->cstat->gen.procsbelow = procsbelow;
+	if ( (p = strchr(line, '\n')) )
+	{
+		*p    = '\0';
+		*bufp = p + 1;
+	}
+	else
+	{
+		*bufp = line + strlen(line);
+	}
 
-	return procsbelow + proccnt;
+	return line;
 }
 
 
@@ -407,71 +1394,82 @@ walkcgroup(char *dirname, struct cgchainer *cparent, int parentseq,
 // value -1:	maximum
 //
 static void
-getconfig(struct cstat *csp, struct cstat *csparent)
+getconfig(int dirfd, struct cgconf *conf)
 {
 	count_t	retvals[2];
 
 	// get cpu.weight 
 	//
-	csp->conf.cpuweight = -2;		// initial value (undefined)
+	conf->cpuweight = -2;		// initial value (undefined)
 
-	switch (readconfigval("cpu.weight", retvals))
+	switch (readconfigval(dirfd, "cpu.weight", retvals))
 	{
 	   case 1:
-		csp->conf.cpuweight = retvals[0];
+		conf->cpuweight = retvals[0];
 		break;
 	}
 
 	// get cpu.max limitation
 	//
-	csp->conf.cpumax = -2;			// initial value (undefined)
+	conf->cpumax = -2;			// initial value (undefined)
 
-	switch (readconfigval("cpu.max", retvals))
+	switch (readconfigval(dirfd, "cpu.max", retvals))
 	{
 	   case 2:
 		if (retvals[0] == -1)
-			csp->conf.cpumax = -1;	// max
+			conf->cpumax = -1;	// max
 		else
-			csp->conf.cpumax = retvals[0] * 100 / retvals[1];
+			conf->cpumax = retvals[0] * 100 / retvals[1];
 		break;
 	}
 
 	// get io.bpf.weight 
 	//
-	csp->conf.dskweight = -2;		// initial value (undefined)
+	conf->dskweight = -2;		// initial value (undefined)
 
-	switch (readconfigval("io.bfq.weight", retvals))
+	switch (readconfigval(dirfd, "io.bfq.weight", retvals))
 	{
 	   case 2:
-		csp->conf.dskweight = retvals[1];
+		conf->dskweight = retvals[1];
+		break;
+	}
+
+	// get pids.max limitation
+	//
+	conf->pidsmax = -2;		// initial value (undefined)
+
+	switch (readconfigval(dirfd, "pids.max", retvals))
+	{
+	   case 1:
+		conf->pidsmax = retvals[0];
 		break;
 	}
 
 	// get memory.max limitation
 	//
-	csp->conf.memmax = -2;			// initial value (undefined)
+	conf->memmax = -2;			// initial value (undefined)
 
-	switch (readconfigval("memory.max", retvals))
+	switch (readconfigval(dirfd, "memory.max", retvals))
 	{
 	   case 1:
 		if (retvals[0] == -1)
-			csp->conf.memmax = -1;	// max
+			conf->memmax = -1;	// max
 		else
-			csp->conf.memmax = retvals[0] / pagesize;
+			conf->memmax = retvals[0] / pagesize;
 		break;
 	}
 
 	// get memory.swap.max limitation
 	//
-	csp->conf.swpmax = -2;			// initial value (undefined)
+	conf->swpmax = -2;			// initial value (undefined)
 
-	switch (readconfigval("memory.swap.max", retvals))
+	switch (readconfigval(dirfd, "memory.swap.max", retvals))
 	{
 	   case 1:
 		if (retvals[0] == -1)
-			csp->conf.swpmax = -1;	// max
+			conf->swpmax = -1;	// max
 		else
-			csp->conf.swpmax = retvals[0] / pagesize;
+			conf->swpmax = retvals[0] / pagesize;
 		break;
 	}
 }
@@ -484,24 +1482,15 @@ getconfig(struct cstat *csp, struct cstat *csparent)
 // return value:	number of entries in retvals filled
 //
 static int
-readconfigval(char *fname, count_t retvals[])
+readconfigval(int dirfd, char *fname, count_t retvals[])
 {
-	char line[64];
+	char *line;
 	int  n;
-	FILE *fp;
 
-	if ( (fp = fopen(fname, "r")) )
+	if ( (line = readcgfile(dirfd, fname)) )
 	{
 		char firststr[16];
 
-		if (!fgets(line, sizeof line, fp))
-		{
-			fclose(fp);
-			return 0;
-		}
-
-		fclose(fp);
-
 		switch (n = sscanf(line, "%15s %llu", firststr, &retvals[1]))
 		{
 		   case 0:
@@ -525,150 +1514,138 @@ readconfigval(char *fname, count_t retvals[])
 // Gather metrics for one specific cgroup
 //
 static void
-getmetrics(struct cstat *csp)
+getmetrics(int dirfd, struct cstat *csp)
 {
-	FILE	*fp;
-	char	line[256];
-	int	cnt;
+	char	*buf;
 
 	// gather CPU metrics
 	//
-	csp->cpu.utime = -1;	// undefined
-	csp->cpu.stime = -1;	// undefined
-	cnt = 0;
+	cgkeyundef(&cpustatkeys, csp);
 
-	if ( (fp = fopen("cpu.stat", "r")) )
-	{
-		while (fgets(line, sizeof line, fp) && cnt < 2)
-		{
-			if (memcmp(line, "user_usec ", 10) == 0)
-			{
-				sscanf(line, "user_usec %lld", &(csp->cpu.utime));
-				cnt++;
-				continue;
-			}
-
-			if (memcmp(line, "system_usec ", 12) == 0)
-			{
-				sscanf(line, "system_usec %lld", &(csp->cpu.stime));
-				cnt++;
-				continue;
-			}
-                }
-
-		fclose(fp);
-	}
+	if ( (buf = readcgfile(dirfd, "cpu.stat")) )
+		cgkeyparse(&cpustatkeys, buf, csp);
 
-	getpressure("cpu.pressure", &(csp->cpu.somepres), &(csp->cpu.fullpres));
+	getpressure(dirfd, "cpu.pressure", &(csp->cpu.somepres), &(csp->cpu.fullpres));
 
 	// gather memory metrics
 	//
 	csp->mem.current = -1;	// undefined
 
-	csp->mem.anon    = -1;	// undefined
-	csp->mem.file    = -1;	// undefined
-	csp->mem.kernel  = -1;	// undefined
-	csp->mem.shmem   = -1;	// undefined
+	cgkeyundef(&memstatkeys, csp);
 
-	cnt = 0;
+	if ( (buf = readcgfile(dirfd, "memory.current")) )
+		csp->mem.current = strtoll(buf, NULL, 10) / pagesize;
 
-	if ( (fp = fopen("memory.current", "r")) )
-	{
-		if (fgets(line, sizeof line, fp) != NULL)
-			csp->mem.current = strtoll(line, NULL, 10) / pagesize;
+	if ( (buf = readcgfile(dirfd, "memory.stat")) )
+		cgkeyparse(&memstatkeys, buf, csp);
 
-		fclose(fp);
-	}
+	cgkeyundef(&memeventkeys, csp);
 
-	if ( (fp = fopen("memory.stat", "r")) )
-	{
-		while (fgets(line, sizeof line, fp) && cnt < 4)
-		{
-			if (memcmp(line, "anon ", 5) == 0)
-			{
-				sscanf(line, "anon %lld", &(csp->mem.anon));
-				csp->mem.anon /= pagesize;
-				cnt++;
-				continue;
-			}
+	if ( (buf = readcgfile(dirfd, "memory.events")) )
+		cgkeyparse(&memeventkeys, buf, csp);
 
-			if (memcmp(line, "file ", 5) == 0)
-			{
-				sscanf(line, "file %lld", &(csp->mem.file));
-				csp->mem.file /= pagesize;
-				cnt++;
-				continue;
-			}
+	getpressure(dirfd, "memory.pressure", &(csp->mem.somepres), &(csp->mem.fullpres));
 
-			if (memcmp(line, "kernel ", 7) == 0)
-			{
-				sscanf(line, "kernel %lld", &(csp->mem.kernel));
-				csp->mem.kernel /= pagesize;
-				cnt++;
-				continue;
-			}
+	// gather number of tasks (pids controller)
+	//
+	csp->gen.nrtasks = -1;	// undefined
 
-			if (memcmp(line, "shmem ", 6) == 0)
-			{
-				sscanf(line, "shmem %lld", &(csp->mem.shmem));
-				csp->mem.shmem /= pagesize;
-				cnt++;
-				continue;
-			}
-                }
+	if ( (buf = readcgfile(dirfd, "pids.current")) )
+		csp->gen.nrtasks = strtol(buf, NULL, 10);
 
-		fclose(fp);
+	// gather disk I/O metrics
+	//
+	if ( (buf = readcgfile(dirfd, "io.stat")) )
+	{
+		getiostat(buf, csp);
+	}
+	else
+	{
+		csp->dsk.rbytes = -1;	// undefined
+		csp->dsk.wbytes = -1;	// undefined
+		csp->dsk.rios   = -1;	// undefined
+		csp->dsk.wios   = -1;	// undefined
+		csp->dsk.ndisks = 0;
 	}
 
-	getpressure("memory.pressure", &(csp->mem.somepres), &(csp->mem.fullpres));
+	getpressure(dirfd, "io.pressure", &(csp->dsk.somepres), &(csp->dsk.fullpres));
+}
+
+// Get the disk I/O metrics from the contents of io.stat
+// with a format similar to:
+//
+//     253:2 rbytes=2544128 wbytes=2192896 rios=313 wios=22 dbytes=0 dios=0
+//     253:1 rbytes=143278080 wbytes=3843604480 rios=34222 wios=853554 ...
+//     253:0 rbytes=19492288000 wbytes=105266814976 rios=386493 wios=1691322
+//     11:0
+//     8:0 rbytes=328956266496 wbytes=109243312640 rios=764129 wios=1415575
+//
+// The totals are accumulated for the physical disks only, and
+// the first CGMAXDISK physical disks are stored separately as well.
+//
+static void
+getiostat(char *buf, struct cstat *csp)
+{
+	struct cgperdsk	perdsk, *pdp;
+	struct cgkey	*kp;
+	char		*line, *key, *val, *p;
+	int		keylen;
 
-	// gather disk I/O metrics
-	//
-	//     253:2 rbytes=2544128 wbytes=2192896 rios=313 wios=22 dbytes=0 dios=0
-	//     253:1 rbytes=143278080 wbytes=3843604480 rios=34222 wios=853554 ...
-	//     253:0 rbytes=19492288000 wbytes=105266814976 rios=386493 wios=1691322
-	//     11:0
-	//     8:0 rbytes=328956266496 wbytes=109243312640 rios=764129 wios=1415575
-	//
 	csp->dsk.rbytes = 0;
 	csp->dsk.wbytes = 0;
 	csp->dsk.rios   = 0;
 	csp->dsk.wios   = 0;
+	csp->dsk.ndisks = 0;
+
+	while ((line = nextline(&buf)))
+	{
+		memset(&perdsk, 0, sizeof perdsk);
+
+		perdsk.major = strtol(line, &p, 10);
+
+		if (*p != ':')
+			continue;
+
+		perdsk.minor = strtol(p+1, &p, 10);
+
+		if (isdisk_major(perdsk.major) != DSKTYPE)
+			continue;
+
+		// handle the 'key=value' pairs of this disk
+		//
+		while (*p)
+		{
+			while (*p == ' ')
+				p++;
 
-	if ( (fp = fopen("io.stat", "r")) )
-	{
-		int	major, minor;
-		count_t	rbytes, wbytes, rios, wios;
+			for (key=p; *p && *p != '=' && *p != ' '; p++)
+				;
 
-		while (fgets(line, sizeof line, fp))
-		{
-			if (sscanf(line,
-				"%d:%d rbytes=%lld wbytes=%lld rios=%lld wios=%lld",
-					&major, &minor,
-					&rbytes, &wbytes, &rios, &wios) == 6)
-			{
-				if (isdisk_major(major) == DSKTYPE)
-				{
-					csp->dsk.rbytes += rbytes;
-					csp->dsk.wbytes += wbytes;
+			if (*p != '=')
+				continue;
 
-					csp->dsk.rios   += rios;
-					csp->dsk.wios   += wios;
-				}
-			}
+			keylen = p - key;
+			val    = p + 1;
+
+			for (p=val; *p && *p != ' '; p++)
+				;
+
+			if ( (kp = cgkeyfind(&iostatkeys, key, keylen)) )
+				*(count_t *)((char *)&perdsk + kp->offset) =
+						strtoll(val, NULL, 10);
 		}
 
-		fclose(fp);
-	}
-	else
-	{
-		csp->dsk.rbytes = -1;	// undefined
-		csp->dsk.wbytes = -1;	// undefined
-		csp->dsk.rios   = -1;	// undefined
-		csp->dsk.wios   = -1;	// undefined
-	}
+		csp->dsk.rbytes += perdsk.rbytes;
+		csp->dsk.wbytes += perdsk.wbytes;
+		csp->dsk.rios   += perdsk.rios;
+		csp->dsk.wios   += perdsk.wios;
 
-	getpressure("io.pressure", &(csp->dsk.somepres), &(csp->dsk.fullpres));
+		if (csp->dsk.ndisks < CGMAXDISK)
+		{
+			pdp  = &(csp->dsk.disks[csp->dsk.ndisks++]);
+			*pdp = perdsk;
+		}
+	}
 }
 
 // Get total pressure values from file with a format similar to:
@@ -677,88 +1654,110 @@ getmetrics(struct cstat *csp)
 //     full avg10=0.00 avg60=0.00 avg300=0.00 total=9376892229 
 //
 static void
-getpressure(char *fname, count_t *some, count_t *full)
+getpressure(int dirfd, char *fname, count_t *some, count_t *full)
 {
 	char 	psiformat[] = "%c%*s avg10=%f avg60=%f avg300=%f total=%lld",
-		linebuf[256], psitype;
+		*buf, *line, psitype;
 	float	a10, a60, a300;
-	FILE	*fp;
 
 	*some = -1;	// initially undefined
 	*full = -1;	// initially undefined
 
-	if ( (fp = fopen(fname, "r")) != NULL)
+	if ( (buf = readcgfile(dirfd, fname)) != NULL)
 	{
 		// handle first line: 'some' pressure
 		//
-		if ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
+		if ( (line = nextline(&buf)) != NULL)
 		{
-			sscanf(linebuf, psiformat,
+			sscanf(line, psiformat,
 				&psitype, &a10, &a60, &a300, some);
                 }
 
 		// handle second line: 'full' pressure
 		//
-		if ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
+		if ( (line = nextline(&buf)) != NULL)
 		{
-			sscanf(linebuf, psiformat,
+			sscanf(line, psiformat,
 				&psitype, &a10, &a60, &a300, full);
                 }
-
-		fclose(fp);
 	}
 }
 
 
-// Calculate deviations between current cgroup chain and
-// previous cgroup chain.
-// Notice that the deviation chain structure is identical to
-// the current chain structure, so they can be walked alongside.
-// Also the deviation cstat struct is already a copy of the current
-// cstat structure.
+// Cumulative counters in the cstat struct for which the
+// deviation with the previous sample is calculated
+// (only when defined in both samples)
+//
+static const unsigned short cgdeltaoffs[] = {
+	offsetof(struct cstat, cpu.utime),
+	offsetof(struct cstat, cpu.stime),
+	offsetof(struct cstat, cpu.somepres),
+	offsetof(struct cstat, cpu.fullpres),
+	offsetof(struct cstat, cpu.nrthrottled),
+	offsetof(struct cstat, cpu.thrtime),
+
+	offsetof(struct cstat, mem.somepres),
+	offsetof(struct cstat, mem.fullpres),
+	offsetof(struct cstat, mem.pgmajflt),
+	offsetof(struct cstat, mem.wsrefault),
+	offsetof(struct cstat, mem.evhigh),
+	offsetof(struct cstat, mem.evmax),
+	offsetof(struct cstat, mem.evoom),
+	offsetof(struct cstat, mem.evoomkill),
+
+	offsetof(struct cstat, dsk.rbytes),
+	offsetof(struct cstat, dsk.wbytes),
+	offsetof(struct cstat, dsk.rios),
+	offsetof(struct cstat, dsk.wios),
+	offsetof(struct cstat, dsk.somepres),
+	offsetof(struct cstat, dsk.fullpres),
+};
+
+#define	CGNDELTA	(sizeof cgdeltaoffs / sizeof cgdeltaoffs[0])
+#define	CGCOUNTER(csp, off)	((count_t *)((char *)(csp) + (off)))
+
+// Calculate deviations between current cgroup snapshot and
+// previous cgroup snapshot.
+// The deviation arena contains a copy of the current cstat structs
+// that are walked in one pass through the contiguous memory.
+// When no cgroups have been added or removed since the previous
+// sample, the cstat structs of the previous arena have the same
+// order and are walked alongside (insync). Otherwise a hash list
+// is built for the previous chain to find the correct entry based
+// on the hashed name.
 //
 static void
 cgcalcdeviate(void)
 {
-	struct cgchainer	*dp, *pp;
-	int			insync = 1, prevfound;
-
-	// walk thru the deviation chain and calculate the differences
-	// with the previous chain
-	//
-	// when no cgroups have been added or removed since the
-	// previous sample, we might assume that the previous chain
-	// has the same order of elements as the deviation chain (insync)
-	//
-	// when cgroups have been added or removed since the
-	// previous sample (!insync), we build a hash list for the
-	// previous chain to find the correct entry based on the hashed name
-	//
-	cgrewind(&cgdevcursor);
-	cgrewind(&cgprecursor);
-
-	while ( (dp = cgnext(&cgdevfirst, &cgdevcursor)) )
+	struct cgarena		*dap = &cgdevarena, *pap = cgprearena;
+	struct cgchainer	*pp;
+	struct cstat		*dcs, *pcs;
+	unsigned long		doff, poff = 0;
+	count_t			*dcp, pval;
+	int			ic, id, insync = 1;
+
+	for (ic=0, doff=0; ic < dap->nchain; ic++, doff += dcs->gen.structlen)
 	{
-		// find previous cgroup struct
-		//
-		prevfound = 0;
+		dcs = CGCSTAT(dap, doff);
+		pcs = NULL;
 
+		// find previous cstat struct
+		//
 		if (insync)
 		{
-			// assume unchanged cgroup chain: take next from previous chain
-			//
-			pp = cgnext(&cgprefirst, &cgprecursor);
-
-			if (pp && dp->cstat->gen.namehash == pp->cstat->gen.namehash)
+			if (ic < pap->nchain &&
+			    CGCSTAT(pap, poff)->gen.namehash == dcs->gen.namehash)
 			{
-				prevfound = 1;
+				pcs   = CGCSTAT(pap, poff);
+				poff += pcs->gen.structlen;
 			}
 			else
 			{
 				insync = 0;
 
-				// build hash list for previous chain to find names
-				// based on hashed name for the rest of this loop
+				// build hash list for previous chain to find
+				// names based on hashed name for the rest
+				// of this loop
 				//
 				cgrewind(&cgprecursor);
 
@@ -769,49 +1768,61 @@ cgcalcdeviate(void)
 
 		if (!insync)
 		{
-			// modified cgroup chain: search previous by name hash
-			//
-			if ( (pp = hashfind(cgprehash, dp->cstat->gen.namehash)) )
-				prevfound = 1;
+			if ( (pp = hashfind(cgprehash, dcs->gen.namehash)) )
+				pcs = pp->cstat;
 		}
 
+		if (!pcs)	// new cgroup
+			continue;
+
 		// calculate deviations related to previous sample
 		//
-		if (prevfound)
+		for (id=0; id < CGNDELTA; id++)
 		{
-			if (dp->cstat->cpu.utime != -1)		// defined?
-				dp->cstat->cpu.utime	-= pp->cstat->cpu.utime;
+			dcp  = CGCOUNTER(dcs, cgdeltaoffs[id]);
+			pval = *CGCOUNTER(pcs, cgdeltaoffs[id]);
 
-			if (dp->cstat->cpu.stime != -1)		// defined?
-				dp->cstat->cpu.stime	-= pp->cstat->cpu.stime;
-
-			if (dp->cstat->cpu.somepres != -1)	// defined?
-				dp->cstat->cpu.somepres	-= pp->cstat->cpu.somepres;
-
-			if (dp->cstat->cpu.fullpres != -1)	// defined?
-				dp->cstat->cpu.fullpres	-= pp->cstat->cpu.fullpres;
-
-
-			if (dp->cstat->mem.somepres != -1)	// defined?
-				dp->cstat->mem.somepres	-= pp->cstat->mem.somepres;
+			if (*dcp != -1 && pval != -1)	// both defined?
+				*dcp -= pval;
+		}
 
-			if (dp->cstat->mem.fullpres != -1)	// defined?
-				dp->cstat->mem.fullpres	-= pp->cstat->mem.fullpres;
+		if (dcs->dsk.ndisks)
+			cgdskdeviate(&(dcs->dsk), &(pcs->dsk));
+	}
+}
 
+// Calculate the deviations per physical disk
+// (disks are matched on major/minor number); a disk that is not
+// present in the previous sample (e.g. beyond CGMAXDISK) has no
+// known deviation, so its counters are cleared instead of showing
+// the cumulative values as activity during the interval
+//
+static void
+cgdskdeviate(struct cgdsk *dp, struct cgdsk *pp)
+{
+	struct cgperdsk	*ddp, *pdp;
+	int		i, j;
 
-			if (dp->cstat->dsk.rbytes != -1)	// defined?
+	for (i=0, ddp=dp->disks; i < dp->ndisks; i++, ddp++)
+	{
+		for (j=0, pdp=pp->disks; j < pp->ndisks; j++, pdp++)
+		{
+			if (ddp->major == pdp->major && ddp->minor == pdp->minor)
 			{
-				dp->cstat->dsk.rbytes	-= pp->cstat->dsk.rbytes;
-				dp->cstat->dsk.wbytes	-= pp->cstat->dsk.wbytes;
-				dp->cstat->dsk.rios	-= pp->cstat->dsk.rios;
-				dp->cstat->dsk.wios	-= pp->cstat->dsk.wios;
+				ddp->rbytes -= pdp->rbytes;
+				ddp->wbytes -= pdp->wbytes;
+				ddp->rios   -= pdp->rios;
+				ddp->wios   -= pdp->wios;
+				break;
 			}
+		}
 
-			if (dp->cstat->dsk.somepres != -1)	// defined?
-				dp->cstat->dsk.somepres	-= pp->cstat->dsk.somepres;
-
-			if (dp->cstat->dsk.fullpres != -1)	// defined?
-				dp->cstat->dsk.fullpres	-= pp->cstat->dsk.fullpres;
+		if (j == pp->ndisks)	// not found in previous sample?
+		{
+			ddp->rbytes = 0;
+			ddp->wbytes = 0;
+			ddp->rios   = 0;
+			ddp->wios   = 0;
 		}
 	}
 }
@@ -846,100 +1857,59 @@ cgnext(struct cgchainer **first, struct cgchainer **cursor)
 void
 cgwipecur(void)
 {
-	cgwipe(&cgcurfirst, &cgcurlast, &cgcurcursor, NULL);
-}
-
-
-// Wipe all struct's from cgroup admi
-//
-static void
-cgwipe(struct cgchainer **first,  struct cgchainer **last,
-       struct cgchainer **cursor, struct cgchainer **hashlist)
-{
-	struct cgchainer *cp, *cpn;
-
-	if (! *first)	// empty already?
-		return;
+	cgarenareset(cgcurarena);
 
-	// free all chain members
-	//
-	for (cp=*first; cp; cp=cpn)
-	{
-		cpn = cp->next;
-
-		free(cp->proclist);
-
-		free(cp->cstat);
-		free(cp);
-	}
-
-	*first = *last = *cursor = NULL;
-
-	if (hashlist)
-		memset(hashlist, 0, sizeof(struct cgchainer *) * CGROUPNHASH);
+	cgcurfirst = NULL;
 }
 
 
-// Create enough memory to copy all cstat structures from
-// the current list to one contiguous area.
-// Also create enough memory to copy all pid lists from
-// the current list to one contiguous area.
-// Next, create and fill an array of cgchainer structs.
+// Copy all cstat structures from the current arena to
+// the deviation arena (one contiguous copy) and build the
+// array of cgchainer structs referring to them.
+// The pid lists are not modified, so the deviation
+// cgchainer structs refer to the pid lists in the current arena
+// (that is kept as previous arena until the next sample has been taken).
 //
 // Returns:	number of cgchainer structs
 //
 int
 deviatcgroup(struct cgchainer **cdpp, int *npids)
 {
-	struct cgchainer	*ccp = cgcurfirst;
-	char			*allc, *allp, *cp, *pp;
+	struct cgarena	*ap = cgcurarena, *dp = &cgdevarena;
 
-	// allocate contiguous memory areas for all cstat structs
-	// and all pid lists
-	//
-	allc = calloc(1, cgcursize);
-	allp = malloc(sizeof(pid_t) * cgcurprocs);
+	*cdpp  = NULL;
+	*npids = 0;
 
-	ptrverify(allc, "Malloc failed for contiguous cstats (%d bytes)\n", cgcursize);
-	ptrverify(allp, "Malloc failed for contiguous pids (%d pids)\n", cgcurprocs);
+	if (ap->nchain == 0)
+		return 0;
 
-	// concatenate all current cstat structs and all pid lists
-	// into the new memory areas
+	// allocate space in deviation arena and copy cstat structs
 	//
-	ccp = cgcurfirst;
-	cp  = allc;
-	pp  = allp;
-
-	while (ccp)
-	{
-		int cstatlen = ccp->cstat->gen.structlen;
-		int plistlen = ccp->cstat->gen.nprocs * sizeof(pid_t);
+	cgarenareset(dp);
 
-		memcpy(cp, ccp->cstat, cstatlen);
-		cp += cstatlen;
+	while (dp->nchain < ap->nchain)
+		cgarenachain(dp);
 
-		if (ccp->proclist)
-		{
-			memcpy(pp, ccp->proclist, plistlen);
-			pp += plistlen;
-		}
+	cgarenacstat(dp, ap->cstatlen);
 
-		ccp = ccp->next;
-	}
+	memcpy(dp->cstats, ap->cstats, ap->cstatlen);
 
-	// build array of cgchainer structs and a hash list for the
-	// concatenated cstat structs for the deviation values
+	// build array of cgchainer structs for the deviation values
 	//
-	cgbuildarray(&cgdevfirst, allc, allp, cgcurnum);
+	cglinkarray(dp->chain, dp->nchain, dp->cstats, (char *)ap->pids);
+
+	cgdevfirst = dp->chain;
+
+	cgpidinvalidate();
 
 	// calculate deviation values
 	//
 	cgcalcdeviate();
 
 	*cdpp  = cgdevfirst;
-	*npids = cgcurprocs;
+	*npids = ap->npids;
 
-	return cgcurnum;
+	return ap->nchain;
 }
 
 
@@ -949,17 +1919,32 @@ deviatcgroup(struct cgchainer **cdpp, int *npids)
 //
 void
 cgbuildarray(struct cgchainer **firstp, char *cstats, char *pids, int ncstats)
+{
+	*firstp = calloc(ncstats, sizeof(struct cgchainer));
+	ptrverify(*firstp, "Malloc failed for contiguous cgchainers (%d)\n", ncstats);
+
+	cglinkarray(*firstp, ncstats, cstats, pids);
+
+	cgpidinvalidate();
+}
+
+
+// Fill an array of cgchainer structs: chain them and let every
+// entry refer to the proper location in the concatenated cstat structs
+// and the concatenated pid lists.
+//
+static void
+cglinkarray(struct cgchainer *first, int ncstats, char *cstats, char *pids)
 {
 	struct cgchainer	*cdp;
 	int			i;
 
-	*firstp = malloc(sizeof(struct cgchainer) * ncstats);
-	ptrverify(firstp, "Malloc failed for contiguous cgchainers (%d)\n", ncstats);
-
-	for (cdp=*firstp, i=0; i < ncstats; cdp++, i++)
+	for (cdp=first, i=0; i < ncstats; cdp++, i++)
 	{
-		cdp->next     = cdp+1;
-		cdp->hashnext = NULL;
+		cdp->next      = cdp+1;
+		cdp->hashnext  = NULL;
+		cdp->vlinemask = 0;
+		cdp->stub      = 0;
 
 		cdp->proclist = (pid_t *)pids;
 		pids += sizeof(pid_t) * ((struct cstat *)cstats)->gen.nprocs;
@@ -968,7 +1953,7 @@ cgbuildarray(struct cgchainer **firstp, char *cstats, char *pids, int ncstats)
 		cstats += ((struct cstat *)cstats)->gen.structlen;
 	}
 
-	cdp = *firstp + ncstats - 1;
+	cdp = first + ncstats - 1;
 	cdp->next = NULL;	// terminate chain
 }
 
@@ -1434,28 +2419,41 @@ struct cgsorter {
 	struct cgsorter 	**sortlist;
 	count_t			sortval;
 	int			nrchild;
+	char			visible;	// not suppressed by filter
 };
 
 static struct cgsorter		cgroot;		// struct for root with depth zero
+static int			cgsortmax;	// max entries to be sorted per level
+						// (0 = all)
 
 static struct cgchainer *sortlevel(int, struct cgsorter *, struct cgchainer *, int, char);
 static struct cgchainer **mergelevels(struct cgsorter *, int);
 static int		mergelevel(struct cgsorter *, struct cgchainer **, unsigned long);
 static void		createsortlist(struct cgsorter *);
 static int              compsortval(const void *, const void *);
+static void		partialsort(struct cgsorter **, int, int);
 
 
 // Main function to create a list of pointers to cgchainer structs,
 // in the order of resource consumption while maintaining
 // the proper cgroup directory structure.
 //
+// When only the first 'maxsorted' lines of the list will be shown,
+// only the 'maxsorted' highest consumers per directory level are
+// sorted (a cgroup with a higher index on its level can never be
+// shown in these first lines), while the other cgroups of that level
+// follow in arbitrary order. A value zero for 'maxsorted' means
+// that all cgroups are sorted.
+//
 // Return value: list with sorted pointers to cgchainer structs
 //
 struct cgchainer **
-cgsort(struct cgchainer *cgphys, int cgsize, char showresource)
+cgsort(struct cgchainer *cgphys, int cgsize, char showresource, int maxsorted)
 {
 	struct cgchainer **cgsorted;
 
+	cgsortmax = maxsorted;
+
 	// reinitialize the root cgsorter struct and fill
 	// the pointer to the root cgchainer
 	//
@@ -1527,6 +2525,8 @@ sortlevel(int curlevel, struct cgsorter *cgparent,
 			cgs->cgsame  = cgparent->cgchild;
 			cgs->cgchild = 0;
 			cgs->nrchild = 0;
+			cgs->visible = cgroupfilter(cgc->cstat, cgroupdepth,
+								showresource);
 
 			switch (showresource)
 			{
@@ -1608,14 +2608,76 @@ createsortlist(struct cgsorter *cgparent)
 		}
 
 		// sort list on sort value
+		// (only the highest consumers if not all are shown)
 		//
-		qsort(cgparent->sortlist, cgparent->nrchild,
-			sizeof(struct cgsorter *), compsortval);
+		if (cgsortmax && cgsortmax < cgparent->nrchild)
+			partialsort(cgparent->sortlist, cgparent->nrchild,
+								cgsortmax);
+		else
+			qsort(cgparent->sortlist, cgparent->nrchild,
+				sizeof(struct cgsorter *), compsortval);
+	}
+}
+
+// Partially sort a list of cgsorter pointers: the first 'nsort'
+// entries will be the highest consumers in sorted order, while
+// the remaining entries follow in arbitrary order.
+// The selection is done via a bounded min-heap with the 'nsort'
+// highest consumers found so far (heap top is the lowest of them).
+//
+static void
+partialsort(struct cgsorter **list, int nlist, int nsort)
+{
+	struct cgsorter	*tmp;
+	int		i, parent, child;
+
+	// build min-heap of the first 'nsort' entries
+	//
+	for (i=1; i < nsort; i++)
+	{
+		for (child=i; child > 0; child=parent)
+		{
+			parent = (child-1) / 2;
+
+			if (compsortval(&list[parent], &list[child]) >= 0)
+				break;
+
+			tmp = list[parent]; list[parent] = list[child]; list[child] = tmp;
+		}
+	}
+
+	// replace the heap top by every higher consumer
+	// in the rest of the list
+	//
+	for (i=nsort; i < nlist; i++)
+	{
+		if (compsortval(&list[i], &list[0]) >= 0)
+			continue;
+
+		tmp = list[0]; list[0] = list[i]; list[i] = tmp;
+
+		for (parent=0; (child = parent*2+1) < nsort; parent=child)
+		{
+			if (child+1 < nsort &&
+			    compsortval(&list[child+1], &list[child]) > 0)
+				child++;
+
+			if (compsortval(&list[child], &list[parent]) <= 0)
+				break;
+
+			tmp = list[parent]; list[parent] = list[child]; list[child] = tmp;
+		}
 	}
+
+	// sort the selected entries
+	//
+	qsort(list, nsort, sizeof(struct cgsorter *), compsortval);
 }
 
 // Function to be called by qsort() to compare
 // the sortvalue in two cgsorter structs
+// (cgroups that will be suppressed are sorted behind
+// the visible cgroups)
 //
 static int
 compsortval(const void *a, const void *b)
@@ -1623,6 +2685,9 @@ compsortval(const void *a, const void *b)
         struct cgsorter *cga = *(struct cgsorter **)a;
         struct cgsorter *cgb = *(struct cgsorter **)b;
 
+	if (cga->visible != cgb->visible)
+		return cga->visible ? -1 : 1;
+
 	if (cga->sortval < cgb->sortval)
 		return 1;
 	if (cga->sortval > cgb->sortval)
@@ -1736,80 +2801,319 @@ mergelevel(struct cgsorter *cgparent, struct cgchainer **cgpp,
 
 
 // ===========================================================
-// PID hashing to find the cgroup that is related to
+// PID index to find the cgroup that is related to
 // a particular process 
 // ===========================================================
-struct pid2cgchainer {
-	struct pid2cgchainer	*hashnext;
-	pid_t			pid;
-	int			cgindex;	// cgchainer index
+// the index is an open addressing hash table (linear probing)
+// that is kept between samples and that only grows when needed;
+// it is (re)built at most once per snapshot, at the moment that
+// the first consumer needs it
+//
+struct pid2cgindex {
+	pid_t	pid;		// zero for unused slot
+	int	cgindex;	// cgchainer index
 };
 
-// For every tstat struct, fill the reference (index) to
-// the related cgroup, represented by the cgchainer struct
+static struct pid2cgindex	*cgpidindex;
+static unsigned long		cgpidsize;	// number of slots (power of 2)
+static int			cgpidvalid;	// index matches current snapshot
+
+static void	cgpidbuild(struct cgchainer *, int, int);
+static int	cgpidlookup(pid_t);
+
+// Invalidate the PID index (new snapshot)
 //
-void
-cgfillref(struct devtstat *devtstat, struct cgchainer *devchain,
-					int ncgroups, int npids)
+static void
+cgpidinvalidate(void)
+{
+	cgpidvalid = 0;
+}
+
+// Build the PID index for the given snapshot
+//
+static void
+cgpidbuild(struct cgchainer *devchain, int ncgroups, int npids)
 {
-	int			ic, ip, it, hash;
+	unsigned long		newsize, slot;
+	int			ic, ip;
 	pid_t			pid;
-	struct pid2cgchainer	*pidhash[PIDNHASH], *pidlist, *pidcur;
 	struct cgchainer	*cp;
-	struct tstat		*tp = devtstat->taskall;
 
-	// create a hashlist to find the PIDs in a fast way
-	// initialize hash list
+	// take care that at most half of the slots will be used
 	//
-	memset(pidhash, 0, sizeof pidhash);
+	for (newsize = cgpidsize ? cgpidsize : 1024; newsize < npids * 2UL;)
+		newsize *= 2;
 
-	// create one pid2cgchainer struct per cgroup pid
-	//
-	pidlist = calloc(npids, sizeof(struct pid2cgchainer));
+	if (newsize != cgpidsize)
+	{
+		free(cgpidindex);
 
-	ptrverify(pidlist, "Malloc for pid2cgchainer structs failed (%d)\n", npids);
+		cgpidindex = malloc(newsize * sizeof(struct pid2cgindex));
+		ptrverify(cgpidindex, "Malloc for PID index failed (%lu)\n", newsize);
 
-	// build hash list to find right cgchainer (cgroup) for a PID
-	//
-	for (ic=0, cp=devchain, pidcur=pidlist; ic < ncgroups; ic++, cp++)
+		cgpidsize = newsize;
+	}
+
+	memset(cgpidindex, 0, cgpidsize * sizeof(struct pid2cgindex));
+
+	for (ic=0, cp=devchain; ic < ncgroups; ic++, cp++)
 	{
-		for (ip=0;  ip < cp->cstat->gen.nprocs; ip++, pidcur++)
+		for (ip=0; ip < cp->cstat->gen.nprocs; ip++)
 		{
 			pid  = cp->proclist[ip];
-			hash = pid & PIDMASK;
 
-			pidcur->hashnext = pidhash[hash];
-			pidcur->pid      = pid;
-			pidcur->cgindex  = ic;
+			if (pid <= 0)
+				continue;
 
-			pidhash[hash]    = pidcur;
+			for (slot = pid & (cgpidsize-1);
+			     cgpidindex[slot].pid && cgpidindex[slot].pid != pid;
+			     slot = (slot+1) & (cgpidsize-1))
+				;
+
+			cgpidindex[slot].pid     = pid;
+			cgpidindex[slot].cgindex = ic;
 		}
 	}
 
+	cgpidvalid = 1;
+}
+
+// Search the cgchainer index related to a PID
+//
+// Returns:	cgchainer index or -1 (not found)
+//
+static int
+cgpidlookup(pid_t pid)
+{
+	unsigned long	slot;
+
+	if (pid <= 0 || !cgpidsize)
+		return -1;
+
+	for (slot = pid & (cgpidsize-1); cgpidindex[slot].pid;
+	     slot = (slot+1) & (cgpidsize-1))
+	{
+		if (cgpidindex[slot].pid == pid)
+			return cgpidindex[slot].cgindex;
+	}
+
+	return -1;
+}
+
+// For every tstat struct, fill the reference (index) to
+// the related cgroup, represented by the cgchainer struct
+//
+void
+cgfillref(struct devtstat *devtstat, struct cgchainer *devchain,
+					int ncgroups, int npids)
+{
+	int		it;
+	struct tstat	*tp = devtstat->taskall;
+
+	// build the PID index once per snapshot
+	//
+	if (!cgpidvalid)
+		cgpidbuild(devchain, ncgroups, npids);
+
 	// connect every tstat struct to the concerning cgchainer
 	// by filling the index
 	//
 	for (it=0; it < devtstat->ntaskall; it++, tp++)
 	{
-		tp->gen.cgroupix = -1;
-
 		if (! tp->gen.isproc)	// skip threads
+		{
+			tp->gen.cgroupix = -1;
 			continue;
+		}
+
+		tp->gen.cgroupix = cgpidlookup(tp->gen.pid);
+	}
+}
 
-		pid  = tp->gen.pid;
-		hash = pid & PIDMASK;
 
-		// search for cgchainer index related to this PID via hashlist
-		//
-		for (pidcur=pidhash[hash]; pidcur; pidcur=pidcur->hashnext)
+// - process collection limited to selected cgroup subtrees
+//   ------------------------------------------------------
+//   when the keyword 'cgroupprocs' is defined in the atoprc file,
+//   only the processes in the cgroup.procs files of the selected
+//   subtrees are gathered by photoproc(), instead of all processes
+//   found in /proc
+//
+struct cgselpath {
+	char	*path;		// normalized path (leading slash)
+	long	namehash;	// hash like gen.namehash
+	int	fullnamelen;	// like gen.fullnamelen (without slashes)
+	int	depth;		// like gen.depth
+};
+
+static struct cgselpath	*cgselpaths;
+static int		ncgselpaths;
+
+static pid_t		*cgselpids;	// reusable pid buffer
+static unsigned long	cgselmaxpids;
+
+static char		*cgselected;	// boolean per cgroup (sequence)
+static int		cgselmaxcg;
+
+// Add a cgroup path to the selection, normalized to a leading slash,
+// no trailing slash and no double slashes
+//
+static void
+cgseladd(char *path)
+{
+	struct cgselpath	*sp;
+	char			*norm, *p, *q;
+
+	norm = malloc(strlen(path) + 2);
+
+	ptrverify(norm, "Malloc failed for cgroup path %s\n", path);
+
+	for (p=path, q=norm; *p; p++)
+	{
+		if (*p == '/' && (q > norm && *(q-1) == '/'))
+			continue;
+
+		if (q == norm && *p != '/')
+			*q++ = '/';
+
+		*q++ = *p;
+	}
+
+	if (q == norm)
+		*q++ = '/';
+
+	if (q > norm+1 && *(q-1) == '/')	// strip trailing slash
+		q--;
+
+	*q = '\0';
+
+	cgselpaths = realloc(cgselpaths, (ncgselpaths+1) * sizeof *cgselpaths);
+
+	ptrverify(cgselpaths, "Malloc failed for %d cgroup paths\n",
+							ncgselpaths+1);
+
+	sp = cgselpaths + ncgselpaths++;
+
+	sp->path        = norm;
+	sp->namehash    = hashcalc(norm, 0, 0);
+	sp->fullnamelen = 0;
+	sp->depth       = 0;
+
+	for (p=norm; *p; p++)
+	{
+		if (*p == '/')
 		{
-			if (pidcur->pid == pid)
-			{
-				tp->gen.cgroupix = pidcur->cgindex;
-				break;
-			}
+			if (*(p+1))
+				sp->depth++;
+		}
+		else
+		{
+			sp->fullnamelen++;
+		}
+	}
+}
+
+// Verify if the given cgroup is one of the selected paths:
+// compare hash, length and depth first and only assemble
+// the path name for a final verification in case of a match
+//
+static int
+cgselmatch(struct cgchainer *cdp, struct cgchainer *cdbase)
+{
+	struct cstat	*csp = cdp->cstat;
+	char		*path;
+	int		i, match;
+
+	for (i=0; i < ncgselpaths; i++)
+	{
+		if (cgselpaths[i].namehash    != csp->gen.namehash    ||
+		    cgselpaths[i].fullnamelen != csp->gen.fullnamelen ||
+		    cgselpaths[i].depth       != csp->gen.depth         )
+			continue;
+
+		path  = cggetpath(cdp, cdbase, 0);
+		match = strcmp(path, cgselpaths[i].path) == 0;
+		free(path);
+
+		if (match)
+			return 1;
+	}
+
+	return 0;
+}
+
+// Obtain the PIDs of all processes in the selected cgroup subtrees
+// from the current snapshot (to be called after photocgroup).
+// The returned buffer is reused with the next call.
+//
+// Return value:	number of PIDs, or
+//			-1 when no selection is active (all processes
+//			   should be gathered)
+//
+int
+cgselectedpids(pid_t **pidsp)
+{
+	struct cgarena	*ap = cgcurarena;
+	struct cstat	*csp;
+	unsigned long	npids = 0;
+	int		ic, parentseq;
+
+	if (ncgselpaths == 0 || !(supportflags&CGROUPV2) || ap->nchain == 0)
+		return -1;
+
+	if (cgselmaxpids < ap->npids || cgselmaxpids == 0)
+	{
+		cgselmaxpids = ap->npids + 64;
+		cgselpids    = realloc(cgselpids, cgselmaxpids * sizeof(pid_t));
+
+		ptrverify(cgselpids, "Malloc failed for %lu selected pids\n",
+							cgselmaxpids);
+	}
+
+	if (cgselmaxcg < ap->nchain)
+	{
+		cgselmaxcg = ap->nchain + 64;
+		cgselected = realloc(cgselected, cgselmaxcg);
+
+		ptrverify(cgselected, "Malloc failed for %d selected cgroups\n",
+							cgselmaxcg);
+	}
+
+	// the chain is ordered by sequence number, so a parent
+	// is always handled before its children
+	//
+	for (ic=0; ic < ap->nchain; ic++)
+	{
+		csp       = ap->chain[ic].cstat;
+		parentseq = csp->gen.parentseq;
+
+		cgselected[ic] = (parentseq != -1 && cgselected[parentseq]) ||
+		                 cgselmatch(&ap->chain[ic], ap->chain);
+
+		if (cgselected[ic] && csp->gen.nprocs)
+		{
+			memcpy(cgselpids+npids, ap->chain[ic].proclist,
+						csp->gen.nprocs * sizeof(pid_t));
+			npids += csp->gen.nprocs;
 		}
 	}
 
-	free(pidlist);
+	*pidsp = cgselpids;
+
+	return npids;
+}
+
+// Handle atoprc keyword 'cgroupprocs' with one or more
+// cgroup paths (relative to the cgroup top directory)
+//
+void
+do_cgroupprocs(char *tagname, char *tagvalue)
+{
+	char	*p;
+
+	for (p = strtok(tagvalue, " \t\n"); p; p = strtok(NULL, " \t\n"))
+		cgseladd(p);
+
+	if (ncgselpaths == 0)
+		mcleanstop(1, "atoprc: %s requires at least one cgroup path\n",
+								tagname);
 }
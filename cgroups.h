@@ -24,6 +24,8 @@
 #ifndef __CGROUPS__
 #define __CGROUPS__
 
+#define	CGMAXDISK	8	// max physical disks per cgroup
+
 // structure containing general info and metrics per cgroup (directory)
 //
 struct cstat {
@@ -37,7 +39,9 @@ struct cstat {
 		int	procsbelow;	// number of processes in cgroups below
 		int	namelen;	// cgroup name length (at end of struct)
 		int	fullnamelen;	// cgroup path length
-		int	ifuture[4];
+		int	nrtasks;	// pids.current: tasks in cgroup and
+					// cgroups below            -1=undefined
+		int	ifuture[3];
 
 		long	namehash;	// cgroup name hash of
 					// full path name excluding slashes
@@ -54,7 +58,9 @@ struct cstat {
 
 		int	dskweight;	// -1=max, -2=undefined
 
-		int	ifuture[5];
+		int	pidsmax;	// -1=max, -2=undefined
+
+		int	ifuture[4];
 		count_t	cfuture[5];
 	} conf;
 
@@ -66,6 +72,9 @@ struct cstat {
 		count_t	somepres;	// some pressure (microsec)
 		count_t	fullpres;	// full pressure (microsec)
 
+		count_t	nrthrottled;	// throttled periods         -1=undefined
+		count_t	thrtime;	// throttled time (usec)     -1=undefined
+
 		count_t	cfuture[5];
 	} cpu;
 
@@ -80,6 +89,18 @@ struct cstat {
 		count_t	somepres;	// some pressure (microsec)
 		count_t	fullpres;	// full pressure (microsec)
 
+		count_t	pgmajflt;	// major page faults        -1=undefined
+		count_t	wsrefault;	// workingset refaults      -1=undefined
+		count_t	actfile;	// active file (pages)      -1=undefined
+		count_t	inactfile;	// inactive file (pages)    -1=undefined
+		count_t	slab;		// slab memory (pages)      -1=undefined
+		count_t	sock;		// socket buffers (pages)   -1=undefined
+
+		count_t	evhigh;		// memory.events: high      -1=undefined
+		count_t	evmax;		// memory.events: max       -1=undefined
+		count_t	evoom;		// memory.events: oom       -1=undefined
+		count_t	evoomkill;	// memory.events: oom_kill  -1=undefined
+
 		count_t	cfuture[5];
 	} mem;
 
@@ -93,6 +114,18 @@ struct cstat {
 		count_t	somepres;	// some pressure (microsec)
 		count_t	fullpres;	// full pressure (microsec)
 
+		int	ndisks;		// number of physical disks in disks[]
+		int	ifuture[3];
+
+		struct cgperdsk {	// I/O per physical disk
+			int	major;
+			int	minor;
+			count_t	rbytes;	// bytes read
+			count_t	wbytes;	// bytes written
+			count_t	rios;	// read I/Os
+			count_t	wios;	// write I/Os
+		} disks[CGMAXDISK];
+
 		count_t	cfuture[5];
 	} dsk;
 
@@ -135,11 +168,13 @@ int	mergecgrouplist(struct cglinesel **, int,
 int              cgroupv2support(void);
 void             photocgroup(void);
 int              deviatcgroup(struct cgchainer **, int *);
-struct cgchainer **cgsort(struct cgchainer *, int, char);
+struct cgchainer **cgsort(struct cgchainer *, int, char, int);
 char             *cggetpath(struct cgchainer *, struct cgchainer *, int);
 void             cgwipecur(void);
 void             cgbuildarray(struct cgchainer **, char *, char *, int);
 void		 cgfillref(struct devtstat *, struct cgchainer *, int, int);
+int		 cgselectedpids(pid_t **);
+void		 do_cgroupprocs(char *, char *);
 
 
 #endif
@@ -262,7 +262,14 @@ deviattask(struct tstat    *curtpres, unsigned long ntaskpres,
 		devtstat->nprocactive++;
 		devtstat->ntaskactive++;
 
-		if (curstat->gen.pid)	/* acctrecord contains pid? */
+		if (curstat->gen.naggr)	/* summary of exited processes? */
+		{
+			/*
+			** deviations already calculated while folding
+			*/
+			memset(&prestat, 0, sizeof(prestat));
+		}
+		else if (curstat->gen.pid)	/* acctrecord contains pid? */
 		{
 			if ( pdb_gettask(curstat->gen.pid, 1,
 			                 curstat->gen.btime, &pinfo))
@@ -304,11 +311,20 @@ deviattask(struct tstat    *curtpres, unsigned long ntaskpres,
 		if ( curstat->gen.pid == 0 )
 			devstat->gen.pid    = prestat.gen.pid;
 
-		if (!prestat.gen.pid)
+		if (!prestat.gen.pid && !curstat->gen.naggr)
 			devstat->gen.excode |= ~(INT_MAX);
 
-		safe_strcpy(devstat->gen.cmdline, prestat.gen.cmdline, sizeof(devstat->gen.cmdline));
-		safe_strcpy(devstat->gen.utsname, prestat.gen.utsname, sizeof(devstat->gen.utsname));
+		if (curstat->gen.naggr)
+		{
+			snprintf(devstat->gen.cmdline, sizeof devstat->gen.cmdline,
+				"%s [%d exited]", curstat->gen.name,
+				curstat->gen.naggr);
+		}
+		else
+		{
+			safe_strcpy(devstat->gen.cmdline, prestat.gen.cmdline, sizeof(devstat->gen.cmdline));
+			safe_strcpy(devstat->gen.utsname, prestat.gen.utsname, sizeof(devstat->gen.utsname));
+		}
 
 		devstat->cpu.curcpu = -1;
 
@@ -343,7 +359,9 @@ deviattask(struct tstat    *curtpres, unsigned long ntaskpres,
 		/*
 		** try to match the network counters of netatop
 		*/
-		if (supportflags & NETATOPBPF)
+		if (curstat->gen.naggr)
+			;	/* not available for summary */
+		else if (supportflags & NETATOPBPF)
 		{
 			unsigned long	val = (hashtype == 'p' ?
 						curstat->gen.pid :
@@ -555,6 +573,10 @@ calcdiff(struct tstat *devstat, const struct tstat *curstat,
 	else
 		devstat->cpu.nivcsw = curstat->cpu.nivcsw;
 
+	devstat->cpu.cycle   = subcount(curstat->cpu.cycle,   prestat->cpu.cycle);
+	devstat->cpu.instr   = subcount(curstat->cpu.instr,   prestat->cpu.instr);
+	devstat->cpu.llcmiss = subcount(curstat->cpu.llcmiss, prestat->cpu.llcmiss);
+
 	devstat->dsk.rio    =
 		subcount(curstat->dsk.rio, prestat->dsk.rio);
 	devstat->dsk.rsz    =
@@ -659,6 +681,15 @@ deviatsyst(struct sstat *cur, struct sstat *pre, struct sstat *dev,
 	count_t		*cdev, *ccur, *cpre;
 	struct ifprop	ifprop;
 
+	// arrays of previous and current sample should be able
+	// to contain the entries of both samples (i.e. the first
+	// sample is compared with an empty previous sample)
+	//
+	sstat_reservelike(cur, pre);
+	sstat_reservelike(pre, cur);
+	sstat_reservelike(dev, cur);
+	sstat_reservelike(dev, pre);
+
 	// CPU(s) with highest number(s) might have been
 	// taken offline in current sample
 	//
@@ -685,6 +716,14 @@ deviatsyst(struct sstat *cur, struct sstat *pre, struct sstat *dev,
 	dev->cpu.all.instr = subcount(cur->cpu.all.instr, pre->cpu.all.instr);
 	dev->cpu.all.cycle = subcount(cur->cpu.all.cycle, pre->cpu.all.cycle);
 
+	dev->cpu.perfextra      = cur->cpu.perfextra;
+	dev->cpu.all.cachemiss  = subcount(cur->cpu.all.cachemiss,
+	                                   pre->cpu.all.cachemiss);
+	dev->cpu.all.branchmiss = subcount(cur->cpu.all.branchmiss,
+	                                   pre->cpu.all.branchmiss);
+	dev->cpu.all.stallcyc   = subcount(cur->cpu.all.stallcyc,
+	                                   pre->cpu.all.stallcyc);
+
 	for (i=0; i < dev->cpu.maxcpu; i++)
 	{
 		count_t 	ticks;
@@ -731,6 +770,13 @@ deviatsyst(struct sstat *cur, struct sstat *pre, struct sstat *dev,
 		dev->cpu.cpu[i].cycle = subcount(cur->cpu.cpu[i].cycle,
 					         pre->cpu.cpu[i].cycle);
 
+		dev->cpu.cpu[i].cachemiss  = subcount(cur->cpu.cpu[i].cachemiss,
+					              pre->cpu.cpu[i].cachemiss);
+		dev->cpu.cpu[i].branchmiss = subcount(cur->cpu.cpu[i].branchmiss,
+					              pre->cpu.cpu[i].branchmiss);
+		dev->cpu.cpu[i].stallcyc   = subcount(cur->cpu.cpu[i].stallcyc,
+					              pre->cpu.cpu[i].stallcyc);
+
 		ticks 		      = cur->cpu.cpu[i].freqcnt.ticks;
 
 		dev->cpu.cpu[i].freqcnt.maxfreq = 
@@ -1549,6 +1595,8 @@ totalsyst(char category, struct sstat *new, struct sstat *tot)
 	register int	i;
 	count_t		*ctot, *cnew;
 
+	sstat_reservelike(tot, new);
+
 	switch (category)
 	{
 	   case 'c':	/* accumulate cpu-related counters */
@@ -375,6 +375,7 @@ draw_samp(time_t curtime, int nsecs, struct sstat *sstat,
 		   case MPROCSCH:
 		   case MPROCVAR:
 		   case MPROCARG:
+		   case MPROCFLOW:
 
 		   case MBARGRAPH:
 			winexit();		// close windows
@@ -2834,7 +2835,7 @@ getwininput(char *prompt, char *answer, int maxanswer, char numerical)
 // create a separate window with help text and
 // wait for any keyboard input 
 /////////////////////////////////////////////////////
-#define	HELPLINES	27
+#define	HELPLINES	28
 #define	HELPCOLS	70
 
 static void
@@ -2889,6 +2890,11 @@ showhelp(void)
         	" '%c'  - text mode: full command line per process", 
 								MPROCARG);
 
+	if (supportflags & NETATOPBPF)
+        	mvwprintw(helpwin, line++, 2,
+        	" '%c'  - text mode: most active network flows per process", 
+								MPROCFLOW);
+
 	line++;
 
 	// show context dependent help text for raw file viewing/twin mode
@@ -59,12 +59,7 @@ static int		getphysprop(struct ifprop *);
 
 /*
 ** hash table for linked lists with *all* interfaces
-** of this system (including virtual interfaces), even
-** if the number of interfaces exceeds the maximum that
-** is supported by atop (MAXINTF)
-** when the number of interfaces in the system exceeds MAXINTF,
-** preferably virtual interfaces are marked 'invalid' to ensure
-** that all physical interfaces are reported
+** of this system (including virtual interfaces)
 **
 ** the hash table is meant to be searched on interface name
 */
@@ -127,7 +122,7 @@ initifprop(void)
 	FILE 		*fp;
 	char		*cp, linebuf[2048];
 	struct ifprop	*ifp, *ifpsave = NULL;
-	int		bucket, nrinterfaces=0, nrphysical=0;
+	int		bucket;
 
 	DIR		*dirp;
 	struct dirent	*dentry;
@@ -193,8 +188,6 @@ initifprop(void)
 
 		ifp->next = ifhash[bucket];
 		ifhash[bucket] = ifp;
-
-		nrinterfaces++;
 	}
 
 	fclose(fp);
@@ -237,54 +230,11 @@ initifprop(void)
 		{
 			// possible physical interface?
 			if (ifp->type == 'i')
-			{
-				if (getphysprop(ifp))
-					nrphysical++;
-			}
+				(void) getphysprop(ifp);
 		}
 	}
 
 	lastrefreshed = time(0);
-
-	if (nrinterfaces < MAXINTF)
-		return;
-
-	/*
- 	** when the number of interfaces exceeds the maximum,
-	** invalidate the appropriate number of interfaces (preferably
-	** virtual interfaces)
-	*/
-	for (bucket=0; bucket < NUMIFHASH && nrinterfaces >= MAXINTF; bucket++)
-	{
-		for (ifp=ifhash[bucket]; ifp && nrinterfaces >= MAXINTF; ifp=ifp->next)
-		{
-			// interface invalid already?
-			if (ifp->type == 'i')
-			{
-				nrinterfaces--;
-				continue;
-			}
-
-			// physical interface (ethernet or wireless)?
-			if (ifp->type == 'e' || ifp->type == 'w')
-			{
-				// only invalidate when the number of physical
-				// interfaces exceeds MAXINTF
-				if (nrphysical >= MAXINTF)
-				{
-					ifp->type = 'i';
-
-					nrphysical--;
-					nrinterfaces--;
-				}
-				continue;
-			}
-
-			// virtual or unknown interface, invalidate anyhow
-			ifp->type = 'i';
-			nrinterfaces--;
-		}
-	}
 }
 
 static int
@@ -45,12 +45,14 @@
 #include <time.h>
 #include <pwd.h>
 #include <limits.h>
+#include <netinet/in.h>
 
 #include "atop.h"
 #include "photosyst.h"
 #include "photoproc.h"
 #include "cgroups.h"
 #include "json.h"
+#include "netatop.h"
 
 #define LEN_HP_SIZE	64
 #define LINE_BUF_SIZE	1024
@@ -109,6 +111,8 @@ static void json_print_PRN(char *, struct sstat *, struct tstat *, int,
                                                    struct cgchainer *, int);
 static void json_print_PRE(char *, struct sstat *, struct tstat *, int,
                                                    struct cgchainer *, int);
+static void json_print_PRF(char *, struct sstat *, struct tstat *, int,
+                                                   struct cgchainer *, int);
 
 /*
 ** table with possible labels and the corresponding
@@ -152,6 +156,7 @@ static struct labeldef	labeldef[] = {
 	{ "PRD",	0, 0,	json_print_PRD },
 	{ "PRN",	0, 0,	json_print_PRN },
 	{ "PRE",	0, 0,	json_print_PRE },
+	{ "PRF",	0, 0,	json_print_PRF },
 };
 
 static int numlabels = sizeof labeldef / sizeof(struct labeldef);
@@ -358,7 +363,10 @@ json_print_CPU(char *hp, struct sstat *ss,
 		"\"freq\": %lld, "
 		"\"freqperc\": %d, "
 		"\"instr\": %lld, "
-		"\"cycle\": %lld}",
+		"\"cycle\": %lld, "
+		"\"cachemiss\": %lld, "
+		"\"branchmiss\": %lld, "
+		"\"stallcyc\": %lld}",
 		hp,
 		hertz,
 		ss->cpu.nrcpu,
@@ -374,7 +382,10 @@ json_print_CPU(char *hp, struct sstat *ss,
 		freq,
 		freqperc,
 		ss->cpu.all.instr,
-		ss->cpu.all.cycle
+		ss->cpu.all.cycle,
+		ss->cpu.all.cachemiss,
+		ss->cpu.all.branchmiss,
+		ss->cpu.all.stallcyc
 		);
 }
 
@@ -419,7 +430,10 @@ json_print_cpu(char *hp, struct sstat *ss,
 			"\"freq\": %lld, "
 			"\"freqperc\": %d, "
 			"\"instr\": %lld, "
-			"\"cycle\": %lld}",
+			"\"cycle\": %lld, "
+			"\"cachemiss\": %lld, "
+			"\"branchmiss\": %lld, "
+			"\"stallcyc\": %lld}",
 			i,
 			ss->cpu.cpu[i].stime,
 			ss->cpu.cpu[i].utime,
@@ -433,7 +447,10 @@ json_print_cpu(char *hp, struct sstat *ss,
 			freq,
 			freqperc,
 			ss->cpu.cpu[i].instr,
-			ss->cpu.cpu[i].cycle);
+			ss->cpu.cpu[i].cycle,
+			ss->cpu.cpu[i].cachemiss,
+			ss->cpu.cpu[i].branchmiss,
+			ss->cpu.cpu[i].stallcyc);
 	}
 
 	printf("]");
@@ -1121,7 +1138,23 @@ json_print_CGR(char *hp, struct sstat *ss,
 			 "\"diskpsisome\": %lld, "
 			 "\"diskpsitotal\": %lld, "
 
-			 "\"pidlist\": [",
+			 "\"mempgmajflt\": %lld, "
+			 "\"memwsrefault\": %lld, "
+			 "\"memactfile\": %lld, "
+			 "\"meminactfile\": %lld, "
+			 "\"memslab\": %lld, "
+			 "\"memsock\": %lld, "
+
+			 "\"cpunrthrottled\": %lld, "
+			 "\"cputhrottledusec\": %lld, "
+			 "\"pidscurrent\": %d, "
+			 "\"pidsmax\": %d, "
+			 "\"memevhigh\": %lld, "
+			 "\"memevmax\": %lld, "
+			 "\"memevoom\": %lld, "
+			 "\"memevoomkill\": %lld, "
+
+			 "\"disks\": [",
 
 			cgrpath,
                         (cs+i)->cstat->gen.nprocs,
@@ -1163,10 +1196,51 @@ json_print_CGR(char *hp, struct sstat *ss,
                         (cs+i)->cstat->dsk.wios,
                         (cs+i)->cstat->conf.dskweight,
                         (cs+i)->cstat->dsk.somepres,
-                        (cs+i)->cstat->dsk.fullpres);
+                        (cs+i)->cstat->dsk.fullpres,
+
+                        (cs+i)->cstat->mem.pgmajflt,
+                        (cs+i)->cstat->mem.wsrefault,
+                        (cs+i)->cstat->mem.actfile > 0 ?
+                        	(cs+i)->cstat->mem.actfile * pagesize :
+                        	(cs+i)->cstat->mem.actfile,
+                        (cs+i)->cstat->mem.inactfile > 0 ?
+                        	(cs+i)->cstat->mem.inactfile * pagesize :
+                        	(cs+i)->cstat->mem.inactfile,
+                        (cs+i)->cstat->mem.slab > 0 ?
+                        	(cs+i)->cstat->mem.slab * pagesize :
+                        	(cs+i)->cstat->mem.slab,
+                        (cs+i)->cstat->mem.sock > 0 ?
+                        	(cs+i)->cstat->mem.sock * pagesize :
+                        	(cs+i)->cstat->mem.sock,
+
+                        (cs+i)->cstat->cpu.nrthrottled,
+                        (cs+i)->cstat->cpu.thrtime,
+                        (cs+i)->cstat->gen.nrtasks,
+                        (cs+i)->cstat->conf.pidsmax,
+                        (cs+i)->cstat->mem.evhigh,
+                        (cs+i)->cstat->mem.evmax,
+                        (cs+i)->cstat->mem.evoom,
+                        (cs+i)->cstat->mem.evoomkill);
 
 		free(cgrpath);
 
+                // generate disk I/O per physical disk
+                //
+		for (p=0; p < (cs+i)->cstat->dsk.ndisks; p++)
+		{
+			struct cgperdsk	*pdp = &((cs+i)->cstat->dsk.disks[p]);
+
+			printf("%s{\"dev\": \"%d:%d\", "
+			       "\"rbytes\": %lld, \"wbytes\": %lld, "
+			       "\"rios\": %lld, \"wios\": %lld}",
+				p > 0 ? ", " : "",
+				pdp->major, pdp->minor,
+				pdp->rbytes, pdp->wbytes,
+				pdp->rios,   pdp->wios);
+		}
+
+		printf("], \"pidlist\": [");
+
                 // generate related pidlist
                 //
                 if ((cs+i)->cstat->gen.nprocs)
@@ -1259,7 +1333,8 @@ json_print_PRG(char *hp, struct sstat *ss,
 			"\"elaps\": \"%ld\", "
 			"\"isproc\": %d, "
 			"\"cid\": \"%.19s\", "
-			"\"cgroup\": \"%s\"}",
+			"\"cgroup\": \"%s\", "
+			"\"naggr\": %d}",
 			ps->gen.pid,
 			ps->gen.name,
 			ps->gen.state,
@@ -1281,7 +1356,8 @@ json_print_PRG(char *hp, struct sstat *ss,
 			ps->gen.elaps,
 			!!ps->gen.isproc, /* convert to boolean */
 			ps->gen.utsname[0] ? ps->gen.utsname:"-",
-			cgrpath);
+			cgrpath,
+			ps->gen.naggr);
 
 		if (supportflags & CGROUPV2 && ps->gen.cgroupix != -1)
 			free(cgrpath);
@@ -1325,6 +1401,9 @@ json_print_PRC(char *hp, struct sstat *ss,
 			"\"blkdelay\": %lld, "
 			"\"nvcsw\": %llu, "
 			"\"nivcsw\": %llu, "
+			"\"cycle\": %llu, "
+			"\"instr\": %llu, "
+			"\"llcmiss\": %llu, "
 			"\"sleepavg\": %d, "
 			"\"cgroup\": \"%s\"}",
 			ps->gen.pid,
@@ -1340,6 +1419,9 @@ json_print_PRC(char *hp, struct sstat *ss,
 			ps->cpu.blkdelay*1000/hertz,
 			ps->cpu.nvcsw,
 			ps->cpu.nivcsw,
+			ps->cpu.cycle,
+			ps->cpu.instr,
+			ps->cpu.llcmiss,
 			ps->cpu.sleepavg,
 			cgrpath);
 
@@ -1531,3 +1613,52 @@ json_print_PRE(char *hp, struct sstat *ss,
 
 	printf("]");
 }
+
+static void
+json_print_PRF(char *hp, struct sstat *ss,
+                         struct tstat *ps, int nact,
+			 struct cgchainer *cs, int ncgroups)
+{
+	if ( !(supportflags & NETATOPBPF) )
+		return;
+
+	register int		i, f, nflows, nprinted = 0;
+	struct netperflow	*fp;
+	char			raddr[64];
+
+        printf(", %s: [", hp);
+
+	for (i = 0; i < nact; i++, ps++) {
+		if (!ps->gen.isproc)
+			continue;
+
+		nflows = netatop_bpf_findflows(ps->gen.tgid, &fp);
+
+		for (f = 0; f < nflows; f++, fp++) {
+			if (nprinted++ > 0) {
+				printf(", ");
+			}
+
+			printf("{\"pid\": %d, "
+				"\"cmd\": \"%.19s\", "
+				"\"proto\": \"%s\", "
+				"\"raddr\": \"%s\", "
+				"\"rport\": %d, "
+				"\"lport\": %d, "
+				"\"sndpacks\": %llu, "
+				"\"sndbytes\": %llu, "
+				"\"rcvpacks\": %llu, "
+				"\"rcvbytes\": %llu}",
+				ps->gen.pid,
+				ps->gen.name,
+				fp->proto == IPPROTO_UDP ? "udp" : "tcp",
+				netatop_bpf_flowaddr(fp, raddr, sizeof raddr),
+				fp->rport,
+				fp->lport,
+				fp->sndpacks, fp->sndbytes,
+				fp->rcvpacks, fp->rcvbytes);
+		}
+	}
+
+	printf("]");
+}
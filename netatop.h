@@ -79,4 +79,43 @@ struct netpertask {
 
 #define NETATOPBPF_SOCKET "/run/netatop-bpf-socket"
 
+/*
+** bulk request to netatop-bpf: a netpertask with 'id' NETATOPBPF_BULK
+**
+** a daemon that supports bulk transfer answers with a netpertask with
+** 'id' NETATOPBPF_BULK and 'btime' the number of tasks that follow,
+** sorted on ascending 'id' and sent as one contiguous stream;
+** the tasks are terminated by a netpertask with 'id' 0 (older daemons
+** ignore the request contents and only send unsorted tasks and the
+** terminator)
+*/
+#define	NETATOPBPF_BULK		(-1)
+
+/*
+** flows request to netatop-bpf: a netpertask with 'id' NETATOPBPF_FLOWS
+** and 'btime' the maximum number of flows per process
+**
+** only issued when the 'command' of the bulk response header contains
+** the word NETATOPBPF_FEATFLOWS; the daemon answers with the most active
+** flows per process (counters since the previous flows request), sorted
+** on ascending 'id' and terminated by a netperflow with 'id' 0
+*/
+#define	NETATOPBPF_FLOWS	(-2)
+#define	NETATOPBPF_FEATFLOWS	"flows"
+
+struct netperflow {
+	pid_t		id;		// tgid
+	unsigned char	proto;		// IPPROTO_TCP or IPPROTO_UDP
+	unsigned char	family;		// AF_INET or AF_INET6
+	unsigned short	lport;		// local port
+	unsigned short	rport;		// remote port
+	unsigned short	ifuture;
+	unsigned char	raddr[16];	// remote address (IPv4: first 4 bytes)
+
+	unsigned long long	sndpacks;
+	unsigned long long	sndbytes;
+	unsigned long long	rcvpacks;
+	unsigned long long	rcvbytes;
+};
+
 #endif
@@ -32,6 +32,7 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <netinet/ip.h>
+#include <arpa/inet.h>
 #include <sys/ipc.h>
 #include <sys/sem.h>
 #include <sys/stat.h>
@@ -39,7 +40,6 @@
 #include <signal.h>
 #include <zlib.h>
 #include <sys/mman.h>
-#include <glib.h>
 #include <inttypes.h>
 #include <sys/socket.h>
 #include <sys/un.h>
@@ -47,10 +47,13 @@
 #include "photoproc.h"
 #include "netatop.h"
 
+#define	NETBPFENV	"ATOPNETBPF"	// alternative socket path
+
 static int		netsock   = -1;
 
 static void	fill_networkcnt(struct tstat *, struct tstat *,
         	                struct taskcount *);
+static char	*netatop_bpf_sockname(void);
 void my_handler(int);
 
 int len;
@@ -62,7 +65,7 @@ struct sockaddr_un    un;
 void
 netatop_bpf_ipopen(void)
 {
-    char *name = NETATOPBPF_SOCKET;
+    char *name = netatop_bpf_sockname();
     
 	/* create a UNIX domain stream socket */
     if((netsock = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
@@ -72,7 +75,7 @@ netatop_bpf_ipopen(void)
     memset(&un, 0, sizeof(un));
     un.sun_family = AF_UNIX;
     safe_strcpy(un.sun_path, name, sizeof un.sun_path);
-    len = offsetof(struct sockaddr_un, sun_path) + strlen(name);
+    len = offsetof(struct sockaddr_un, sun_path) + strlen(un.sun_path);
     
     if(connect(netsock, (struct sockaddr *)&un, len) < 0)
     {
@@ -94,13 +97,27 @@ netatop_bpf_probe(void)
 	** if not, try to connect again.
 	*/
 	if (!(supportflags & NETATOPBPF)) {
-		char *name = NETATOPBPF_SOCKET;
+		char *name = netatop_bpf_sockname();
 		if (!access(name,F_OK)) {
 			netatop_bpf_ipopen();
 		}
 	} 
 }
 
+/*
+** determine the pathname of the socket of netatop-bpf:
+** when a particular environment variable is present, another
+** socket is used (e.g. of a stand-in daemon that provides
+** synthetic counters for benchmarking)
+*/
+static char *
+netatop_bpf_sockname(void)
+{
+	char	*ep = getenv(NETBPFENV);
+
+	return ep && *ep ? ep : NETATOPBPF_SOCKET;
+}
+
 void my_handler (int param)
 {
 	supportflags &= ~NETATOPBPF;
@@ -108,43 +125,326 @@ void my_handler (int param)
 	netsock = -1;
 }
 
-/* the NET hash function */
-GHashTable *ghash_net;
+/*
+** flat array with the tasks received from netatop-bpf during the
+** last sample, sorted on ascending id (the array is reused for
+** subsequent samples and only grows)
+*/
+#define	NETBPFMINTASKS	1024
+
+static struct netpertask	*nettasks;	// received records
+static long			maxnettasks;	// allocated records
+static struct netpertask	*nettab;	// first task (after header)
+static long			nnettab;	// number of tasks
+
+/*
+** flat array with the most active flows per process received from
+** netatop-bpf during the last sample, sorted on ascending id
+** (only when the daemon supports it and the atoprc keyword 'netflows'
+** is specified); the memory is bounded to NETMAXFLOWS flows
+*/
+#define	NETMAXFLOWSPROC	16	// maximum flows per process (atoprc)
+#define	NETMAXFLOWS	65536	// maximum flows stored per sample
+#define	NETFLOWCHUNK	1024	// extra flows to receive the surplus
+
+static int			netflows;	// flows per process (atoprc)
+static struct netperflow	*flowtab;	// received flows
+static long			maxflowtab;	// allocated flows
+static long			nflowtab;	// number of flows
+
+static void	netatop_bpf_close(void);
+static void	netatop_bpf_grow(long);
+static int	netatop_bpf_compare(const void *, const void *);
+static void	netatop_bpf_getflows(void);
+static int	netatop_bpf_flowcompare(const void *, const void *);
 
 void
 netatop_bpf_gettask()
 {
-	int ret;
 	struct netpertask	npt;
+	long			nbytes = 0, nrecs = 0, ntasks;
+	int			ret, sorted = 0;
+
+	nnettab  = 0;
+	nflowtab = 0;
 
-	ghash_net = g_hash_table_new_full(g_int_hash, g_int_equal, g_free, g_free);
+	if (maxnettasks == 0)
+		netatop_bpf_grow(NETBPFMINTASKS);
 
 	/*
- 	** get statistics of this process/thread
+	** request the statistics of all processes/threads at once
 	*/
+	memset(&npt, 0, sizeof npt);
+	npt.id = NETATOPBPF_BULK;
+
 	signal(SIGPIPE, my_handler);
 	if (send(netsock, &npt, sizeof(npt), 0) < 0) {
-		supportflags &= ~NETATOPBPF;
-		close(netsock);
-		netsock = -1;
+		netatop_bpf_close();
 		return;
 	}
-	while ((ret = recv(netsock, &npt, sizeof(npt), 0)) > 0) {
-		if (npt.id == 0) {
+
+	/*
+	** receive the stream of records directly into the flat array,
+	** reading as many bytes as fit in one recv() instead of
+	** one record per recv()
+	*/
+	while (1) {
+		if (nbytes + sizeof npt > maxnettasks * sizeof npt)
+			netatop_bpf_grow(maxnettasks * 2);
+
+		ret = recv(netsock, (char *)nettasks + nbytes,
+				maxnettasks * sizeof npt - nbytes, 0);
+
+		if (ret <= 0) {
+			netatop_bpf_close();
+			return;
+		}
+
+		nbytes += ret;
+
+		/*
+		** the header of a bulk response tells how many tasks
+		** follow, so the array can be enlarged at once
+		*/
+		if (nrecs == 0 && nbytes >= sizeof npt &&
+		    nettasks[0].id == NETATOPBPF_BULK) {
+			sorted = 1;
+
+			if (nettasks[0].btime + 2 > maxnettasks)
+				netatop_bpf_grow(nettasks[0].btime + 2);
+		}
+
+		/*
+		** search for the terminator in the complete records
+		** that have been received
+		*/
+		for (; (nrecs+1) * sizeof npt <= nbytes; nrecs++) {
+			if (nettasks[nrecs].id == 0)
+				break;
+		}
+
+		if ((nrecs+1) * sizeof npt <= nbytes)
 			break;
+	}
+
+	nettab = sorted ? nettasks + 1 : nettasks;
+	ntasks = sorted ? nrecs - 1     : nrecs;
+
+	if (!sorted)
+		qsort(nettab, ntasks, sizeof npt, netatop_bpf_compare);
+
+	nnettab = ntasks;
+
+	/*
+	** fetch the most active flows per process as well
+	** (when wanted and supported by the daemon)
+	*/
+	if (netflows && sorted) {
+		nettasks[0].command[COMLEN-1] = '\0';
+
+		if (strstr(nettasks[0].command, NETATOPBPF_FEATFLOWS))
+			netatop_bpf_getflows();
+	}
+}
+
+/*
+** connection with netatop-bpf lost
+*/
+static void
+netatop_bpf_close(void)
+{
+	supportflags &= ~NETATOPBPF;
+	close(netsock);
+	netsock  = -1;
+	nnettab  = 0;
+	nflowtab = 0;
+}
+
+/*
+** receive the most active flows per process
+*/
+static void
+netatop_bpf_getflows(void)
+{
+	struct netpertask	npt;
+	long			nbytes = 0, nrecs = 0, partial, i;
+	int			ret;
+
+	memset(&npt, 0, sizeof npt);
+	npt.id    = NETATOPBPF_FLOWS;
+	npt.btime = netflows;
+
+	if (send(netsock, &npt, sizeof(npt), 0) < 0) {
+		netatop_bpf_close();
+		return;
+	}
+
+	while (1) {
+		if (nbytes + sizeof *flowtab > maxflowtab * sizeof *flowtab) {
+			if (maxflowtab < NETMAXFLOWS + NETFLOWCHUNK) {
+				maxflowtab = maxflowtab ? maxflowtab * 2 : NETFLOWCHUNK;
+
+				if (maxflowtab > NETMAXFLOWS + NETFLOWCHUNK)
+					maxflowtab = NETMAXFLOWS + NETFLOWCHUNK;
+
+				flowtab = realloc(flowtab,
+						maxflowtab * sizeof *flowtab);
+
+				ptrverify(flowtab, "Malloc failed for %ld "
+				          "netatop-bpf flows\n", maxflowtab);
+			} else {
+				/*
+				** maximum number of flows reached: the surplus
+				** is overwritten by subsequent flows (only
+				** the terminator is still of interest)
+				*/
+				partial = nbytes % sizeof *flowtab;
+
+				memmove(flowtab + NETMAXFLOWS,
+				        (char *)flowtab + nbytes - partial, partial);
+
+				nbytes = NETMAXFLOWS * sizeof *flowtab + partial;
+				nrecs  = NETMAXFLOWS;
+			}
+		}
+
+		ret = recv(netsock, (char *)flowtab + nbytes,
+				maxflowtab * sizeof *flowtab - nbytes, 0);
+
+		if (ret <= 0) {
+			netatop_bpf_close();
+			return;
+		}
+
+		nbytes += ret;
+
+		for (; (nrecs+1) * sizeof *flowtab <= nbytes; nrecs++) {
+			if (flowtab[nrecs].id == 0)
+				break;
 		}
-		gint *key = g_new(gint, 1);
-		*key  = npt.id;
-		struct taskcount *value = g_new(struct taskcount, 1);
-		*value = npt.tc;
-		g_hash_table_insert(ghash_net, key, value);
+
+		if ((nrecs+1) * sizeof *flowtab <= nbytes)
+			break;
 	}
-	if (ret <= 0) {
-		supportflags &= ~NETATOPBPF;
-		close(netsock);
-		netsock = -1;
-		return ;
+
+	nflowtab = nrecs < NETMAXFLOWS ? nrecs : NETMAXFLOWS;
+
+	/*
+	** the flows should have been sorted by the daemon already
+	** (on id and most active flow first)
+	*/
+	for (i=1; i < nflowtab; i++) {
+		if (netatop_bpf_flowcompare(&flowtab[i-1], &flowtab[i]) > 0)
+			break;
 	}
+
+	if (i < nflowtab)
+		qsort(flowtab, nflowtab, sizeof *flowtab,
+					netatop_bpf_flowcompare);
+}
+
+/*
+** search the flows of a process in the flows received
+** during the last sample (most active flow first)
+**
+** return value: number of flows
+*/
+int
+netatop_bpf_findflows(pid_t id, struct netperflow **flowpp)
+{
+	struct netperflow	key, *fp;
+	long			first, last;
+
+	key.id = id;
+
+	fp = bsearch(&key, flowtab, nflowtab, sizeof key, netatop_bpf_compare);
+
+	if (!fp)
+		return 0;
+
+	for (first = fp - flowtab; first > 0; first--) {
+		if (flowtab[first-1].id != id)
+			break;
+	}
+
+	for (last = fp - flowtab; last < nflowtab-1; last++) {
+		if (flowtab[last+1].id != id)
+			break;
+	}
+
+	*flowpp = flowtab + first;
+
+	return last - first + 1;
+}
+
+/*
+** format the remote address of a flow
+*/
+char *
+netatop_bpf_flowaddr(struct netperflow *fp, char *buf, int buflen)
+{
+	if (!inet_ntop(fp->family == AF_INET6 ? AF_INET6 : AF_INET,
+						fp->raddr, buf, buflen))
+		snprintf(buf, buflen, "?");
+
+	return buf;
+}
+
+/*
+** search the counters of a process/thread
+** in the tasks received during the last sample
+*/
+struct taskcount *
+netatop_bpf_findtask(pid_t id)
+{
+	struct netpertask	key, *npt;
+
+	key.id = id;
+
+	npt = bsearch(&key, nettab, nnettab, sizeof key, netatop_bpf_compare);
+
+	return npt ? &npt->tc : NULL;
+}
+
+/*
+** compare the id of two netpertask or two netperflow structs
+** (both start with the id)
+*/
+static int
+netatop_bpf_compare(const void *a, const void *b)
+{
+	pid_t	ida = *(pid_t *)a;
+	pid_t	idb = *(pid_t *)b;
+
+	return ida < idb ? -1 : ida > idb;
+}
+
+/*
+** compare two flows on id and on descending number of bytes
+*/
+static int
+netatop_bpf_flowcompare(const void *a, const void *b)
+{
+	const struct netperflow	*fa = a, *fb = b;
+	unsigned long long	ta, tb;
+
+	if (fa->id != fb->id)
+		return fa->id < fb->id ? -1 : 1;
+
+	ta = fa->sndbytes + fa->rcvbytes;
+	tb = fb->sndbytes + fb->rcvbytes;
+
+	return ta > tb ? -1 : ta < tb;
+}
+
+static void
+netatop_bpf_grow(long ntasks)
+{
+	nettasks = realloc(nettasks, ntasks * sizeof(struct netpertask));
+
+	ptrverify(nettasks, "Malloc failed for %ld netatop-bpf tasks\n", ntasks);
+
+	maxnettasks = ntasks;
 }
 
 /*
@@ -154,7 +454,7 @@ netatop_bpf_gettask()
 void
 netatop_bpf_exitfind(unsigned long key, struct tstat *dev, struct tstat *pre)
 {
-	struct taskcount *tc = g_hash_table_lookup(ghash_net, &key);
+	struct taskcount *tc = netatop_bpf_findtask(key);
 	/*
 	** correct PID found
 	*/
@@ -184,3 +484,21 @@ fill_networkcnt(struct tstat *dev, struct tstat *pre, struct taskcount *tc)
 	dev->net.udprcv	= tc->udprcvpacks - pre->net.udprcv;
 	dev->net.udprsz	= tc->udprcvbytes - pre->net.udprsz;
 }
+
+/*
+** atoprc keyword 'netflows': number of flows per process
+** to be retrieved from netatop-bpf
+*/
+void
+do_netflows(char *tagname, char *tagvalue)
+{
+	if ( !numeric(tagvalue) )
+		mcleanstop(1, "atoprc: %s value %s not a (positive) numeric\n",
+				tagname, tagvalue);
+
+	netflows = atoi(tagvalue);
+
+	if (netflows > NETMAXFLOWSPROC)
+		mcleanstop(1, "atoprc: %s value should be at most %d\n",
+				tagname, NETMAXFLOWSPROC);
+}
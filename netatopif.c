@@ -58,24 +58,34 @@ static unsigned long	lastseq;
 
 /*
 ** storage of last exited tasks read from exitfile
-** every exitstore struct is registered in hash buckets,
-** by its pid or by its begin time
+** in one contiguous array (reused for subsequent samples);
+** every exitstore struct is registered in an open-addressing
+** hash table, by its pid or by its begin time
 */
 struct exitstore {
-	struct exitstore  *next;
 	unsigned char      isused;
 	struct netpertask  npt;
 };
 
-#define NHASH		1024 	// must be power of two!
-#define HASHCALC(x)	((x)&(NHASH-1))
-
-static struct exitstore	*esbucket[NHASH];
+#define NHASHMIN	1024 	// minimum number of slots (power of two)
 
 static struct exitstore *exitall;
-static int		 exitnum;
+static int		 exitnum;	// number of stored tasks
+static int		 exitmax;	// number of allocated tasks
 static char		 exithash;
 
+static int		*exitslot;	// index in exitall or -1 (empty)
+static unsigned long	 nexitslot;	// number of slots (power of two)
+
+/*
+** buffers to decompress the records from the exitfile
+** (reused for subsequent samples)
+*/
+static unsigned char	*readbuf, *databuf;
+static unsigned int	 bufsize;
+
+static unsigned long	exithashval(unsigned long, char *);
+
 static void	fill_networkcnt(struct tstat *, struct tstat *,
         	                struct exitstore *);
 
@@ -292,9 +302,7 @@ netatop_exitstore(void)
 	socklen_t		socklen = 0, nexitnet, sz, nr=0;
 	unsigned long		uncomplen;
 	unsigned char		nextsize;
-	unsigned char		readbuf[nahp->ntplen+100];
-	unsigned char		databuf[nahp->ntplen];
-	struct netpertask	*tmp = (struct netpertask *)databuf;
+	struct netpertask	*tmp;
 	struct exitstore	*esp;
 
         regainrootprivs();
@@ -352,14 +360,38 @@ netatop_exitstore(void)
 		return 0;
 
 	/*
-	** allocate storage for all exited processes
+	** take care that the storage can contain all exited processes
+	** and that the decompression buffers fit the record size
 	*/
-	exitall = malloc(nexitnet * sizeof(struct exitstore));
+	if (nexitnet > exitmax)
+	{
+		free(exitall);
 
-	ptrverify(exitall, "Malloc failed for %d exited netprocs\n", nexitnet);
+		exitall = malloc(nexitnet * sizeof(struct exitstore));
+
+		ptrverify(exitall, "Malloc failed for %d exited netprocs\n",
+								nexitnet);
+		exitmax = nexitnet;
+	}
 
 	memset(exitall, 0, nexitnet * sizeof(struct exitstore));
 
+	if (nahp->ntplen > bufsize)
+	{
+		free(readbuf);
+		free(databuf);
+
+		readbuf = malloc(nahp->ntplen+100);
+		databuf = malloc(nahp->ntplen);
+
+		ptrverify(readbuf, "Malloc failed for netatop read buffer\n");
+		ptrverify(databuf, "Malloc failed for netatop data buffer\n");
+
+		bufsize = nahp->ntplen;
+	}
+
+	tmp = (struct netpertask *)databuf;
+
 	esp = exitall;
 
 	/*
@@ -425,38 +457,88 @@ netatop_exitstore(void)
 }
 
 /*
-** remove all stored exited processes from the hash bucket list
+** remove all stored exited processes
+** (the storage itself is kept for the next sample)
 */
 void
 netatop_exiterase(void)
 {
-	free(exitall);
-	memset(esbucket, 0, sizeof esbucket);
 	exitnum = 0;
 }
 
 /*
-** add all stored tasks to a hash bucket, either
+** add all stored tasks to the hash table, either
 ** by pid (argument 'p') or by begin time (argument 'b')
+**
+** the number of slots is at least twice the number of
+** stored tasks, so the probe sequences remain short
 */
 void
 netatop_exithash(char hashtype)
 {
-	int			i, h;
+	unsigned long		nslots = NHASHMIN, h;
+	int			i;
 	struct exitstore	*esp;
 
+	exithash = hashtype;
+
+	if (exitnum == 0)
+		return;
+
+	while (nslots < exitnum * 2UL)
+		nslots *= 2;
+
+	/*
+	** (re)allocate when the table is too small or
+	** far too large after an exit-heavy sample
+	*/
+	if (nslots > nexitslot || nslots * 8 < nexitslot)
+	{
+		free(exitslot);
+
+		exitslot = malloc(nslots * sizeof(int));
+
+		ptrverify(exitslot, "Malloc failed for %lu netatop hash slots\n",
+								nslots);
+		nexitslot = nslots;
+	}
+
+	memset(exitslot, 0xff, nexitslot * sizeof(int));	// all -1
+
+	/*
+	** linear probing: tasks with the same key end up in
+	** subsequent slots in the order of the exitfile
+	*/
 	for (i=0, esp=exitall; i < exitnum; i++, esp++)
 	{
 		if (hashtype == 'p')
-			h = HASHCALC(esp->npt.id);
+			h = exithashval(esp->npt.id, NULL);
 		else
-			h = HASHCALC(esp->npt.btime);
+			h = exithashval(esp->npt.btime, esp->npt.command);
+
+		while (exitslot[h] != -1)
+			h = (h+1) & (nexitslot-1);
 
-		esp->next   = esbucket[h];
-		esbucket[h] = esp;
+		exitslot[h] = i;
 	}
+}
 
-	exithash = hashtype;
+/*
+** determine the first hash slot for a pid or for a begin time
+** combined with the command name (many processes might start in
+** the same second); multiplicative hashing spreads subsequent
+** keys over the table
+*/
+static unsigned long
+exithashval(unsigned long key, char *name)
+{
+	if (name)
+	{
+		for (; *name; name++)
+			key = (key ^ (unsigned char)*name) * 16777619UL;
+	}
+
+	return ((key * 0x9e3779b97f4a7c15ULL) >> 32) & (nexitslot-1);
 }
 
 /*
@@ -466,20 +548,21 @@ netatop_exithash(char hashtype)
 void
 netatop_exitfind(unsigned long key, struct tstat *dev, struct tstat *pre)
 {
-	int 			h = HASHCALC(key);
+	unsigned long		h;
 	struct exitstore	*esp;
 
-	/*
-	** if bucket empty, forget about it
-	*/
-	if ( (esp = esbucket[h]) == NULL)
+	if (exitnum == 0)
 		return;
 
 	/*
-	** search thru hash bucket list
+	** search thru the probe sequence until an empty slot
 	*/
-	for (; esp; esp=esp->next)
+	h = exithashval(key, exithash == 'p' ? NULL : pre->gen.name);
+
+	for (; exitslot[h] != -1; h = (h+1) & (nexitslot-1))
 	{
+		esp = exitall + exitslot[h];
+
 		switch (exithash)
 		{
 		   case 'p':		// search by PID
@@ -490,7 +573,7 @@ netatop_exitfind(unsigned long key, struct tstat *dev, struct tstat *pre)
 			** correct PID found
 			*/
 			fill_networkcnt(dev, pre, esp);
-			break;
+			return;
 
 		   case 'b':		// search by begin time
 			if (esp->isused)
@@ -518,7 +601,7 @@ netatop_exitfind(unsigned long key, struct tstat *dev, struct tstat *pre)
 			esp->isused = 1;
  
 			fill_networkcnt(dev, pre, esp);
-			break;
+			return;
 		}
 	}
 }
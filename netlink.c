@@ -16,6 +16,7 @@
 ** Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 ** --------------------------------------------------------------------------
 */
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
@@ -41,6 +42,8 @@
 #define NLA_DATA(na)		((void *)((char*)(na)     + NLA_HDRLEN))
 #define NLA_PAYLOAD(len)	(len                      - NLA_HDRLEN)
 
+#define	NLBATCH			64	// maximum messages per recvmmsg()
+
 /*
 ** function prototypes
 */
@@ -114,6 +117,132 @@ netlink_recv(int nlsock, int flags)
 	return len;			// 0 or positive value
 }
 
+/*
+** receive a batch of taskstats messages that are sent by the kernel
+** for exiting tasks with one system call (at most 'maxstats' messages);
+** the taskstats structure of every task is stored in 'stats'
+** (fields unknown by the running kernel are zeroed)
+**
+** return value: number of tasks stored (0 or positive value)
+**               or negative errno
+*/
+int
+netlink_recvstats(int nlsock, struct taskstats *stats, int maxstats, int flags)
+{
+	static struct msgtemplate	msgs[NLBATCH];
+	struct mmsghdr			mmsgs[NLBATCH];
+	struct iovec			iovs[NLBATCH];
+	struct nlattr			*na, *nested;
+	int				i, n, len, nestlen, stlen, nstats = 0;
+
+	if (maxstats > NLBATCH)
+		maxstats = NLBATCH;
+
+	memset(mmsgs, 0, sizeof mmsgs);
+
+	for (i=0; i < maxstats; i++)
+	{
+		iovs[i].iov_base		= &msgs[i];
+		iovs[i].iov_len			= sizeof msgs[i];
+		mmsgs[i].msg_hdr.msg_iov	= &iovs[i];
+		mmsgs[i].msg_hdr.msg_iovlen	= 1;
+	}
+
+	/*
+	** block until the first message arrives (unless MSG_DONTWAIT)
+	** and take all other messages that are already queued
+	*/
+	if ( (n = recvmmsg(nlsock, mmsgs, maxstats, flags|MSG_WAITFORONE,
+							NULL)) == -1)
+		return -errno;
+
+	for (i=0; i < n; i++)
+	{
+		if (msgs[i].n.nlmsg_type == NLMSG_ERROR ||
+		    !NLMSG_OK(&msgs[i].n, mmsgs[i].msg_len))
+		{
+			struct nlmsgerr *err = NLMSG_DATA(&msgs[i]);
+
+			if (n == 1)
+				return err->error;	// negative: errno
+
+			continue;
+		}
+
+		/*
+		** search for the statistics of the exited task
+		** (nested in the pid aggregate attribute)
+		*/
+		na  = (struct nlattr *) GENLMSG_DATA(&msgs[i]);
+		len = GENLMSG_PAYLOAD(&msgs[i].n);
+
+		while (len >= NLA_HDRLEN && na->nla_len >= NLA_HDRLEN &&
+		       na->nla_len <= len)
+		{
+			if (na->nla_type != TASKSTATS_TYPE_AGGR_PID)
+			{
+				len -= NLA_ALIGN(na->nla_len);
+				na   = (struct nlattr *)
+					((char *)na + NLA_ALIGN(na->nla_len));
+				continue;
+			}
+
+			nested  = (struct nlattr *) NLA_DATA(na);
+			nestlen = NLA_PAYLOAD(na->nla_len);
+
+			while (nestlen >= NLA_HDRLEN &&
+			       nested->nla_len >= NLA_HDRLEN &&
+			       nested->nla_len <= nestlen)
+			{
+				if (nested->nla_type == TASKSTATS_TYPE_STATS)
+				{
+					stlen = NLA_PAYLOAD(nested->nla_len);
+
+					if (stlen > sizeof *stats)
+						stlen = sizeof *stats;
+
+					memset(&stats[nstats], 0, sizeof *stats);
+					memcpy(&stats[nstats], NLA_DATA(nested),
+									stlen);
+					nstats++;
+					break;
+				}
+
+				nestlen -= NLA_ALIGN(nested->nla_len);
+				nested   = (struct nlattr *) ((char *)nested +
+						NLA_ALIGN(nested->nla_len));
+			}
+
+			break;
+		}
+	}
+
+	return nstats;
+}
+
+/*
+** set the size of the receive buffer of the netlink socket
+** (beyond the rmem_max limit when running with privileges)
+**
+** return value: effective size of receive buffer or -1
+*/
+int
+netlink_setrcvbuf(int nlsock, int rcvsz)
+{
+	socklen_t	optlen = sizeof rcvsz;
+
+	if (setsockopt(nlsock, SOL_SOCKET, SO_RCVBUFFORCE,
+					&rcvsz, sizeof rcvsz) == -1 &&
+	    setsockopt(nlsock, SOL_SOCKET, SO_RCVBUF,
+					&rcvsz, sizeof rcvsz) == -1)
+		return -1;
+
+	if (getsockopt(nlsock, SOL_SOCKET, SO_RCVBUF, &rcvsz, &optlen) == -1)
+		return -1;
+
+	return rcvsz;
+}
+
 static int
 nlsock_getfam(int nlsock)
 {
@@ -33,12 +33,14 @@
 #include <string.h>
 #include <limits.h>
 #include <sys/utsname.h>
+#include <netinet/in.h>
 
 #include "atop.h"
 #include "photosyst.h"
 #include "photoproc.h"
 #include "cgroups.h"
 #include "parseable.h"
+#include "netatop.h"
 
 void 	print_CPU(char *, struct sstat *, struct tstat *, int,
                                           struct cgchainer *, int);
@@ -94,6 +96,8 @@ void 	print_PRN(char *, struct sstat *, struct tstat *, int,
                                           struct cgchainer *, int);
 void 	print_PRE(char *, struct sstat *, struct tstat *, int,
                                           struct cgchainer *, int);
+void 	print_PRF(char *, struct sstat *, struct tstat *, int,
+                                          struct cgchainer *, int);
 
 static void calc_freqscale(count_t, count_t, count_t, count_t *, int *);
 static char *spaceformat(char *, char *, int);
@@ -140,6 +144,7 @@ static struct labeldef	labeldef[] = {
 	{ "PRD",	0, 0,	print_PRD },
 	{ "PRN",	0, 0,	print_PRN },
 	{ "PRE",	0, 0,	print_PRE },
+	{ "PRF",	0, 0,	print_PRF },
 };
 
 static int	numlabels = sizeof labeldef/sizeof(struct labeldef);
@@ -343,7 +348,8 @@ print_CPU(char *hp, struct sstat *ss,
         	ss->cpu.all.cycle = 0;
 	}
 
-	printf("%s %u %d %lld %lld %lld %lld %lld %lld %lld %lld %lld %lld %d %lld %lld\n",
+	printf("%s %u %d %lld %lld %lld %lld %lld %lld %lld %lld %lld %lld %d %lld %lld "
+	       "%lld %lld %lld\n",
 			hp,
 			hertz,
 	        	ss->cpu.nrcpu,
@@ -359,7 +365,10 @@ print_CPU(char *hp, struct sstat *ss,
                         freq,
                         freqperc,
         		ss->cpu.all.instr,
-        		ss->cpu.all.cycle
+        		ss->cpu.all.cycle,
+        		ss->cpu.all.cachemiss,
+        		ss->cpu.all.branchmiss,
+        		ss->cpu.all.stallcyc
                         );
 }
 
@@ -387,7 +396,8 @@ print_cpu(char *hp, struct sstat *ss,
                 calc_freqscale(maxfreq, cnt, ticks, &freq, &freqperc);
 
 		printf("%s %u %d %lld %lld %lld "
-		       "%lld %lld %lld %lld %lld %lld %lld %d %lld %lld\n",
+		       "%lld %lld %lld %lld %lld %lld %lld %d %lld %lld "
+		       "%lld %lld %lld\n",
 			hp, hertz, i,
 	        	ss->cpu.cpu[i].stime,
         		ss->cpu.cpu[i].utime,
@@ -401,7 +411,10 @@ print_cpu(char *hp, struct sstat *ss,
                         freq,
                         freqperc,
         		ss->cpu.cpu[i].instr,
-        		ss->cpu.cpu[i].cycle
+        		ss->cpu.cpu[i].cycle,
+        		ss->cpu.cpu[i].cachemiss,
+        		ss->cpu.cpu[i].branchmiss,
+        		ss->cpu.cpu[i].stallcyc
 			);
 	}
 }
@@ -862,7 +875,9 @@ print_CGR(char *hp, struct sstat *ss,
 		printf(	"%s C %s %d %d %lld %lld %d %d "
 		        "%lld %lld %lld %lld %lld %lld %lld "
 		        "%lld %lld %lld %lld %d %lld %lld "
-			"%lld %lld %lld %lld\n",
+			"%lld %lld %lld %lld "
+			"%lld %lld %lld %lld %lld %lld "
+			"%lld %lld %d %d %lld %lld %lld %lld\n",
 			hp, cgrpath,
 			(devchain+i)->cstat->gen.nprocs,
 			(devchain+i)->cstat->gen.procsbelow,
@@ -889,7 +904,40 @@ print_CGR(char *hp, struct sstat *ss,
 			(devchain+i)->cstat->mem.somepres,
 			(devchain+i)->cstat->mem.fullpres,
 			(devchain+i)->cstat->dsk.somepres,
-			(devchain+i)->cstat->dsk.fullpres);
+			(devchain+i)->cstat->dsk.fullpres,
+
+			(devchain+i)->cstat->mem.pgmajflt,
+			(devchain+i)->cstat->mem.wsrefault,
+			(devchain+i)->cstat->mem.actfile,
+			(devchain+i)->cstat->mem.inactfile,
+			(devchain+i)->cstat->mem.slab,
+			(devchain+i)->cstat->mem.sock,
+
+			(devchain+i)->cstat->cpu.nrthrottled,
+			(devchain+i)->cstat->cpu.thrtime,
+			(devchain+i)->cstat->gen.nrtasks,
+			(devchain+i)->cstat->conf.pidsmax,
+			(devchain+i)->cstat->mem.evhigh,
+			(devchain+i)->cstat->mem.evmax,
+			(devchain+i)->cstat->mem.evoom,
+			(devchain+i)->cstat->mem.evoomkill);
+
+		// print disk I/O per physical disk in one line
+		//
+		if ((devchain+i)->cstat->dsk.ndisks)
+		{
+			struct cgperdsk	*pdp = (devchain+i)->cstat->dsk.disks;
+
+			printf( "%s D %s", hp, cgrpath);
+
+			for (p=0; p < (devchain+i)->cstat->dsk.ndisks; p++, pdp++)
+				printf(" %d:%d %lld %lld %lld %lld",
+					pdp->major, pdp->minor,
+					pdp->rbytes, pdp->wbytes,
+					pdp->rios,   pdp->wios);
+
+			printf("\n");
+		}
 
 		// print related pidlist in one line
 		//
@@ -952,7 +1000,7 @@ print_PRG(char *hp, struct sstat *ss,
 			exitcode = (ps->gen.excode >>   8) & 0xff;
 
 		printf("%s %d %s %c %d %d %d %d %d %ld %s %d %d %d %d "
- 		       "%d %d %d %d %d %d %ld %c %d %d %s %c %s %ld %d\n",
+ 		       "%d %d %d %d %d %d %ld %c %d %d %s %c %s %ld %d %d\n",
 			hp,
 			ps->gen.pid,
 			spaceformat(ps->gen.name, namout, sizeof namout),
@@ -983,7 +1031,8 @@ print_PRG(char *hp, struct sstat *ss,
 			spaceformat(cgrpath, cgrout, cgrpathsize),
 			ps->gen.state == 'E' ?
 			    ps->gen.btime + ps->gen.elaps/hertz : 0,
-			ps->gen.nthridle);
+			ps->gen.nthridle,
+			ps->gen.naggr);
 
 		if (supportflags & CGROUPV2 && ps->gen.cgroupix != -1)
 			free(cgrpath);
@@ -1016,7 +1065,7 @@ print_PRC(char *hp, struct sstat *ss,
 		}
 				
 		printf("%s %d %s %c %u %lld %lld %d %d %d %d %d %d %d %c "
-		       "%llu %s %llu %d %d %llu %llu\n",
+		       "%llu %s %llu %d %d %llu %llu %llu %llu %llu\n",
 			hp,
 			ps->gen.pid,
 			spaceformat(ps->gen.name, namout, sizeof namout),
@@ -1038,7 +1087,10 @@ print_PRC(char *hp, struct sstat *ss,
 			cpumax,
 			-2,	// most restrictive cpumax no longer supported
 			ps->cpu.nvcsw,
-			ps->cpu.nivcsw);
+			ps->cpu.nivcsw,
+			ps->cpu.cycle,
+			ps->cpu.instr,
+			ps->cpu.llcmiss);
 	}
 }
 
@@ -1156,6 +1208,38 @@ print_PRN(char *hp, struct sstat *ss,
 	}
 }
 
+void
+print_PRF(char *hp, struct sstat *ss,
+                    struct tstat *ps, int nact,
+                    struct cgchainer *devchain, int ncgroups)
+{
+	register int		i, f, nflows;
+	struct netperflow	*fp;
+	char			namout[PNAMLEN+1+2], raddr[64];
+
+	for (i=0; i < nact; i++, ps++)
+	{
+		if (!ps->gen.isproc)
+			continue;
+
+		nflows = netatop_bpf_findflows(ps->gen.tgid, &fp);
+
+		for (f=0; f < nflows; f++, fp++)
+		{
+			printf("%s %d %s %c %s %s %d %d %llu %llu %llu %llu\n",
+				hp,
+				ps->gen.pid,
+				spaceformat(ps->gen.name, namout, sizeof namout),
+				ps->gen.state,
+				fp->proto == IPPROTO_UDP ? "udp" : "tcp",
+				netatop_bpf_flowaddr(fp, raddr, sizeof raddr),
+				fp->rport, fp->lport,
+				fp->sndpacks, fp->sndbytes,
+				fp->rcvpacks, fp->rcvbytes);
+		}
+	}
+}
+
 void
 print_PRE(char *hp, struct sstat *ss,
                     struct tstat *ps, int nact,
@@ -0,0 +1,430 @@
+/*
+** ATOP - System & Process Monitor
+**
+** The program 'atop' offers the possibility to view the activity of
+** the system on system-level as well as process-/thread-level.
+**
+** This source-file contains functions to count hardware events
+** (cycles, instructions and last-level cache misses) for the processes
+** that consumed most CPU time during the previous interval.
+** For every thread of such process counting perf events are opened
+** in inherit mode, so threads and children that are created afterwards
+** are counted as well.
+** The counters are cumulative from the moment that the process has been
+** selected; when a process is not selected any more its counters are
+** closed and the values in the next sample drop to zero (which is
+** treated by deviattask() as a counter reset).
+** ==========================================================================
+** Date:        October 2026
+** --------------------------------------------------------------------------
+**
+** This program is free software; you can redistribute it and/or modify it
+** under the terms of the GNU General Public License as published by the
+** Free Software Foundation; either version 2, or (at your option) any
+** later version.
+**
+** This program is distributed in the hope that it will be useful, but
+** WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+** --------------------------------------------------------------------------
+*/
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <ctype.h>
+#include <time.h>
+
+#ifndef	NOPERFEVENT
+#include <linux/perf_event.h>
+#include <asm/unistd.h>
+#endif
+
+#include "atop.h"
+#include "photoproc.h"
+
+static int	perfprocs;	// number of processes to be counted (atoprc)
+
+#ifndef	NOPERFEVENT
+
+/*
+** events counted per thread, in the order of
+** the fields in struct tstat (cpu part)
+*/
+static __u64	perfevproc[] = {
+	PERF_COUNT_HW_CPU_CYCLES,
+	PERF_COUNT_HW_INSTRUCTIONS,
+	PERF_COUNT_HW_CACHE_MISSES,
+};
+
+#define	NRPERFEVPROC	(sizeof perfevproc / sizeof perfevproc[0])
+
+/*
+** maximum number of descriptors opened for all selected processes
+** together; threads beyond this limit are not counted
+*/
+#define	MAXPERFFDS	3072
+
+/*
+** administration per selected process
+*/
+struct perfproc {
+	pid_t	tgid;
+	time_t	btime;		// to recognize a recycled PID
+	int	nrthreads;	// number of threads with opened events
+	int	maxthreads;	// number of threads allocated
+	int	*fds;		// NRPERFEVPROC descriptors per thread
+};
+
+static struct perfproc	*pps;	// selected processes (perfprocs entries)
+static int		npps;	// number of selected processes
+static int		nrfds;	// number of opened descriptors
+static int		failed;	// no kernel support for perf events
+
+static long	perf_event_open(struct perf_event_attr *, pid_t,
+                		int, int, unsigned long);
+static void	perfproc_attach(struct perfproc *, pid_t, time_t);
+static void	perfproc_detach(struct perfproc *);
+
+static long
+perf_event_open(struct perf_event_attr *hwevent, pid_t pid,
+                int cpu, int groupfd, unsigned long flags)
+{
+	return syscall(__NR_perf_event_open, hwevent, pid, cpu, groupfd, flags);
+}
+
+/*
+** select the processes that consumed most CPU time during
+** the last interval and (re)arrange the perf events
+** (to be called after deviattask)
+*/
+void
+perfproc_select(struct devtstat *devtstat)
+{
+	struct tstat	**top, *curstat;
+	struct perfproc	*newpps;
+	int		ntop = 0, i, j;
+	unsigned long	p;
+
+	if (perfprocs <= 0 || failed)
+		return;
+
+	/*
+	** determine the top-N processes regarding CPU consumption
+	** (insertion in a small sorted array)
+	*/
+	top = calloc(perfprocs, sizeof(struct tstat *));
+
+	ptrverify(top, "Malloc failed for %d perf processes\n", perfprocs);
+
+	for (p=0; p < devtstat->nprocactive; p++)
+	{
+		count_t	cputime;
+
+		curstat = devtstat->procactive[p];
+		cputime = curstat->cpu.utime + curstat->cpu.stime;
+
+		if (curstat->gen.state == 'E' || cputime == 0)
+			continue;
+
+		if (ntop == perfprocs &&
+		    cputime <= top[ntop-1]->cpu.utime + top[ntop-1]->cpu.stime)
+			continue;
+
+		for (i = ntop < perfprocs ? ntop++ : ntop-1; i > 0; i--)
+		{
+			if (top[i-1]->cpu.utime + top[i-1]->cpu.stime >= cputime)
+				break;
+
+			top[i] = top[i-1];
+		}
+
+		top[i] = curstat;
+	}
+
+	/*
+	** build the new administration: keep the events of processes
+	** that were already selected and open events for new ones
+	*/
+	newpps = calloc(perfprocs, sizeof(struct perfproc));
+
+	ptrverify(newpps, "Malloc failed for %d perf processes\n", perfprocs);
+
+	for (i=0; i < ntop; i++)
+	{
+		for (j=0; j < npps; j++)
+		{
+			if (pps[j].tgid  == top[i]->gen.tgid &&
+			    pps[j].btime == top[i]->gen.btime  )
+				break;
+		}
+
+		if (j < npps)		// already counting?
+		{
+			newpps[i] = pps[j];
+			pps[j].tgid = 0;	// do not detach
+		}
+		else
+		{
+			perfproc_attach(&newpps[i], top[i]->gen.tgid,
+			                            top[i]->gen.btime);
+		}
+	}
+
+	/*
+	** close the events of processes that are not selected any more
+	*/
+	for (j=0; j < npps; j++)
+	{
+		if (pps[j].tgid)
+			perfproc_detach(&pps[j]);
+	}
+
+	free(pps);
+	free(top);
+
+	pps  = newpps;
+	npps = ntop;
+
+	/*
+	** hardware events not supported: release everything
+	*/
+	if (failed)
+	{
+		for (i=0; i < npps; i++)
+			perfproc_detach(&pps[i]);
+
+		npps = 0;
+	}
+}
+
+/*
+** open the perf events for every thread of the given process
+*/
+static void
+perfproc_attach(struct perfproc *pp, pid_t tgid, time_t btime)
+{
+	struct perf_event_attr	pea;
+	struct rlimit		rlim;
+	struct dirent		*entp;
+	char			path[64];
+	DIR			*dirp;
+	int			e, fd;
+
+	pp->tgid  = tgid;
+	pp->btime = btime;
+
+	snprintf(path, sizeof path, "/proc/%d/task", tgid);
+
+	regainrootprivs();
+
+	if ( (dirp = opendir(path)) == NULL)
+	{
+		if (! droprootprivs())
+			mcleanstop(42, "failed to drop root privs\n");
+		return;
+	}
+
+	memset(&pea, 0, sizeof pea);
+
+	pea.type        = PERF_TYPE_HARDWARE;
+	pea.size        = sizeof pea;
+	pea.inherit     = 1;
+	pea.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+	                  PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	while ( (entp = readdir(dirp)) )
+	{
+		if (!isdigit(entp->d_name[0]))
+			continue;
+
+		if (nrfds + NRPERFEVPROC > MAXPERFFDS)
+			break;
+
+		if (pp->nrthreads == pp->maxthreads)
+		{
+			pp->maxthreads = pp->maxthreads ? pp->maxthreads*2 : 8;
+			pp->fds = realloc(pp->fds,
+				pp->maxthreads * NRPERFEVPROC * sizeof(int));
+
+			ptrverify(pp->fds,
+				"Malloc failed for perf events of PID %d\n", tgid);
+		}
+
+		/*
+		** take care that enough open files are allowed
+		** for this process
+		*/
+		getrlimit(RLIMIT_NOFILE, &rlim);
+
+		if (rlim.rlim_cur < nrfds + NRPERFEVPROC + 256 &&
+		    rlim.rlim_cur < rlim.rlim_max)
+		{
+			rlim.rlim_cur = nrfds + NRPERFEVPROC + 256;
+
+			if (rlim.rlim_cur > rlim.rlim_max)
+				rlim.rlim_cur = rlim.rlim_max;
+
+			(void) setrlimit(RLIMIT_NOFILE, &rlim);
+		}
+
+		for (e=0; e < NRPERFEVPROC; e++)
+		{
+			pea.config = perfevproc[e];
+
+			fd = perf_event_open(&pea, atoi(entp->d_name), -1, -1,
+			                     PERF_FLAG_FD_CLOEXEC);
+
+			pp->fds[pp->nrthreads*NRPERFEVPROC+e] = fd;
+
+			if (fd != -1)
+			{
+				nrfds++;
+				continue;
+			}
+
+			/*
+			** no support for hardware events at all by the
+			** kernel (or hypervisor) or no permission?
+			** then stop trying (errors like ESRCH only concern
+			** a thread that exited in the meantime)
+			*/
+			switch (errno)
+			{
+			   case ENOENT:
+			   case ENODEV:
+			   case ENOSYS:
+			   case EOPNOTSUPP:
+			   case EACCES:
+			   case EPERM:
+				failed = 1;
+			}
+		}
+
+		pp->nrthreads++;
+	}
+
+	closedir(dirp);
+
+	if (! droprootprivs())
+		mcleanstop(42, "failed to drop root privs\n");
+}
+
+/*
+** close the perf events of the given process
+*/
+static void
+perfproc_detach(struct perfproc *pp)
+{
+	int	i;
+
+	for (i=0; i < pp->nrthreads * NRPERFEVPROC; i++)
+	{
+		if (pp->fds[i] != -1)
+		{
+			close(pp->fds[i]);
+			nrfds--;
+		}
+	}
+
+	free(pp->fds);
+
+	memset(pp, 0, sizeof *pp);
+}
+
+/*
+** fill the hardware counters of a process (if selected)
+*/
+void
+perfproc_gettask(struct tstat *curtask)
+{
+	struct perfproc	*pp;
+	count_t		*cnt[NRPERFEVPROC];
+	struct {
+		__u64	value;
+		__u64	time_enabled;
+		__u64	time_running;
+	} rv;
+	int		i, t, e;
+
+	for (i=0; i < npps; i++)
+	{
+		if (pps[i].tgid  == curtask->gen.tgid &&
+		    pps[i].btime == curtask->gen.btime  )
+			break;
+	}
+
+	if (i == npps)		// not selected
+		return;
+
+	pp = &pps[i];
+
+	cnt[0] = &curtask->cpu.cycle;
+	cnt[1] = &curtask->cpu.instr;
+	cnt[2] = &curtask->cpu.llcmiss;
+
+	for (t=0; t < pp->nrthreads; t++)
+	{
+		for (e=0; e < NRPERFEVPROC; e++)
+		{
+			int fd = pp->fds[t*NRPERFEVPROC+e];
+
+			if (fd == -1)
+				continue;
+
+			if (read(fd, &rv, sizeof rv) < sizeof rv ||
+			    rv.time_running == 0)
+				continue;
+
+			/*
+			** scale the counter when the event has been
+			** multiplexed with other events
+			*/
+			if (rv.time_running < rv.time_enabled)
+				rv.value = (double)rv.value *
+				           rv.time_enabled / rv.time_running;
+
+			*cnt[e] += rv.value;
+		}
+	}
+}
+
+#else /* ! NOPERFEVENT */
+
+void
+perfproc_select(struct devtstat *devtstat)
+{
+}
+
+void
+perfproc_gettask(struct tstat *curtask)
+{
+}
+#endif
+
+/*
+** atoprc keyword 'perfprocs': number of processes to count
+*/
+void
+do_perfprocs(char *tagname, char *tagvalue)
+{
+	if ( !numeric(tagvalue) )
+		mcleanstop(1, "atoprc: %s value %s not a (positive) numeric\n",
+				tagname, tagvalue);
+
+	perfprocs = atoi(tagvalue);
+
+#ifdef	NOPERFEVENT
+	if (perfprocs)
+		mcleanstop(1, "atop built with NOPERFEVENT, cannot use perfprocs\n");
+#endif
+}
@@ -45,10 +45,10 @@
 #include <time.h>
 #include <stdlib.h>
 #include <regex.h>
-#include <glib.h>
 
 #include "atop.h"
 #include "photoproc.h"
+#include "cgroups.h"
 #include "netatop.h"
 
 #define	SCANSTAT 	"%c   %d   %*d  %*d  %*d %*d  "	\
@@ -67,8 +67,7 @@ static void	procsmaps(struct tstat *);
 static void	procoomscore(struct tstat *);
 static void	procwchan(struct tstat *);
 static count_t	procschedstat(struct tstat *);
-
-extern GHashTable *ghash_net;
+static char	*nextprocname(DIR *, pid_t *, int, int *, char *, int);
 
 extern char	prependenv;
 extern regex_t  envregex;
@@ -83,8 +82,10 @@ photoproc(struct tstat *tasklist, int maxtask)
 	register struct tstat	*curtask;
 
 	FILE		*fp;
-	DIR		*dirp;
-	struct dirent	*entp;
+	DIR		*dirp = NULL;
+	pid_t		*selpids;
+	int		nselpids, selix = 0;
+	char		*procname, namebuf[16];
 	char		origdir[4096], dockstat=0;
 	unsigned long	tval=0;
 
@@ -148,7 +149,9 @@ photoproc(struct tstat *tasklist, int maxtask)
 		mcleanstop(42, "failed to drop root privs\n");
 
 	/*
-	** read all subdirectory-names below the /proc directory
+	** read all subdirectory-names below the /proc directory,
+	** or only visit the processes of the selected cgroup subtrees
+	** when process collection is limited (atoprc 'cgroupprocs')
 	*/
 	if ( getcwd(origdir, sizeof origdir) == NULL)
 		mcleanstop(53, "failed to save current dir\n");
@@ -156,20 +159,16 @@ photoproc(struct tstat *tasklist, int maxtask)
 	if ( chdir("/proc") == -1)
 		mcleanstop(54, "failed to change to /proc\n");
 
-	dirp = opendir(".");
+	if ( (nselpids = cgselectedpids(&selpids)) == -1)
+		dirp = opendir(".");
 
-	while ( (entp = readdir(dirp)) && tval < maxtask )
+	while ( (procname = nextprocname(dirp, selpids, nselpids, &selix,
+				namebuf, sizeof namebuf)) && tval < maxtask )
 	{
-		/*
-		** skip non-numerical names
-		*/
-		if (!isdigit(entp->d_name[0]))
-			continue;
-
 		/*
 		** change to the process' subdirectory
 		*/
-		if ( chdir(entp->d_name) != 0 )
+		if ( chdir(procname) != 0 )
 			continue;
 
 		/*
@@ -218,8 +217,14 @@ photoproc(struct tstat *tasklist, int maxtask)
                 if (getwchan)
                 	procwchan(curtask);
 
+		/*
+		** hardware counters for the processes that consumed
+		** most CPU time during the previous interval (if wanted)
+		*/
+		perfproc_gettask(curtask);
+
 		if (supportflags & NETATOPBPF) {
-			struct taskcount *tc = g_hash_table_lookup(ghash_net, &(curtask->gen.tgid));
+			struct taskcount *tc = netatop_bpf_findtask(curtask->gen.tgid);
 			if (tc) {
 				// printf("%d %d %d %d %d\n",curtask->gen.tgid, tc->tcpsndpacks,  tc->tcprcvpacks, tc->udpsndpacks, tc->udprcvpacks);
 				curtask->net.tcpsnd = tc->tcpsndpacks;
@@ -399,7 +404,8 @@ photoproc(struct tstat *tasklist, int maxtask)
 			; /* leave process-level directory */
 	}
 
-	closedir(dirp);
+	if (dirp)
+		closedir(dirp);
 
 	if ( chdir(origdir) == -1)
 		mcleanstop(55, "cannot change to %s\n", origdir);
@@ -414,6 +420,38 @@ photoproc(struct tstat *tasklist, int maxtask)
 	return tval;
 }
 
+/*
+** deliver the name of the next process directory below /proc,
+** either from the directory itself (nselpids -1) or from
+** the list of PIDs of the selected cgroups
+*/
+static char *
+nextprocname(DIR *dirp, pid_t *selpids, int nselpids, int *selix,
+						char *namebuf, int namelen)
+{
+	struct dirent	*entp;
+
+	if (nselpids >= 0)
+	{
+		if (*selix >= nselpids)
+			return NULL;
+
+		snprintf(namebuf, namelen, "%d", selpids[(*selix)++]);
+		return namebuf;
+	}
+
+	while ( (entp = readdir(dirp)) )
+	{
+		/*
+		** skip non-numerical names
+		*/
+		if (isdigit(entp->d_name[0]))
+			return entp->d_name;
+	}
+
+	return NULL;
+}
+
 /*
 ** count number of tasks in the system, i.e.
 ** the number of processes plus the total number of threads
@@ -71,7 +71,10 @@ struct tstat {
 
 		int	cgroupix;	/* index in devchain -1=invalid */
 					/* lazy filling (parsable/json) */
-		int	ifuture[4];	/* reserved for future use	*/
+		int	naggr;		/* number of exited processes   */
+					/* folded into this summary     */
+					/* (0 = regular process)        */
+		int	ifuture[3];	/* reserved for future use	*/
 	} gen;
 
 	/* CPU STATISTICS						*/
@@ -90,7 +93,9 @@ struct tstat {
 		count_t	blkdelay;	/* blkio delay (ticks)		*/
 		count_t nvcsw;		/* voluntary cxt switch counts  */
 		count_t nivcsw;		/* involuntary csw counts       */
-		count_t	cfuture[3];	/* reserved for future use	*/
+		count_t	cycle;		/* cycles (perfprocs)		*/
+		count_t	instr;		/* instructions (perfprocs)	*/
+		count_t	llcmiss;	/* last-level cache misses	*/
 	} cpu;
 
 	/* DISK STATISTICS						*/
@@ -162,6 +167,7 @@ struct pinfo {
 	struct pinfo	*phnext;	/* next process in hash    chain */
 	struct pinfo	*prnext;	/* next process in residue chain */
 	struct pinfo	*prprev;	/* prev process in residue chain */
+	struct pinfo	*prhnext;	/* next process in residue hash  */
 
 	struct tstat	tstat;		/* per-process statistics        */
 };
@@ -204,4 +210,8 @@ void		deviattask(struct tstat *, unsigned long,
 unsigned long	photoproc(struct tstat *, int);
 unsigned long	counttasks(void);
 
+void		perfproc_select(struct devtstat *);
+void		perfproc_gettask(struct tstat *);
+void		do_perfprocs(char *, char *);
+
 #endif
@@ -52,6 +52,8 @@
 #include <sys/sysmacros.h>
 #include <sys/resource.h>
 #include <limits.h>
+#include <stddef.h>
+#include <sys/inotify.h>
 
 #ifndef	NOPERFEVENT
 #include <linux/perf_event.h>
@@ -93,6 +95,33 @@ enum {
 };
 
 static int	perfevents = PERF_EVENTS_AUTO;
+static int	perfextra;	// extra events wanted (PERFCACHEMISS, ...)
+
+/*
+** hardware events that are counted per CPU as one group:
+** the first event is the group leader, the events with a
+** non-zero flag are only counted when configured (perfextra)
+*/
+static struct perfevent {
+	char	*name;		// name in atoprc (perfextra)
+	int	flag;		// PERF... flag or 0 (always)
+	__u64	config;		// PERF_COUNT_HW_...
+	size_t	offset;		// offset of counter in struct percpu
+} perfevtab[] = {
+	{"instructions",	0,		PERF_COUNT_HW_INSTRUCTIONS,
+					offsetof(struct percpu, instr)},
+	{"cycles",		0,		PERF_COUNT_HW_CPU_CYCLES,
+					offsetof(struct percpu, cycle)},
+	{"cachemiss",		PERFCACHEMISS,	PERF_COUNT_HW_CACHE_MISSES,
+					offsetof(struct percpu, cachemiss)},
+	{"branchmiss",		PERFBRANCHMISS,	PERF_COUNT_HW_BRANCH_MISSES,
+					offsetof(struct percpu, branchmiss)},
+	{"stallcyc",		PERFSTALLCYC,	PERF_COUNT_HW_STALLED_CYCLES_BACKEND,
+					offsetof(struct percpu, stallcyc)},
+};
+
+#define	NRPERFEVENTS	(sizeof perfevtab / sizeof perfevtab[0])
+
 static long	perf_event_open(struct perf_event_attr *, pid_t,
                 int, int, unsigned long);
 static void	getperfevents(struct cpustat *, count_t);
@@ -103,8 +132,15 @@ static int	get_ksm(struct sstat *);
 
 static int	isdisk_name(unsigned int, unsigned int,
 			char *, struct perdsk *, int);
+static int	isdisk_cached(unsigned int, unsigned int,
+			char *, struct perdsk *, int);
+static void	diskchange(void);
+static int	diskstatline(char *, unsigned int *, unsigned int *,
+			char **, count_t *);
+
+#define	DSCOUNTERS	14	// counters used from a line of diskstats
 
-static struct bitmask *numa_allocate_cpumask(void);
+static struct bitmask *numa_allocate_cpumask(int);
 static void	numa_free_cpumask(struct bitmask *);
 static int	numa_parse_bitmap_v2(char *, struct bitmask *);
 
@@ -203,12 +239,11 @@ struct bitmask {
 
 /*
  * Allocate a bitmask for cpus, of a size large enough to
- * match the kernel's cpumask_t.
+ * contain the given number of cpus.
  */
 static struct bitmask *
-numa_allocate_cpumask(void)
+numa_allocate_cpumask(int ncpus)
 {
-	int ncpus = MAXCPU;
 	struct bitmask *bmp;
 
 	bmp = malloc(sizeof(*bmp));
@@ -310,7 +345,7 @@ photosyst(struct sstat *si)
 	static int	wwwvalid = 1;
 #endif
 
-	memset(si, 0, sizeof(struct sstat));
+	sstat_reset(si);
 
 	if ( getcwd(origdir, sizeof origdir) == NULL)
 		mcleanstop(54, "failed to save current dir\n");
@@ -364,11 +399,7 @@ photosyst(struct sstat *si)
 			{
 				i = atoi(&nam[3]);
 
-				if (i >= MAXCPU)
-				{
-					fprintf(stderr, "cpu %s exceeds maximum of %d\n", nam, MAXCPU);
-					continue;
-				}
+				sstat_reserve(si, SACPU, i+1);
 
 				si->cpu.cpu[i].cpunr	= i;
 				si->cpu.cpu[i].online	= 1;
@@ -1089,8 +1120,7 @@ photosyst(struct sstat *si)
 
 			j = strtoul(dentry->d_name + 4, NULL, 0);
 
-			if (j >= MAXNUMA)	// too many NUMA nodes?
-				continue;	// skip (no break, because order unknown)
+			sstat_reserve(si, SAMEMNUMA, j+1);
 
 			si->memnuma.nrnuma++;
 
@@ -1159,6 +1189,9 @@ photosyst(struct sstat *si)
 				if ( nr < 3 || strcmp("Normal", nam) != 0 )
 					continue;
 
+				if (cnts[0] < 0 || cnts[0] >= si->memnuma.nrnuma)
+					continue;
+
 				for (i = 0; i < MAX_ORDER; i++)
 					si->memnuma.numa[cnts[0]].frag += frag[i];
 
@@ -1202,7 +1235,7 @@ photosyst(struct sstat *si)
 					total_frag += (float)prev_free/total_free;
 				}
 
-				if (cnts[0] < MAXNUMA)
+				if (cnts[0] >= 0 && cnts[0] < si->memnuma.nrnuma)
 					si->memnuma.numa[cnts[0]].frag = total_frag/MAX_ORDER;
 			}
 			fclose(fp);
@@ -1217,12 +1250,12 @@ photosyst(struct sstat *si)
 	{
 		char *line = NULL;
 		size_t len = 0;
-		struct bitmask *mask;
-
-		mask = numa_allocate_cpumask();
+		struct bitmask *mask = NULL;
 
 		si->cpunuma.nrnuma = si->memnuma.nrnuma;
 
+		sstat_reserve(si, SACPUNUMA, si->cpunuma.nrnuma);
+
 		for (j=0; j < si->cpunuma.nrnuma; j++)
 		{
 			snprintf(fn, sizeof fn, NUMADIR "/node%d/cpumap", j);
@@ -1231,6 +1264,10 @@ photosyst(struct sstat *si)
 			{
 				if ( getdelim(&line, &len, '\n', fp) > 0 )
 				{
+					// every hex digit represents four cpus
+					if (!mask)
+						mask = numa_allocate_cpumask(strlen(line) * 4);
+
 					if (numa_parse_bitmap_v2(line, mask) < 0)
 					{
 						mcleanstop(54, "failed to parse numa bitmap\n");
@@ -1239,7 +1276,7 @@ photosyst(struct sstat *si)
 				fclose(fp);
 			}
 
-			for (i=0; i < mask->size && i < MAXCPU; i++)
+			for (i=0; mask && i < mask->size && i < si->cpu.maxcpu; i++)
 			{
 				if ( (si->cpu.cpu[i].online &&
 					mask->maskp[i/bitsperlonglong] >> (i % bitsperlonglong)) & 1 )
@@ -1292,6 +1329,8 @@ photosyst(struct sstat *si)
 			if ( (cp = strchr(linebuf, ':')) != NULL)
 				*cp = ' ';      /* substitute ':' by space */
 
+			sstat_reserve(si, SAINTF, i+2);	// including terminator
+
 			nr = sscanf(linebuf,
                                     "%15s %lld %lld %lld %lld %lld %lld %lld "
                                     "%lld %lld %lld %lld %lld %lld %lld %lld "
@@ -1322,24 +1361,17 @@ photosyst(struct sstat *si)
 
 			/*
 			** skip interfaces that are invalidated
-			** (mainly virtual interfaces)
-			** because the total number of interfaces
-			** exceeds the maximum supported by atop (MAXINTF)
 			*/
 			safe_strcpy(ifprop.name, si->intf.intf[i].name, sizeof ifprop.name);
 
 			if (!getifprop(&ifprop))
 				continue;
 
-			/*
-			** accept this interface but skip the remaining
-			** interfaces because we reached the total number
-			** of interfaces supported by atop (MAXINTF)
-			*/
-			if (++i >= MAXINTF-1)
-				break;
+			i++;
 		}
 
+		sstat_reserve(si, SAINTF, i+1);
+
 		si->intf.intf[i].name[0] = '\0'; /* set terminator for table */
 		si->intf.nrintf = i;
 
@@ -1485,6 +1517,12 @@ photosyst(struct sstat *si)
 		fclose(fp);
 	}
 
+	/*
+	** invalidate the cached disk names when disks or
+	** logical volumes have been added or removed
+	*/
+	diskchange();
+
 	/*
 	** check if extended partition-statistics are provided < kernel 2.6
 	*/
@@ -1496,6 +1534,8 @@ photosyst(struct sstat *si)
 
 		while ( fgets(linebuf, sizeof(linebuf), fp) )
 		{
+			sstat_reserve(si, SADSK, i+2);	// including terminator
+
 			nr = sscanf(linebuf,
 			      "%*d %*d %*d %255s %lld %*d %lld %*d "
 			      "%lld %*d %lld %*d %lld %lld %lld",
@@ -1515,16 +1555,17 @@ photosyst(struct sstat *si)
 			*/
 			if (nr == 8)	/* full stats-line ? */
 			{
-				if ( isdisk_name(0, 0, diskname,
+				if ( isdisk_cached(0, 0, diskname,
 				                 &(si->dsk.dsk[i]),
 						 MAXDKNAM) != DSKTYPE)
 				       continue;
-			
-				if (++i >= MAXDSK-1)
-					break;
+
+				i++;
 			}
 		}
 
+		sstat_reserve(si, SADSK, i+1);
+
 		si->dsk.dsk[i].name[0] = '\0'; /* set terminator for table */
 		si->dsk.ndsk = i;
 
@@ -1540,7 +1581,8 @@ photosyst(struct sstat *si)
 	*/
 	if ( (fp = fopen("diskstats", "r")) != NULL)
 	{
-		char 		diskname[256];
+		char 		*diskname;
+		count_t		cnt[DSCOUNTERS];
 		struct perdsk	tmpdsk;
 
 		si->dsk.ndsk = 0;
@@ -1549,62 +1591,70 @@ photosyst(struct sstat *si)
 
 		while ( fgets(linebuf, sizeof(linebuf), fp) )
 		{
-			/* discards are not supported in older kernels */
- 			tmpdsk.ndisc = -1;
+			/*
+			** split the line in identification and counters
+			*/
+			nr = diskstatline(linebuf, &major, &minor, &diskname, cnt);
 
-			nr = sscanf(linebuf,
-			      "%u %u %255s "		// ident
-                              "%lld %*d %lld %*d "	// reads
-			      "%lld %*d %lld %*d "	// writes
-			      "%lld %lld %lld "		// misc
-			      "%lld %*d %lld %*d",	// discards
-				&major, &minor, diskname,
-				&tmpdsk.nread,  &tmpdsk.nrsect,
-				&tmpdsk.nwrite, &tmpdsk.nwsect,
-				&tmpdsk.inflight, &tmpdsk.io_ms, &tmpdsk.avque,
-				&tmpdsk.ndisc,  &tmpdsk.ndsect);
-
-			if (nr >= 10)	/* full stats-line ? */
-			{
-				/*
-  				** when no transfers issued, skip disk (partition)
-				*/
-				if (tmpdsk.nread + tmpdsk.nwrite +
-				     (tmpdsk.ndisc == -1 ? 0 : tmpdsk.ndisc) == 0)
-					continue;
+			if (nr < 11)	/* no full stats-line ? */
+				continue;
 
-				/*
-				** check if this line concerns the entire disk
-				** or just one of the partitions of a disk (to be
-				** skipped)
-				*/
-				switch ( isdisk_name(major, minor, diskname,
-							 &tmpdsk, MAXDKNAM) )
-				{
-				   case NONTYPE:
-				       continue;
+			/*
+			** check if this line concerns the entire disk
+			** or just one of the partitions of a disk (to be
+			** skipped) before any further conversion;
+			** the classification is cached, so this is cheap
+			*/
+			nr = isdisk_cached(major, minor, diskname,
+							&tmpdsk, MAXDKNAM);
+			if (nr == NONTYPE)
+				continue;
 
-				   case DSKTYPE:
-					if (si->dsk.ndsk < MAXDSK-1)
-					  si->dsk.dsk[si->dsk.ndsk++] = tmpdsk;
-					break;
+			tmpdsk.nread    = cnt[0];
+			tmpdsk.nrsect   = cnt[2];
+			tmpdsk.nwrite   = cnt[4];
+			tmpdsk.nwsect   = cnt[6];
+			tmpdsk.inflight = cnt[8];
+			tmpdsk.io_ms    = cnt[9];
+			tmpdsk.avque    = cnt[10];
 
-				   case MDDTYPE:
-					if (si->dsk.nmdd < MAXMDD-1)
-					  si->dsk.mdd[si->dsk.nmdd++] = tmpdsk;
-					break;
+			/* discards are not supported in older kernels */
+			tmpdsk.ndisc    = cnt[11];
+			tmpdsk.ndsect   = cnt[13];
 
-				   case LVMTYPE:
-					if (si->dsk.nlvm < MAXLVM-1)
-					  si->dsk.lvm[si->dsk.nlvm++] = tmpdsk;
-					break;
-				}
+			/*
+			** when no transfers issued, skip disk
+			*/
+			if (tmpdsk.nread + tmpdsk.nwrite +
+			     (tmpdsk.ndisc == -1 ? 0 : tmpdsk.ndisc) == 0)
+				continue;
+
+			switch (nr)
+			{
+			   case DSKTYPE:
+				sstat_reserve(si, SADSK, si->dsk.ndsk+1);
+				si->dsk.dsk[si->dsk.ndsk++] = tmpdsk;
+				break;
+
+			   case MDDTYPE:
+				sstat_reserve(si, SAMDD, si->dsk.nmdd+1);
+				si->dsk.mdd[si->dsk.nmdd++] = tmpdsk;
+				break;
+
+			   case LVMTYPE:
+				sstat_reserve(si, SALVM, si->dsk.nlvm+1);
+				si->dsk.lvm[si->dsk.nlvm++] = tmpdsk;
+				break;
 			}
 		}
 
 		/*
  		** set terminator for table
  		*/
+		sstat_reserve(si, SADSK, si->dsk.ndsk+1);
+		sstat_reserve(si, SAMDD, si->dsk.nmdd+1);
+		sstat_reserve(si, SALVM, si->dsk.nlvm+1);
+
 		si->dsk.dsk[si->dsk.ndsk].name[0] = '\0';
 		si->dsk.mdd[si->dsk.nmdd].name[0] = '\0';
 		si->dsk.lvm[si->dsk.nlvm].name[0] = '\0'; 
@@ -1814,6 +1864,8 @@ photosyst(struct sstat *si)
 
 			if (nr >= 2 )
 			{
+				sstat_reserve(si, SANFSMNT, i+1);
+
 		   		if (strcmp(label, "age:") == 0)
 				{
 				    safe_strcpy(si->nfs.nfsmounts.nfsmnt[i].mountdev, mountdev,
@@ -1833,8 +1885,7 @@ photosyst(struct sstat *si)
 				    si->nfs.nfsmounts.nfsmnt[i].pagesmread    = cnt[6];
 				    si->nfs.nfsmounts.nfsmnt[i].pagesmwrite   = cnt[7];
 
-				    if (++i >= MAXNFSMOUNT-1)
-					break;
+				    i++;
 				}
 			}
 		}
@@ -1964,8 +2015,9 @@ photosyst(struct sstat *si)
 
 			if (nr == 3)		// new container ?
 			{
-				if (++i >= MAXCONTAINER)
-					break;
+				i++;
+
+				sstat_reserve(si, SACONT, i+1);
 
 				si->cfs.cont[i].ctid = ctid;
 			}
@@ -2148,6 +2200,12 @@ photosyst(struct sstat *si)
 	if ( wwwvalid)
 		wwwvalid = getwwwstat(80, &(si->www));
 #endif
+
+	/*
+	** take care that all arrays contain spare (zeroed) entries
+	** beyond the entries in use, as expected by deviatsyst()
+	*/
+	sstat_reservelike(si, si);
 }
 
 /*
@@ -2177,9 +2235,12 @@ abbrevname1(unsigned int major, unsigned int minor,
 
 /*
 ** recognize LVM logical volumes
+**
+** the hash table is sized to the number of dm-devices found
+** (power of 2 with a minimum of MINDMHASH buckets)
 */
-#define	NUMDMHASH	64
-#define	DMHASH(x,y)	(((x)+(y))%NUMDMHASH)	
+#define	MINDMHASH	64
+#define	DMHASH(x,y)	(((x)*31+(y)) & (ndmhash-1))
 #define	MAPDIR		"/dev/mapper"
 
 struct devmap {
@@ -2189,72 +2250,137 @@ struct devmap {
 	struct devmap	*next;
 };
 
+static struct devmap	**devmaps;
+static unsigned int	ndmhash;	// number of hash buckets
+static int		devmapped;	// hash list filled?
+
+static unsigned int	hashsize(unsigned long, unsigned int);
+
+/*
+** determine the number of hash buckets for the given number of entries:
+** a power of 2 with the given minimum
+*/
+static unsigned int
+hashsize(unsigned long nentries, unsigned int minimum)
+{
+	unsigned int	size = minimum;
+
+	while (size < nentries)
+		size *= 2;
+
+	return size;
+}
+
+/*
+** setup a list of major-minor numbers of dm-devices with their
+** corresponding name
+*/
 static void
-lvmmapname(unsigned int major, unsigned int minor,
-		char *curname, struct perdsk *px, int maxlen)
+lvmmapfill(void)
 {
-	static int		firstcall = 1;
-	static struct devmap	*devmaps[NUMDMHASH], *dmp;
-	int			hashix;
+	DIR		*dirp;
+	struct dirent	*dentry;
+	struct stat	statbuf;
+	struct devmap	*dmp, *dmplist = NULL;
+	char		path[PATH_MAX];
+	unsigned long	ndevmaps = 0;
+	int		hashix;
 
-	/*
- 	** setup a list of major-minor numbers of dm-devices with their
-	** corresponding name
-	*/
-	if (firstcall)
+	if ( (dirp = opendir(MAPDIR)) )
 	{
-		DIR		*dirp;
-		struct dirent	*dentry;
-		struct stat	statbuf;
-		char		path[PATH_MAX];
-
-		if ( (dirp = opendir(MAPDIR)) )
+		/*
+ 		** read every directory-entry and search for
+		** block devices
+		*/
+		while ( (dentry = readdir(dirp)) )
 		{
+			snprintf(path, sizeof path, "%s/%s", 
+					MAPDIR, dentry->d_name);
+
+			if ( stat(path, &statbuf) == -1 )
+				continue;
+
+			if ( ! S_ISBLK(statbuf.st_mode) )
+				continue;
 			/*
-	 		** read every directory-entry and search for
-			** block devices
+			** allocate struct to store name
 			*/
-			while ( (dentry = readdir(dirp)) )
-			{
-				snprintf(path, sizeof path, "%s/%s", 
-						MAPDIR, dentry->d_name);
+			if ( !(dmp = malloc(sizeof (struct devmap))))
+				continue;
 
-				if ( stat(path, &statbuf) == -1 )
-					continue;
+			/*
+			** store info in temporary list
+			*/
+			safe_strcpy(dmp->name, dentry->d_name, sizeof dmp->name);
+			dmp->major 	= major(statbuf.st_rdev);
+			dmp->minor 	= minor(statbuf.st_rdev);
 
-				if ( ! S_ISBLK(statbuf.st_mode) )
-					continue;
-				/*
- 				** allocate struct to store name
-				*/
-				if ( !(dmp = malloc(sizeof (struct devmap))))
-					continue;
+			dmp->next	= dmplist;
+			dmplist		= dmp;
+			ndevmaps++;
+		}
 
-				/*
- 				** store info in hash list
-				*/
-				safe_strcpy(dmp->name, dentry->d_name, sizeof dmp->name);
-				dmp->major 	= major(statbuf.st_rdev);
-				dmp->minor 	= minor(statbuf.st_rdev);
+		closedir(dirp);
+	}
 
-				hashix = DMHASH(dmp->major, dmp->minor);
+	/*
+	** now that the number of dm-devices is known,
+	** store them in a hash list of proper size
+	*/
+	ndmhash = hashsize(ndevmaps, MINDMHASH);
+	devmaps = calloc(ndmhash, sizeof *devmaps);
 
-				dmp->next	= devmaps[hashix];
+	ptrverify(devmaps, "Malloc failed for %u dm-device buckets\n", ndmhash);
 
-				devmaps[hashix]	= dmp;
-			}
+	for (dmp = dmplist; dmp; dmp = dmplist)
+	{
+		dmplist		= dmp->next;
+		hashix		= DMHASH(dmp->major, dmp->minor);
+		dmp->next	= devmaps[hashix];
+		devmaps[hashix]	= dmp;
+	}
 
-			closedir(dirp);
-		}
+	devmapped = 1;
+}
 
-		firstcall = 0;
+/*
+** remove the list of dm-devices (to be refilled when needed)
+*/
+static void
+lvmmapfree(void)
+{
+	struct devmap	*dmp, *dmpnext;
+	int		hashix;
+
+	for (hashix=0; hashix < ndmhash; hashix++)
+	{
+		for (dmp = devmaps[hashix]; dmp; dmp = dmpnext)
+		{
+			dmpnext = dmp->next;
+			free(dmp);
+		}
 	}
 
+	free(devmaps);
+
+	devmaps   = NULL;
+	ndmhash   = 0;
+	devmapped = 0;
+}
+
+static void
+lvmmapname(unsigned int major, unsigned int minor,
+		char *curname, struct perdsk *px, int maxlen)
+{
+	struct devmap	*dmp;
+
+	if (!devmapped)
+		lvmmapfill();
+
 	/*
  	** find info in hash list
 	*/
-	hashix  = DMHASH(major, minor);
-	dmp	= devmaps[hashix];
+	dmp = devmaps[DMHASH(major, minor)];
 
 	while (dmp)
 	{
@@ -2375,6 +2501,295 @@ isdisk_major(unsigned int major)
 	return NONTYPE;
 }
 
+/*
+** cache with the results of isdisk_name() per line of
+** /proc/diskstats (or /proc/partitions), to avoid that all
+** regular expressions have to be matched and the dm-names
+** have to be resolved again for every line in every sample
+**
+** the cache is invalidated when the number of lines in /proc/diskstats
+** changes (disks or partitions added or removed) or when logical volumes
+** are added, removed or renamed (detected via inotify on /dev/mapper);
+** a lookup miss in a filled cache refreshes the list of dm-names,
+** so a new logical volume is shown with its proper name immediately
+**
+** the hash table is sized to the number of lines in /proc/diskstats
+** of the previous sample (power of 2 with a minimum of MINDNHASH buckets)
+**
+** the efficiency of the cache is counted (hits, misses and flushes since
+** the start); atop does not report these counters itself, but they are
+** shown by the diskstats benchmark in the tools directory
+*/
+#define	MINDNHASH	256
+
+struct diskname {
+	unsigned int	major;
+	unsigned int	minor;
+	char		*curname;	// name in /proc/diskstats
+	unsigned int	hash;		// hash value (before modulo)
+	int		retval;		// DSKTYPE, MDDTYPE, LVMTYPE, NONTYPE
+	char		name[MAXDKNAM];	// modified name
+	struct diskname	*next;
+};
+
+static struct diskname	**disknames;
+static unsigned int	ndnhash;	// number of hash buckets
+static unsigned long	dnlookups, dnprevlookups;	// per sample
+static int		dnfilled;	// cache filled in previous sample?
+static int		dnremapped;	// dm-names refreshed in this sample?
+static unsigned long	dnhits, dnmisses, dnflushes;	// since start
+static int		inotfd = -1;
+
+static unsigned int
+dnhash(unsigned int major, unsigned int minor, char *name)
+{
+	unsigned int	hash = major * 31 + minor;
+
+	while (*name)
+		hash = hash * 33 + (unsigned char)*name++;
+
+	return hash;
+}
+
+/*
+** (re)size the hash table of the disk name cache
+** for the given number of lines in /proc/diskstats
+*/
+static void
+dnresize(unsigned long nlines)
+{
+	struct diskname	**newnames, *dnp, *dnpnext;
+	unsigned int	newsize = hashsize(nlines, MINDNHASH), i, hashix;
+
+	if (newsize == ndnhash)
+		return;
+
+	newnames = calloc(newsize, sizeof *newnames);
+
+	ptrverify(newnames, "Malloc failed for %u disk name buckets\n", newsize);
+
+	for (i=0; i < ndnhash; i++)
+	{
+		for (dnp = disknames[i]; dnp; dnp = dnpnext)
+		{
+			dnpnext		 = dnp->next;
+			hashix		 = dnp->hash & (newsize-1);
+			dnp->next	 = newnames[hashix];
+			newnames[hashix] = dnp;
+		}
+	}
+
+	free(disknames);
+
+	disknames = newnames;
+	ndnhash   = newsize;
+}
+
+/*
+** remove all cached disk names (including the dm-names)
+*/
+static void
+diskflush(void)
+{
+	struct diskname	*dnp, *dnpnext;
+	int		i;
+
+	for (i=0; i < ndnhash; i++)
+	{
+		for (dnp = disknames[i]; dnp; dnp = dnpnext)
+		{
+			dnpnext = dnp->next;
+			free(dnp->curname);
+			free(dnp);
+		}
+
+		disknames[i] = NULL;
+	}
+
+	lvmmapfree();
+
+	dnfilled = 0;
+	dnflushes++;
+}
+
+/*
+** verify once per sample (before the lookups) if disks or logical
+** volumes have been added or removed since the previous sample to
+** invalidate the cache
+*/
+static void
+diskchange(void)
+{
+	static int	firstcall = 1;
+	char		evbuf[4096];
+	int		changed = 0;
+
+	if (firstcall)
+	{
+		if ( (inotfd = inotify_init1(IN_NONBLOCK|IN_CLOEXEC)) != -1)
+		{
+			/*
+			** without the watch the cache is still used,
+			** as was the original list of dm-names
+			*/
+			if (inotify_add_watch(inotfd, MAPDIR,
+				IN_CREATE|IN_DELETE|IN_MOVED_FROM|IN_MOVED_TO) == -1)
+			{
+				close(inotfd);
+				inotfd = -1;
+			}
+		}
+
+		firstcall = 0;
+	}
+
+	/*
+	** consume all pending events
+	*/
+	if (inotfd != -1)
+	{
+		while (read(inotfd, evbuf, sizeof evbuf) > 0)
+			changed = 1;
+	}
+
+	/*
+	** another number of lines in /proc/diskstats than during the
+	** previous sample: remove the entries of vanished devices
+	*/
+	if (dnprevlookups && dnlookups != dnprevlookups)
+		changed = 1;
+
+	if (changed)
+		diskflush();
+	else if (dnlookups)
+		dnfilled = 1;
+
+	dnprevlookups = dnlookups;
+	dnlookups     = 0;
+	dnremapped    = 0;
+
+	dnresize(dnprevlookups);
+}
+
+/*
+** split a line of /proc/diskstats in major, minor, name (terminated
+** in the line buffer itself) and DSCOUNTERS counters
+** (counters that are not present are set to -1)
+**
+** this replaces a sscanf() per line that is relatively expensive
+** on systems with thousands of (mostly unused) devices and partitions
+**
+** return value: number of counters found
+*/
+static int
+diskstatline(char *line, unsigned int *major, unsigned int *minor,
+             char **name, count_t *cnt)
+{
+	char	*p = line, *q;
+	int	n;
+
+	*major = strtoul(p, &q, 10);
+
+	if (q == p)
+		return 0;
+
+	*minor = strtoul(q, &p, 10);
+
+	while (*p == ' ')
+		p++;
+
+	*name = p;
+
+	while (*p && *p != ' ' && *p != '\n')
+		p++;
+
+	if (*p == '\0' || p == *name)
+		return 0;
+
+	*p++ = '\0';
+
+	for (n=0; n < DSCOUNTERS; n++)
+	{
+		cnt[n] = strtoll(p, &q, 10);
+
+		if (q == p)
+			break;
+
+		p = q;
+	}
+
+	memset(cnt+n, -1, (DSCOUNTERS-n) * sizeof(count_t));
+
+	return n;
+}
+
+static int
+isdisk_cached(unsigned int major, unsigned int minor,
+           char *curname, struct perdsk *px, int maxlen)
+{
+	struct diskname	*dnp;
+	unsigned int	hash = dnhash(major, minor, curname), hashix;
+
+	if (!ndnhash)
+		dnresize(0);
+
+	hashix = hash & (ndnhash-1);
+
+	dnlookups++;
+
+	for (dnp = disknames[hashix]; dnp; dnp = dnp->next)
+	{
+		if (dnp->hash  == hash  &&
+		    dnp->major == major && dnp->minor == minor &&
+		    strcmp(dnp->curname, curname) == 0)
+		{
+			dnhits++;
+
+			if (dnp->retval != NONTYPE)
+				safe_strcpy(px->name, dnp->name, maxlen);
+
+			return dnp->retval;
+		}
+	}
+
+	/*
+	** not cached yet: determine type and name and cache the result
+	**
+	** when the cache was already filled, this is a new device
+	** that might be a logical volume not known yet as dm-name
+	*/
+	dnmisses++;
+
+	if (dnfilled && !dnremapped)
+	{
+		lvmmapfree();
+		dnremapped = 1;
+	}
+
+	px->name[0] = '\0';
+
+	if ( (dnp = malloc(sizeof *dnp)) == NULL)
+		return isdisk_name(major, minor, curname, px, maxlen);
+
+	if ( (dnp->curname = strdup(curname)) == NULL)
+	{
+		free(dnp);
+		return isdisk_name(major, minor, curname, px, maxlen);
+	}
+
+	dnp->major  = major;
+	dnp->minor  = minor;
+	dnp->hash   = hash;
+	dnp->retval = isdisk_name(major, minor, curname, px, maxlen);
+
+	safe_strcpy(dnp->name, px->name, sizeof dnp->name);
+
+	dnp->next         = disknames[hashix];
+	disknames[hashix] = dnp;
+
+	return dnp->retval;
+}
+
 
 /*
 ** get stats of all InfiniBand ports below
@@ -2916,13 +3331,25 @@ perf_event_open(struct perf_event_attr *hwevent, pid_t pid,
 	return syscall(__NR_perf_event_open, hwevent, pid, cpu, groupfd, flags);
 }
 
+/*
+** per CPU one group of perf events is opened with the
+** instructions counter as group leader, so all counters
+** of a CPU can be retrieved with one read() on the leader
+*/
+struct perfcpu {
+	int	nrevents;		// number of events in group
+	int	fds[NRPERFEVENTS];	// file descriptors (leader first)
+	int	evix[NRPERFEVENTS];	// index in perfevtab per fd
+};
+
 static void
 getperfevents(struct cpustat *cs, count_t onliners)
 {
-	static int	cpualloced, prev_nrcpu, *fdi, *fdc;
-	static count_t	prev_onliners;
-	int		i;
-	int 		liResult;
+	static int		cpualloced, prev_nrcpu;
+	static struct perfcpu	*pcs;
+	static count_t		prev_onliners;
+	static int		countedextra;
+	int			i, e;
 
 	/*
 	** irrecoverable failure?
@@ -2945,7 +3372,7 @@ getperfevents(struct cpustat *cs, count_t onliners)
 	if (cpualloced != cs->maxcpu || prev_onliners != onliners || prev_nrcpu != cs->nrcpu)
 	{
 		struct perf_event_attr  pea;
-		int			success=0, minfds = cs->nrcpu*2 + 32;
+		int			success=0, nrevents=0, minfds;
 		struct rlimit		rlim;
 
 		if (cpualloced > 0)		// already initialized before?
@@ -2956,24 +3383,28 @@ getperfevents(struct cpustat *cs, count_t onliners)
 
 			for (i=0; i < cpualloced; i++)
 			{
-				if ( *(fdi+i) )		// in use?
-					close( *(fdi+i) );
-
-				if ( *(fdc+i) )		// in use?
-					close( *(fdc+i) );
+				for (e=(pcs+i)->nrevents-1; e >= 0; e--)
+					close((pcs+i)->fds[e]);
 			}
 
 			if (! droprootprivs())
 				mcleanstop(42, "failed to drop root privs\n");
 
-			free(fdi);
-			free(fdc);
+			free(pcs);
 		}
-	
-		/* for perf events two file descriptors will
+
+		for (e=0; e < NRPERFEVENTS; e++)
+		{
+			if (!perfevtab[e].flag || perfevtab[e].flag & perfextra)
+				nrevents++;
+		}
+
+		/* for perf events one file descriptor per event will
 		** be opened permanently per CPU, so take care
 		** that enough open files are allowed for this process
 		*/
+		minfds = cs->nrcpu*nrevents + 32;
+
 		getrlimit(RLIMIT_NOFILE, &rlim);
 
 		if (rlim.rlim_cur < minfds)	// default not enough?
@@ -2989,37 +3420,62 @@ getperfevents(struct cpustat *cs, count_t onliners)
 		prev_nrcpu    = cs->nrcpu;
 
 		cpualloced    = cs->maxcpu;
-		fdi           = calloc(cpualloced, sizeof(int));
-		fdc           = calloc(cpualloced, sizeof(int));
+		pcs           = calloc(cpualloced, sizeof(struct perfcpu));
+
+		ptrverify(pcs, "Malloc failed for perf event descriptors\n");
 
 		/*
 		** fill perf_event_attr struct with appropriate values
+		**
+		** when only instructions and cycles are counted, the group
+		** is pinned (these events fit in the fixed counters);
+		** with extra events the group might have to be multiplexed
+		** with other users of the PMU, so the time enabled/running
+		** is retrieved as well to be able to scale the counters
 		*/
 		memset(&pea, 0, sizeof(struct perf_event_attr));
 
-		pea.type    = PERF_TYPE_HARDWARE;
-		pea.size    = sizeof(struct perf_event_attr);
-		pea.inherit = 1;
-		pea.pinned  = 1;
+		pea.type        = PERF_TYPE_HARDWARE;
+		pea.size        = sizeof(struct perf_event_attr);
+		pea.read_format = PERF_FORMAT_GROUP |
+		                  PERF_FORMAT_TOTAL_TIME_ENABLED |
+		                  PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		countedextra = 0;
 
 	 	regainrootprivs();
 
 		for (i=0; i < cpualloced; i++)
 		{
+			struct perfcpu	*pc = pcs+i;
+			int		fd;
+
 			if (!cs->cpu[i].online)
 				continue;
 
-			pea.config = PERF_COUNT_HW_INSTRUCTIONS;
+			for (e=0; e < NRPERFEVENTS; e++)
+			{
+				if (perfevtab[e].flag && !(perfevtab[e].flag & perfextra))
+					continue;
 
-			if ( (*(fdi+i) = perf_event_open(&pea, -1, i, -1,
- 						PERF_FLAG_FD_CLOEXEC)) >= 0)
-				success++;
+				if (e > 0 && pc->nrevents == 0)	// no leader?
+					break;
+
+				pea.config = perfevtab[e].config;
+				pea.pinned = (e == 0 && !perfextra);
 
-			pea.config = PERF_COUNT_HW_CPU_CYCLES;
+				if ( (fd = perf_event_open(&pea, -1, i,
+				     	pc->nrevents ? pc->fds[0] : -1,
+ 					PERF_FLAG_FD_CLOEXEC)) == -1)
+					continue;
 
-			if ( (*(fdc+i) = perf_event_open(&pea, -1, i, -1,
-						PERF_FLAG_FD_CLOEXEC)) >= 0)
+				pc->fds [pc->nrevents] = fd;
+				pc->evix[pc->nrevents] = e;
+				pc->nrevents++;
+
+				countedextra |= perfevtab[e].flag;
 				success++;
+			}
 		}
 
 		if (! droprootprivs())
@@ -3030,14 +3486,14 @@ getperfevents(struct cpustat *cs, count_t onliners)
 		*/
 		if (success == 0)	
 		{
-			free(fdi);
-			free(fdc);
+			free(pcs);
 			cpualloced = -1;	// irrecoverable failure
 		}
 		else
 		{
 			cs->all.instr = 1;
 			cs->all.cycle = 1;
+			cs->perfextra = countedextra;
 		}
 
 		return;		// initialization finished for first sample
@@ -3050,51 +3506,81 @@ getperfevents(struct cpustat *cs, count_t onliners)
                 return;
 
 	/*
-   	** retrieve counters per CPU and in total
+   	** retrieve counters per CPU (one read for the entire group)
+	** and accumulate them in total
 	*/
-	cs->all.instr = 0;
-	cs->all.cycle = 0;
+	cs->perfextra = countedextra;
 
         for (i=0; i < cpualloced; i++)
         {
-		if (!cs->cpu[i].online)
+		struct perfcpu	*pc = pcs+i;
+		count_t		*cnt;
+		ssize_t		rv;
+		struct {
+			__u64	nr;
+			__u64	time_enabled;
+			__u64	time_running;
+			__u64	values[NRPERFEVENTS];
+		} grp;
+
+		if (!cs->cpu[i].online || pc->nrevents == 0)
 			continue;
 
-		if (*(fdi+i) != -1)
+		rv = read(pc->fds[0], &grp, sizeof grp);
+
+		if (rv < 0)
 		{
-                	liResult = read(*(fdi+i), &(cs->cpu[i].instr), sizeof(count_t));
+			fprintf(stderr, "%s:%d - Error %d reading perf counters\n",
+		        				__FILE__, __LINE__, errno);
+			continue;
+		}
 
-			if(liResult < 0)
-			{
-				char lcMessage[64];
+		if (rv < 3 * sizeof(__u64) || grp.nr > pc->nrevents ||
+		    grp.time_running == 0)	// not (yet) counted
+			continue;
 
-				snprintf(lcMessage, sizeof(lcMessage) - 1,
-				          "%s:%d - Error %d reading instr counters\n",
-				           __FILE__, __LINE__, errno);
-				fprintf(stderr, "%s", lcMessage);
-			}
+		for (e=0; e < grp.nr; e++)
+		{
+			cnt = (count_t *)((char *)&(cs->cpu[i]) +
+					perfevtab[pc->evix[e]].offset);
+
+			if (grp.time_running < grp.time_enabled)  // multiplexed?
+				*cnt = (double)grp.values[e] *
+				       grp.time_enabled / grp.time_running;
 			else
-			{
-                        	cs->all.instr += cs->cpu[i].instr;
-			}
+				*cnt = grp.values[e];
 
-                	liResult = read(*(fdc+i), &(cs->cpu[i].cycle), sizeof(count_t));
+			*(count_t *)((char *)&(cs->all) +
+				perfevtab[pc->evix[e]].offset) += *cnt;
+		}
+        }
+}
 
-			if(liResult < 0)
-			{
-				char lcMessage[64];
+/*
+** configure the extra perf events to be counted per CPU
+** (comma-separated list of names)
+*/
+void
+do_perfextra(char *tagname, char *tagvalue)
+{
+	char	*ep;
+	int	e;
 
-				snprintf(lcMessage, sizeof(lcMessage) - 1,
-				          "%s:%d - Error %d reading cycle counters\n",
-				           __FILE__, __LINE__, errno );
-				fprintf(stderr, "%s", lcMessage);
-			}
-			else
+	for (ep = strtok(tagvalue, ", \t\n"); ep; ep = strtok(NULL, ", \t\n"))
+	{
+		for (e=0; e < NRPERFEVENTS; e++)
+		{
+			if (perfevtab[e].flag && strcmp(ep, perfevtab[e].name) == 0)
 			{
-                        	cs->all.cycle += cs->cpu[i].cycle;
+				perfextra |= perfevtab[e].flag;
+				break;
 			}
 		}
-        }
+
+		if (e == NRPERFEVENTS)
+			mcleanstop(1, "%s: unknown perf event '%s'\n",
+							tagname, ep);
+	}
 }
 
 #else /* ! NOPERFEVENT */
@@ -3104,4 +3590,10 @@ do_perfevents(char *tagname, char *tagvalue)
 	if (strcmp("disable", tagvalue))
 		mcleanstop(1, "atop built with NOPERFEVENT, cannot use perfevents\n");
 }
+
+void
+do_perfextra(char *tagname, char *tagvalue)
+{
+	mcleanstop(1, "atop built with NOPERFEVENT, cannot use perfextra\n");
+}
 #endif
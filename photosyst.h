@@ -26,14 +26,6 @@
 
 #include "netstats.h"
 
-#define	MAXCPU		4096	// specify power of two
-#define	MAXDSK		1024
-#define	MAXNUMA		1024
-#define	MAXLVM		2048
-#define	MAXMDD		256
-#define	MAXINTF		128
-#define	MAXCONTAINER	128
-#define	MAXNFSMOUNT	64
 #define	MAXIBPORT	32
 #define	MAXGPU		32
 #define	MAXGPUBUS	12
@@ -43,6 +35,23 @@
 #define	MAXDKNAM	32
 #define	MAXIBNAME	20
 
+/*
+** the number of CPUs, disks, interfaces, NFS mounts, containers
+** and NUMA nodes is not limited: these per-entity arrays are
+** dynamically allocated (see sstatmem.c) and identified by
+** the following indexes
+*/
+#define	SACPU		0	// cpu.cpu
+#define	SADSK		1	// dsk.dsk
+#define	SAMDD		2	// dsk.mdd
+#define	SALVM		3	// dsk.lvm
+#define	SAINTF		4	// intf.intf
+#define	SANFSMNT	5	// nfs.nfsmounts.nfsmnt
+#define	SACONT		6	// cfs.cont
+#define	SAMEMNUMA	7	// memnuma.numa
+#define	SACPUNUMA	8	// cpunuma.numa
+#define	NRSARRAYS	9
+
 /************************************************************************/
 struct	memstat {
 	count_t	physmem;	// number of physical pages
@@ -130,7 +139,7 @@ struct	mempernuma {
 
 struct	memnuma {
 	count_t           nrnuma;		/* the counts of numa		*/
-	struct mempernuma numa[MAXNUMA];
+	struct mempernuma *numa;
 };
 
 struct	cpupernuma {
@@ -150,7 +159,7 @@ struct	cpupernuma {
 
 struct	cpunuma {
 	count_t           nrnuma;		/* the counts of numa		*/
-	struct cpupernuma numa[MAXNUMA];
+	struct cpupernuma *numa;
 };
 
 /************************************************************************/
@@ -192,7 +201,10 @@ struct percpu {
         struct freqcnt	freqcnt;/* frequency scaling info  		*/
 	count_t		instr;	/* CPU instructions 			*/
 	count_t		cycle;	/* CPU cycles 				*/
-	count_t		cfuture[6];	/* reserved for future use	*/
+	count_t		cachemiss;	/* cache misses (perfextra)	*/
+	count_t		branchmiss;	/* branch misses (perfextra)	*/
+	count_t		stallcyc;	/* stalled cycles (perfextra)	*/
+	count_t		cfuture[3];	/* reserved for future use	*/
 };
 
 struct	cpustat {
@@ -204,12 +216,20 @@ struct	cpustat {
 	float	lavg1;	/* load average last    minute          */
 	float	lavg5;	/* load average last  5 minutes         */
 	float	lavg15;	/* load average last 15 minutes         */
-	count_t	cfuture[4];	/* reserved for future use	*/
+	count_t	perfextra;	/* extra perf events counted	*/
+	count_t	cfuture[3];	/* reserved for future use	*/
 
 	struct percpu   all;
-	struct percpu   cpu[MAXCPU];
+	struct percpu   *cpu;
 };
 
+/*
+** extra perf events that can be counted per CPU (perfextra)
+*/
+#define	PERFCACHEMISS	0x01
+#define	PERFBRANCHMISS	0x02
+#define	PERFSTALLCYC	0x04
+
 /************************************************************************/
 
 struct	perdsk {
@@ -230,9 +250,9 @@ struct dskstat {
 	int		ndsk;	/* number of physical disks	*/
 	int		nmdd;	/* number of md volumes		*/
 	int		nlvm;	/* number of logical volumes	*/
-	struct perdsk	dsk[MAXDSK];
-	struct perdsk	mdd[MAXMDD];
-	struct perdsk	lvm[MAXLVM];
+	struct perdsk	*dsk;
+	struct perdsk	*mdd;
+	struct perdsk	*lvm;
 };
 
 /************************************************************************/
@@ -269,7 +289,7 @@ struct	perintf {
 
 struct intfstat {
 	int		nrintf;
-	struct perintf	intf[MAXINTF];
+	struct perintf	*intf;
 };
 
 /************************************************************************/
@@ -328,7 +348,7 @@ struct nfsstat {
 
 	struct {
         	int             	nrmounts;
-       		struct pernfsmount	nfsmnt[MAXNFSMOUNT];
+       		struct pernfsmount	*nfsmnt;
 	} nfsmounts;
 };
 
@@ -366,7 +386,7 @@ struct  percontainer {
 
 struct contstat {
         int             	nrcontainer;
-        struct percontainer	cont[MAXCONTAINER];
+        struct percontainer	*cont;
 };
 
 /************************************************************************/
@@ -463,6 +483,8 @@ struct	sstat {
 	struct llcstat  llc;
 
 	struct wwwstat	www;
+
+	int		arrsize[NRSARRAYS];	// allocated array entries
 };
 
 /*
@@ -472,10 +494,19 @@ void	photosyst (struct sstat *);
 void	deviatsyst(struct sstat *, struct sstat *, struct sstat *, long);
 void	totalsyst (char,           struct sstat *, struct sstat *);
 void	do_perfevents(char *, char *);
+void	do_perfextra(char *, char *);
 int     isdisk_major(unsigned int);
 void	realnuma_support(void);
 void	zswap_support(void);
 
+void		sstat_reserve(struct sstat *, int, long);
+void		sstat_reservelike(struct sstat *, struct sstat *);
+void		sstat_reset(struct sstat *);
+void		sstat_free(struct sstat *);
+unsigned long	sstat_packlen(struct sstat *);
+void		sstat_pack(struct sstat *, void *);
+int		sstat_unpack(struct sstat *, void *, unsigned long);
+
 /*
 ** return value of isdisk_...()
 */
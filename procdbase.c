@@ -45,7 +45,7 @@
 #include "photoproc.h"
 
 /*****************************************************************************/
-#define	NPHASH	256		/* number of hash queues for process dbase   */
+#define	NPHASH	4096		/* number of hash queues for process dbase   */
 				/* MUST be a power of 2 !!!                  */
 
 	/* hash buckets for getting process-info     */
@@ -55,6 +55,19 @@ static struct pinfo	*phash[NPHASH];
 	/* cyclic list of all processes, to detect   */
 	/* which processes were not referred	     */
 static struct pinfo	presidue;
+
+	/* hash buckets to search the RESIDUE-list   */
+	/* for exited processes without known PID    */
+	/* (built when needed, once per sample)      */
+static struct pinfo	**prhash;
+static unsigned long	nprhash;	/* number of buckets (power of 2)    */
+static char		prhashvalid;	/* buckets reflect RESIDUE-list      */
+
+#define	NPRHASHMIN	256		/* minimum number of residue buckets */
+
+static unsigned long	pdb_residuehash(struct tstat *, time_t);
+static void		pdb_buildresidue(void);
+static void		pdb_unhashresidue(struct pinfo *);
 /*****************************************************************************/
 
 
@@ -95,6 +108,9 @@ pdb_gettask(int pid, char isproc, time_t btime, struct pinfo **pinfopp)
 
 			if (pp->prnext)		/* if part of RESIDUE-list   */
 			{
+				if (prhashvalid)
+					pdb_unhashresidue(pp);
+
 				(pp->prnext)->prprev = pp->prprev; /* unchain */
 				(pp->prprev)->prnext = pp->prnext;
 			}
@@ -147,6 +163,9 @@ pdb_deltask(int pid, char isproc)
 
 		if ( pp->prnext )	/* still part of RESIDUE-list ? */
 		{
+			if (prhashvalid)
+				pdb_unhashresidue(pp);
+
 			(pp->prprev)->prnext = pp->prnext;
 			(pp->prnext)->prprev = pp->prprev;	/* unchain */
 		}
@@ -177,6 +196,9 @@ pdb_deltask(int pid, char isproc)
 
 			if ( pp->prnext )	/* part of RESIDUE-list ? */
 			{
+				if (prhashvalid)
+					pdb_unhashresidue(pp);
+
 				(pp->prnext)->prprev = pp->prprev;
 				(pp->prprev)->prnext = pp->prnext;
 			}
@@ -217,6 +239,8 @@ pdb_makeresidue(void)
 	pr->prnext	= pr;
 	pr->prprev	= pr;
 
+	prhashvalid	= 0;
+
 	/*
 	** check all entries in hash list
 	*/
@@ -255,6 +279,8 @@ pdb_cleanresidue(void)
 	register int		pid;
         char			isproc;
 
+	prhashvalid = 0;
+
 	/*
 	** start at RESIDUE-list anchor and delete all entries
 	*/
@@ -276,61 +302,137 @@ pdb_cleanresidue(void)
 /*
 ** search in the RESIDUE-list for process-info which may fit to the
 ** given process-info, for which the PID is not known
+**
+** the RESIDUE-list is not scanned for every exited process (which
+** is quadratic with many exits in one interval), but a hash list
+** is built once per sample over all remaining entries, with the name,
+** real uid/gid and start-time as key
 */
 int
 pdb_srchresidue(struct tstat *tstatp, struct pinfo **pinfopp)
 {
-	register struct pinfo	*pr, *prmin=NULL;
-	register long		btimediff;
+	register struct pinfo	*pr;
+	static const int	btimediff[] = {0, -1, 1};
+	int			i;
+
+	if (!prhashvalid)
+		pdb_buildresidue();
 
 	/*
-	** start at RESIDUE-list anchor and search through
-	** all remaining entries
+	** check if the start-time of the process is exactly
+	** the same ----> then we have a match;
+	** however sometimes the start-time may deviate a
+	** second although it IS the process we are looking
+	** for (depending on the rounding of the boot-time),
+	** so if we don't find the exact match, we will check
+	** if we find an almost-exact match
 	*/
-	pr = presidue.prnext;
-
-	while (pr != &presidue)	/* still entries left ? */
+	for (i=0; i < sizeof btimediff / sizeof btimediff[0]; i++)
 	{
-		/*
-		** check if this entry matches searched info
-		*/
-		if ( 	pr->tstat.gen.ruid   == tstatp->gen.ruid	&& 
-			pr->tstat.gen.rgid   == tstatp->gen.rgid	&& 
-			strcmp(pr->tstat.gen.name, tstatp->gen.name) == EQ  )
-		{
-			/*
-			** check if the start-time of the process is exactly
-			** the same ----> then we have a match;
-			** however sometimes the start-time may deviate a
-			** second although it IS the process we are looking
-			** for (depending on the rounding of the boot-time),
-			** so if we don't find the exact match, we will check
-			** later on if we found an almost-exact match
-			*/
-			btimediff = pr->tstat.gen.btime - tstatp->gen.btime;
+		time_t	btime = tstatp->gen.btime + btimediff[i];
 
-			if (btimediff == 0)	/* gotcha !! */
+		pr = prhash[pdb_residuehash(tstatp, btime)];
+
+		while (pr)
+		{
+			if ( 	pr->tstat.gen.btime  == btime			&&
+				pr->tstat.gen.ruid   == tstatp->gen.ruid	&&
+				pr->tstat.gen.rgid   == tstatp->gen.rgid	&&
+				strcmp(pr->tstat.gen.name, tstatp->gen.name) == EQ  )
 			{
 				*pinfopp = pr;
 				return 1;
 			}
 
-			if ((btimediff== -1 || btimediff== 1) && prmin== NULL)
-				prmin = pr;	/* remember this process */
+			pr = pr->prhnext;
 		}
+	}
+
+	return 0;	/* even not almost */
+}
 
-		pr = pr->prnext;
+/*
+** determine the residue hash bucket for the name, real uid/gid
+** (of the given process-info) and the given start-time
+*/
+static unsigned long
+pdb_residuehash(struct tstat *tstatp, time_t btime)
+{
+	register unsigned long	hash = 2166136261UL;	/* FNV-1a */
+	register unsigned char	*p;
+
+	for (p = (unsigned char *)tstatp->gen.name; *p; p++)
+		hash = (hash ^ *p) * 16777619UL;
+
+	hash = (hash ^ tstatp->gen.ruid) * 16777619UL;
+	hash = (hash ^ tstatp->gen.rgid) * 16777619UL;
+	hash = (hash ^ btime)            * 16777619UL;
+
+	return (hash ^ (hash >> 16)) & (nprhash-1);
+}
+
+/*
+** chain all entries of the RESIDUE-list in the residue hash list;
+** the number of buckets is at least twice the number of entries
+** (the bucket array is reused for subsequent samples)
+*/
+static void
+pdb_buildresidue(void)
+{
+	register struct pinfo	*pr;
+	unsigned long		nresidue = 0, nbuckets = NPRHASHMIN, h;
+
+	for (pr = presidue.prnext; pr != &presidue; pr = pr->prnext)
+		nresidue++;
+
+	while (nbuckets < nresidue * 2)
+		nbuckets *= 2;
+
+	if (nbuckets > nprhash)
+	{
+		free(prhash);
+
+		prhash = malloc(nbuckets * sizeof(struct pinfo *));
+
+		ptrverify(prhash, "Malloc failed for %lu residue buckets\n",
+								nbuckets);
+		nprhash = nbuckets;
 	}
 
-	/*
-	** nothing found that matched exactly;
-	** do we remember a process that matched almost exactly?
-	*/
-	if (prmin)
+	memset(prhash, 0, nprhash * sizeof(struct pinfo *));
+
+	for (pr = presidue.prnext; pr != &presidue; pr = pr->prnext)
 	{
-		*pinfopp = prmin;
-		return 1;
+		h = pdb_residuehash(&pr->tstat, pr->tstat.gen.btime);
+
+		pr->prhnext = prhash[h];
+		prhash[h]   = pr;
 	}
 
-	return 0;	/* even not almost */
+	prhashvalid = 1;
+}
+
+/*
+** remove an entry of the RESIDUE-list from the residue hash list
+** (before it is unchained from the RESIDUE-list or deleted)
+*/
+static void
+pdb_unhashresidue(struct pinfo *pp)
+{
+	register struct pinfo	**prp;
+
+	prp = &prhash[pdb_residuehash(&pp->tstat, pp->tstat.gen.btime)];
+
+	while (*prp)
+	{
+		if (*prp == pp)
+		{
+			*prp = pp->prhnext;
+			break;
+		}
+
+		prp = &(*prp)->prhnext;
+	}
+
+	pp->prhnext = NULL;
 }
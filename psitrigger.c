@@ -0,0 +1,248 @@
+/*
+** ATOP - System & Process Monitor
+**
+** The program 'atop' offers the possibility to view the activity of
+** the system on system-level as well as process-level.
+**
+** This source-file contains functions to register Pressure Stall
+** Information (PSI) triggers, system-wide (/proc/pressure) and/or per
+** cgroup (version 2). When the kernel notifies that a stall threshold
+** has been exceeded within the defined time window, an extra sample
+** is taken immediately (in the same way as with the signal SIGUSR1),
+** to capture the offending processes during the event instead of
+** averaging them away in the regular interval.
+** The file descriptors of the triggers are polled by a separate thread.
+** ==========================================================================
+** Date:        October 2026
+** --------------------------------------------------------------------------
+**
+** This program is free software; you can redistribute it and/or modify it
+** under the terms of the GNU General Public License as published by the
+** Free Software Foundation; either version 2, or (at your option) any
+** later version.
+**
+** This program is distributed in the hope that it will be useful, but
+** WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+** --------------------------------------------------------------------------
+*/
+#include <sys/types.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <pthread.h>
+
+#include "atop.h"
+
+#define	PSIMINWINDOW	500		// minimum window (millisec) of kernel
+#define	PSIMAXWINDOW	10000		// maximum window (millisec) of kernel
+
+/*
+** trigger definitions from atoprc
+*/
+struct psitrigger {
+	char	*path;		// pressure file
+	char	full;		// boolean: 'full' instead of 'some'
+	long	stallms;	// stall threshold in millisec
+	long	windowms;	// time window in millisec
+};
+
+static struct psitrigger	*psitrigs;
+static int			npsitrigs;
+
+static struct pollfd		*psifds;
+
+static void	*psiwatcher(void *);
+
+/*
+** register all defined triggers and start the thread
+** that polls the trigger file descriptors
+**
+** return value: number of registered triggers
+*/
+int
+psitrigger_start(void)
+{
+	pthread_t	tid;
+	sigset_t	allsigs, oldsigs;
+	char		trigger[64];
+	int		i, fd, nfds = 0;
+
+	if (npsitrigs == 0)
+		return 0;
+
+	psifds = calloc(npsitrigs, sizeof(struct pollfd));
+
+	ptrverify(psifds, "Malloc failed for %d PSI triggers\n", npsitrigs);
+
+	regainrootprivs();
+
+	for (i=0; i < npsitrigs; i++)
+	{
+		snprintf(trigger, sizeof trigger, "%s %ld %ld",
+				psitrigs[i].full ? "full" : "some",
+				psitrigs[i].stallms  * 1000,
+				psitrigs[i].windowms * 1000);
+
+		/*
+		** the trigger is active as long as the file is kept open
+		** (a cgroup without PSI support or no kernel support at all
+		** results in a failing open or write)
+		**
+		** notice that the terminating 0-byte has to be written as well
+		*/
+		if ( (fd = open(psitrigs[i].path, O_RDWR|O_NONBLOCK|O_CLOEXEC)) == -1)
+		{
+			fprintf(stderr, "PSI trigger %s: %s\n",
+					psitrigs[i].path, strerror(errno));
+			continue;
+		}
+
+		if ( write(fd, trigger, strlen(trigger)+1) == -1)
+		{
+			fprintf(stderr, "PSI trigger %s (%s): %s\n",
+					psitrigs[i].path, trigger, strerror(errno));
+			close(fd);
+			continue;
+		}
+
+		psifds[nfds].fd       = fd;
+		psifds[nfds].events   = POLLPRI;
+		nfds++;
+	}
+
+	if (! droprootprivs())
+		mcleanstop(42, "failed to drop root privs\n");
+
+	if (nfds == 0)
+	{
+		free(psifds);
+		psifds = NULL;
+		return 0;
+	}
+
+	/*
+	** the signal handlers are only executed by the main thread,
+	** so block all signals while creating the polling thread
+	*/
+	sigfillset(&allsigs);
+	pthread_sigmask(SIG_BLOCK, &allsigs, &oldsigs);
+
+	if ( pthread_create(&tid, NULL, psiwatcher, (void *)(long)nfds) == 0)
+		pthread_detach(tid);
+	else
+		nfds = 0;
+
+	pthread_sigmask(SIG_SETMASK, &oldsigs, NULL);
+
+	return nfds;
+}
+
+/*
+** thread that waits for trigger notifications and
+** forces an extra sample by sending SIGUSR1 to atop itself
+*/
+static void *
+psiwatcher(void *arg)
+{
+	int	nfds = (long)arg, nactive = nfds, i;
+
+	while (nactive > 0)
+	{
+		if ( poll(psifds, nfds, -1) == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		for (i=0; i < nfds; i++)
+		{
+			if (psifds[i].revents & (POLLERR|POLLNVAL))
+			{
+				// cgroup removed: stop polling this trigger
+				//
+				close(psifds[i].fd);
+				psifds[i].fd = -1;
+				nactive--;
+				continue;
+			}
+
+			if (psifds[i].revents & POLLPRI)
+				kill(getpid(), SIGUSR1);
+		}
+	}
+
+	return NULL;
+}
+
+/*
+** atoprc keyword 'psitrigger' (can be specified more than once):
+**
+**	psitrigger  <cpu|memory|io>  <some|full>  <stall ms>  <window ms>  [cgroup]
+**
+** without cgroup path the trigger is registered system-wide
+*/
+void
+do_psitrigger(char *tagname, char *tagvalue)
+{
+	struct psitrigger	*tp;
+	char			resource[16], type[16], cgpath[256] = "";
+	long			stallms, windowms;
+	int			pathlen;
+
+	if (sscanf(tagvalue, "%15s %15s %ld %ld %255s", resource, type,
+				&stallms, &windowms, cgpath) < 4)
+		mcleanstop(1, "atoprc: %s requires resource, some/full, "
+		              "stall (ms) and window (ms)\n", tagname);
+
+	if (strcmp(resource, "cpu")    != 0 &&
+	    strcmp(resource, "memory") != 0 &&
+	    strcmp(resource, "io")     != 0   )
+		mcleanstop(1, "atoprc: %s resource %s should be "
+		              "cpu, memory or io\n", tagname, resource);
+
+	if (strcmp(type, "some") != 0 && strcmp(type, "full") != 0)
+		mcleanstop(1, "atoprc: %s type %s should be some or full\n",
+				tagname, type);
+
+	if (windowms < PSIMINWINDOW || windowms > PSIMAXWINDOW)
+		mcleanstop(1, "atoprc: %s window should be between %d and %d ms\n",
+				tagname, PSIMINWINDOW, PSIMAXWINDOW);
+
+	if (stallms <= 0 || stallms > windowms)
+		mcleanstop(1, "atoprc: %s stall should be between 1 ms and "
+		              "the window size\n", tagname);
+
+	psitrigs = realloc(psitrigs, (npsitrigs+1) * sizeof *psitrigs);
+
+	ptrverify(psitrigs, "Malloc failed for %d PSI triggers\n", npsitrigs+1);
+
+	tp = psitrigs + npsitrigs++;
+
+	pathlen  = sizeof "/sys/fs/cgroup//.pressure" + strlen(cgpath) +
+		   strlen(resource);
+	tp->path = malloc(pathlen);
+
+	ptrverify(tp->path, "Malloc failed for PSI trigger path\n");
+
+	if (cgpath[0])
+		snprintf(tp->path, pathlen, "/sys/fs/cgroup/%s/%s.pressure",
+				cgpath[0] == '/' ? cgpath+1 : cgpath, resource);
+	else
+		snprintf(tp->path, pathlen, "/proc/pressure/%s", resource);
+
+	tp->full     = type[0] == 'f';
+	tp->stallms  = stallms;
+	tp->windowms = windowms;
+}
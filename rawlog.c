@@ -63,7 +63,7 @@
 #define	BASEPATH	"/var/log/atop"  
 
 static int	getrawrec  (int, struct rawrecord *, int, int);
-static int	getrawsstat(int, struct sstat *, int);
+static int	getrawsstat(int, struct sstat *, int, unsigned int);
 static int	getrawtstat(int, struct tstat *, int, int);
 static int	getrawcstat(int, struct cgchainer **,
 			unsigned long, unsigned long,
@@ -89,10 +89,10 @@ rawwrite(time_t curtime, int numsecs,
 	int			rv;
 	struct stat		filestat;
 
-	Byte			scompbuf[sizeof(struct sstat)], *pcompbuf,
+	Byte			*sorigbuf, *scompbuf, *pcompbuf,
 				*ccompbuf = NULL, *icompbuf = NULL;
 
-	unsigned long		soriglen = sizeof scompbuf, scomplen = compressBound(soriglen),
+	unsigned long		soriglen, scomplen,
 				poriglen, pcomplen,
 				coriglen, ccomplen,
 				ioriglen, icomplen;
@@ -115,12 +115,26 @@ rawwrite(time_t curtime, int numsecs,
 	(void) fstat(rawfd, &filestat);
 
 	/*
-	** compress system level metrics
+	** pack system level metrics (fixed part followed by the
+	** dynamically allocated arrays) and compress
 	*/
-	rv = compress(scompbuf, &scomplen, (Byte *)sstat, soriglen);
+	soriglen = sstat_packlen(sstat);
+	scomplen = compressBound(soriglen);
+
+	sorigbuf = malloc(soriglen);
+	scompbuf = malloc(scomplen);
+
+	ptrverify(sorigbuf, "Malloc failed for system pack buffer\n");
+	ptrverify(scompbuf, "Malloc failed for system compression buffer\n");
+
+	sstat_pack(sstat, sorigbuf);
+
+	rv = compress(scompbuf, &scomplen, sorigbuf, soriglen);
 
 	testcompval(rv, "compress system stats");
 
+	free(sorigbuf);
+
 	/*
 	** compress process level metrics
 	*/
@@ -203,6 +217,7 @@ rawwrite(time_t curtime, int numsecs,
 	rr.ncgroups	= ncgroups;
 	rr.ncgpids	= npids;
 	rr.scomplen	= scomplen;
+	rr.soriglen	= soriglen;
 	rr.pcomplen	= pcomplen;
 	rr.ccomplen	= ccomplen;
 	rr.coriglen	= coriglen;
@@ -271,6 +286,7 @@ rawwrite(time_t curtime, int numsecs,
 		   orawname);
 	}
 
+	free(scompbuf);
 	free(pcompbuf);
 
 	if (supportflags & CGROUPV2)
@@ -369,7 +385,8 @@ rawwopen()
 			{
 				if (	rr.curtime  < prevtime			||
 					rr.ccomplen > rr.coriglen		||
-					rr.scomplen > sizeof(struct sstat)	||
+					rr.soriglen < sizeof(struct sstat)	||
+					rr.scomplen > compressBound(rr.soriglen)||
 					rr.pcomplen > sizeof(struct tstat) * rr.ndeviat)
 				{
 					mcleanstop(7,
@@ -450,7 +467,7 @@ rawread(void)
 	char			*py;
 	struct rawheader	rh;
 	struct rawrecord	rr;
-	struct sstat		sstat;
+	static struct sstat	sstat;
 	struct cgchainer	*devchain = NULL;
 
 	struct stat		filestat;
@@ -780,7 +797,7 @@ rawread(void)
 			** allocate space, read compressed system-level
 			** metrics and decompress
 			*/
-			if ( !getrawsstat(rawfd, &sstat, rr.scomplen) )
+			if ( !getrawsstat(rawfd, &sstat, rr.scomplen, rr.soriglen) )
 				cleanstop(7);
 
 			/*
@@ -1048,28 +1065,43 @@ getrawrec(int rawfd, struct rawrecord *prr, int rrlen, int isregular)
 ** read the system-level statistics from the current offset
 */
 static int
-getrawsstat(int rawfd, struct sstat *sp, int complen)
+getrawsstat(int rawfd, struct sstat *sp, int complen, unsigned int origlen)
 {
-	Byte		*compbuf;
-	unsigned long	uncomplen = sizeof(struct sstat);
+	Byte		*compbuf, *origbuf;
+	unsigned long	uncomplen = origlen;
 	int		rv;
 
 	compbuf = malloc(complen);
+	origbuf = malloc(origlen);
 
 	ptrverify(compbuf, "Malloc failed for reading compressed sysstats\n");
+	ptrverify(origbuf, "Malloc failed for reading packed sysstats\n");
 
 	if ( readchunk(rawfd, compbuf, complen) < complen)
 	{
 		free(compbuf);
+		free(origbuf);
 		return 0;
 	}
 
-	rv = uncompress((Byte *)sp, &uncomplen, compbuf, complen);
+	rv = uncompress(origbuf, &uncomplen, compbuf, complen);
 
 	testcompval(rv, "uncompress");
 
 	free(compbuf);
 
+	/*
+	** unpack into the fixed part and the dynamic arrays
+	*/
+	if ( !sstat_unpack(sp, origbuf, uncomplen) )
+	{
+		fprintf(stderr, "inconsistent system-level stats in raw file\n");
+		free(origbuf);
+		return 0;
+	}
+
+	free(origbuf);
+
 	return 1;
 }
 
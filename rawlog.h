@@ -102,6 +102,7 @@ struct rawrecord {
 	unsigned int	coriglen;	/* length of original   cstats	*/
 	unsigned int	ncgpids;	/* number of cgroups pidlist 	*/
 	unsigned int	icomplen;	/* length of compressed pidlist */
-	unsigned int	ifuture;	/* future use                   */
+	unsigned int	soriglen;	/* length of original (packed)  */
+					/* sstat, see sstatmem.c        */
 };
 #endif
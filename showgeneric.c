@@ -245,6 +245,15 @@ generic_samp(time_t curtime, int nsecs,
 				displaymode = 'T';
 				break;
 
+			   case MPROCFLOW:	// switch to text mode: network flows
+				if (supportflags & NETATOPBPF && !rawreadflag)
+					setprocview(MPROCFLOW, MPERCNET, 0, -1);
+				else
+					setprocview(MPROCGEN, MPERCCPU, 0, -1);
+
+				displaymode = 'T';
+				break;
+
   			   default:
 				return retval;
 			}
@@ -267,6 +276,7 @@ text_samp(time_t curtime, int nsecs,
 	register int	i, curline, nproc;
 	int		statline, firstitem=0, slistsz, alistsz;
 	int		lastchar;
+	unsigned long	nfolded;
 	char		format1[16], format2[16], branchtime[32];
 	char		*statmsg = NULL, statbuf[80], buf[33];
 	short		sorthash = SORTHASH(procview), *lastsortp;
@@ -292,11 +302,14 @@ text_samp(time_t curtime, int nsecs,
 	** cgroups visualization is requested
 	**
 	** cgroupsort refers to a list with cgchainer pointers in
-	** sorted order according to the current showresource
+	** sorted order according to the current showresource;
+	** cstatsorted indicates the number of lines for which the
+	** sorted order is guaranteed (0 = entire list)
 	*/
 	struct cglinesel *cgroupsel   = 0;
 	struct cgchainer **cgroupsort = 0;
 	char             cstatdeviate = ' ', cstatdepth = ' ', cstatorder = ' ';
+	int              cstatsorted  = 0, cgsortlines;
 
 	/*
 	** curlist points to the active list of tstat pointers that
@@ -456,7 +469,18 @@ text_samp(time_t curtime, int nsecs,
 		*/
 		pricumproc(sstat, devtstat, nexit, noverflow, avgval, nsecs);
 
-		if (noverflow)
+		for (nfolded=0, i=0; noverflow && i < devtstat->nprocall; i++)
+			nfolded += devtstat->procall[i]->gen.naggr;
+
+		if (noverflow && nfolded)
+		{
+			snprintf(statbuf, sizeof statbuf, 
+			         "%lu terminated processes folded "
+			         "into summary lines", nfolded);
+
+			statmsg = statbuf;
+		}
+		else if (noverflow)
 		{
 			snprintf(statbuf, sizeof statbuf, 
 			         "Only %d terminated processes handled "
@@ -958,11 +982,22 @@ text_samp(time_t curtime, int nsecs,
 			**
 			** make new list with a selection (if needed) of cgroups
 			** merged with processes related to those cgroups
+			**
+			** on screen only the lines up to the current page
+			** have to be in sorted order, so the list is recreated
+			** when paging beyond that part
 			*/
+			if (screen)
+				cgsortlines = firstitem + LINES - curline;
+			else
+				cgsortlines = 0;	// entire list
+
 			if (cgroupsel == NULL           ||	// not created yet
 			    cstatdeviate != deviatonly  ||	// or not the right contents?
 			    cstatdepth   != cgroupdepth ||
-			    cstatorder   != procview.showresource)
+			    cstatorder   != procview.showresource ||
+			    (cstatsorted && (cgsortlines == 0 ||
+			                     cgsortlines > cstatsorted)))
 			{
 				struct tstat **tp;
 
@@ -974,7 +1009,8 @@ text_samp(time_t curtime, int nsecs,
 				*/
 				free(cgroupsort);
 
-				cgroupsort = cgsort(cgchainers, ncgroups, procview.showresource);
+				cgroupsort = cgsort(cgchainers, ncgroups,
+						procview.showresource, cgsortlines);
 
 				/*
 				** determine required list of processes (all or active)
@@ -1009,6 +1045,7 @@ text_samp(time_t curtime, int nsecs,
 				cstatdeviate = deviatonly;
 				cstatdepth   = cgroupdepth;
 				cstatorder   = procview.showresource;
+				cstatsorted  = cgsortlines;
 			}
 
 			/*
@@ -1377,6 +1414,33 @@ text_samp(time_t curtime, int nsecs,
 				firstitem = 0;
 				break;
 
+			   /*
+			   ** most active network flows per process
+			   */
+			   case MPROCFLOW:
+				if ( !(supportflags & NETATOPBPF) )
+				{
+					statmsg = "Ignored: 'netatop-bpf' not "
+					          "active, no -K specified or no root privs";
+					break;
+				}
+
+				/*
+				** flows are only kept for the last live
+				** sample (not stored in the raw file)
+				*/
+				if (rawreadflag)
+				{
+					statmsg = "Not possible in twin mode or "
+						  "when viewing raw file!";
+					beep();
+					break;
+				}
+
+				setprocview(MPROCFLOW, MPERCNET, 0, -1);
+				firstitem = 0;
+				break;
+
 			   /*
 			   ** cgroup v2 info per process
 			   */
@@ -3380,6 +3444,26 @@ generic_init(void)
 			setprocview(MPROCARG, MPERCCPU, 0, -1);
 			break;
 
+		   case MPROCFLOW:
+			if ( !(supportflags & NETATOPBPF) )
+			{
+				fprintf(stderr, "Ignored: 'netatop-bpf' not "
+					        "active, no -K specified or no root privs");
+				sleep(3);
+				break;
+			}
+
+			if (rawreadflag)
+			{
+				fprintf(stderr, "Ignored: network flows not "
+					        "available in twin mode or from raw file");
+				sleep(3);
+				break;
+			}
+
+			setprocview(MPROCFLOW, MPERCNET, 0, -1);
+			break;
+
 		   case MCGROUPS:
 			if ( !(supportflags & CGROUPV2) )
 			{
@@ -3832,6 +3916,7 @@ static struct helptext {
 	{"\t'%c'  - various info (ppid, user/group, date/time, status, "
 	 "exitcode)\n",	MPROCVAR, 'a'},
 	{"\t'%c'  - full command line per process\n",		MPROCARG, 'a'},
+	{"\t'%c'  - most active network flows per process\n",	MPROCFLOW, 'a'},
 	{"\t'%c'  - use own output line definition\n",		MPROCOWN, 'a'},
 	{"\n",							' ', 'a'},
 	{"Sort list of processes in order of:\n",		' ', 'a'},
@@ -4069,6 +4154,8 @@ generic_usage(void)
 	                 "date/time)\n", MPROCVAR);
 	printf("\t  -%c  show command line per process\n",
 			MPROCARG);
+	printf("\t  -%c  show most active network flows per process\n",
+			MPROCFLOW);
 	printf("\t  -%c  show own defined process-info\n",
 			MPROCOWN);
 	printf("\t  -%c  show cumulated process-info per user\n",
@@ -4376,6 +4463,10 @@ do_flags(char *name, char *val)
 			setprocview(MPROCARG, 0, 0, 0);
 			break;
 
+		   case MPROCFLOW:
+			setprocview(MPROCFLOW, MPERCNET, 0, -1);
+			break;
+
 		   case MPROCOWN:
 			setprocview(MPROCOWN, 0, 0, 0);
 			break;
@@ -180,6 +180,7 @@ struct sselection {
 #define	MPROCSCH	's'
 #define	MPROCVAR	'v'
 #define	MPROCARG	'c'
+#define	MPROCFLOW	'A'
 #define	MCGROUPS	'G'
 #define MPROCOWN	'o'
 
@@ -103,6 +103,9 @@ sys_printdef *cpusyspdefs[] = {
 	&syspdef_BLANKBOX,
 	&syspdef_CPUIPC,
 	&syspdef_CPUCYCLE,
+	&syspdef_CPUCMISS,
+	&syspdef_CPUBMISS,
+	&syspdef_CPUSTALL,
 	&syspdef_CPUFREQ,
 	&syspdef_CPUSCALE,
 	&syspdef_CPUSTEAL,
@@ -119,6 +122,9 @@ sys_printdef *cpisyspdefs[] = {
 	&syspdef_BLANKBOX,
 	&syspdef_CPUIIPC,
 	&syspdef_CPUICYCLE,
+	&syspdef_CPUICMISS,
+	&syspdef_CPUIBMISS,
+	&syspdef_CPUISTALL,
 	&syspdef_CPUIFREQ,
 	&syspdef_CPUISCALE,
 	&syspdef_CPUISTEAL,
@@ -403,6 +409,9 @@ detail_printdef *alldetaildefs[]=
 	&procprt_WCHAN,
 	&procprt_NVCSW,
 	&procprt_NIVCSW,
+	&procprt_CYCLES,
+	&procprt_IPC,
+	&procprt_LLCMISS,
 	&procprt_VGROW,
 	&procprt_RGROW,
 	&procprt_MINFLT,
@@ -465,6 +474,7 @@ detail_printdef *alldetaildefs[]=
 	&procprt_SNET,
 	&procprt_BANDWI,
 	&procprt_BANDWO,
+	&procprt_NETFLOWS,
 	&procprt_GPUPROCTYPE,
 	&procprt_GPULIST,
 	&procprt_GPUMEMNOW,
@@ -486,6 +496,20 @@ detail_printdef *alldetaildefs[]=
 	&cgroupprt_CGRDISKIO,
 	&cgroupprt_CGRDSKPSI,
 	&cgroupprt_CGRDSKWGT,
+	&cgroupprt_CGRMAJFLT,
+	&cgroupprt_CGRWSRFLT,
+	&cgroupprt_CGRACTFIL,
+	&cgroupprt_CGRINAFIL,
+	&cgroupprt_CGRSLAB,
+	&cgroupprt_CGRSOCK,
+	&cgroupprt_CGRTOPDSK,
+	&cgroupprt_CGRTHROTL,
+	&cgroupprt_CGRTHRTIM,
+	&cgroupprt_CGRNTASKS,
+	&cgroupprt_CGRTSKMAX,
+	&cgroupprt_CGRMEMHIGH,
+	&cgroupprt_CGRMEMMAXE,
+	&cgroupprt_CGROOMKIL,
 	&cgroupprt_CGRPID,
 	&cgroupprt_CGRCMD,
         NULL
@@ -538,6 +562,7 @@ detail_printpair netprocs[MAXITEMS];
 detail_printpair gpuprocs[MAXITEMS];
 detail_printpair varprocs[MAXITEMS];
 detail_printpair cmdprocs[MAXITEMS];
+detail_printpair flowprocs[MAXITEMS];
 detail_printpair ownprocs[MAXITEMS];
 detail_printpair totusers[MAXITEMS];
 detail_printpair totprocs[MAXITEMS];
@@ -954,6 +979,9 @@ pricumproc(struct sstat *sstat, struct devtstat *devtstat,
 	                "BLANKBOX:0 "
                         "CPUIPC:5 "
                         "CPUCYCLE:4 "
+                        "CPUCMISS:1 "
+                        "CPUBMISS:1 "
+                        "CPUSTALL:1 "
                         "CPUFREQ:4 "
                         "CPUSCALE:4 ",
 			cpusyspdefs, "builtin allcpuline",
@@ -974,6 +1002,9 @@ pricumproc(struct sstat *sstat, struct devtstat *devtstat,
 	                "BLANKBOX:0 "
                         "CPUIIPC:5 "
                         "CPUICYCLE:4 "
+                        "CPUICMISS:1 "
+                        "CPUIBMISS:1 "
+                        "CPUISTALL:1 "
                         "CPUIFREQ:4 "
                         "CPUISCALE:4 ",
 			cpisyspdefs, "builtin indivcpuline",
@@ -1372,7 +1403,8 @@ prihead(int curlist, int totlist, struct procview *pv, count_t numcpu)
                         "PID:10 TID:6 CID:4 VPID:3 CTID:3 TRUN:7 TSLPI:7 "
 			"TSLPU:7 TIDLE:7 POLI:8 NICE:9 PRI:5 RTPR:9 CPUNR:8 "
 			"ST:8 EXC:8 S:8 RDELAY:8 BDELAY:7 WCHAN:5 "
-			"NVCSW:7 NIVCSW:7 RESOURCE:10 CMD:10",
+			"NVCSW:7 NIVCSW:7 IPC:2 CYCLES:1 LLCMISS:1 "
+			"RESOURCE:10 CMD:10",
                         "built-in schedprocs");
 
                 make_detail_prints(dskprocs, MAXITEMS, 
@@ -1406,6 +1438,11 @@ prihead(int curlist, int totlist, struct procview *pv, count_t numcpu)
                         "PID:10 TID:4 S:8 RESOURCE:10 COMMAND-LINE:10", 
                         "built-in cmdprocs");
 
+                make_detail_prints(flowprocs, MAXITEMS,
+                        "PID:10 TID:4 BANDWI:8 BANDWO:8 RESOURCE:10 "
+			"CMD:9 NETFLOWS:10", 
+                        "built-in flowprocs");
+
                 make_detail_prints(totusers, MAXITEMS, 
                         "NPROCS:10 SYSCPU:9 USRCPU:9 VSIZE:6 "
                         "RSIZE:8 PSIZE:8 LOCKSZ:3 SWAPSZ:5 RDDSK:7 WRDSK:7 "
@@ -1430,7 +1467,11 @@ prihead(int curlist, int totlist, struct procview *pv, count_t numcpu)
                         "CGRPATH:10 CGRNPROCS:9 CGRNPROCSB:8 "
 			"CGRCPUBUSY:7 CGRCPUPSI:4 CGRCPUMAX:3 CGRCPUWGT:2 "
 			"CGRMEMORY:7 CGRMEMPSI:4 CGRMEMMAX:3 CGRSWPMAX:1 "
-			"CGRDISKIO:6 CGRDSKPSI:4 CGRDSKWGT:2 CGRPID:6 CGRCMD:5", 
+			"CGRDISKIO:6 CGRDSKPSI:4 CGRDSKWGT:2 CGRMAJFLT:2 CGRWSRFLT:1 "
+			"CGRACTFIL:1 CGRINAFIL:1 CGRSLAB:1 CGRSOCK:1 CGRTOPDSK:1 "
+			"CGRTHROTL:2 CGRTHRTIM:1 CGRNTASKS:1 CGRTSKMAX:1 "
+			"CGRMEMHIGH:1 CGRMEMMAXE:1 CGROOMKIL:2 "
+			"CGRPID:6 CGRCMD:5", 
                         "built-in gencgroups");
         }
 
@@ -1444,7 +1485,8 @@ prihead(int curlist, int totlist, struct procview *pv, count_t numcpu)
 		prev_supportflags = supportflags;
 		prev_threadview   = threadview;
 
-		if (pv->showtype == MPROCNET && !(supportflags&NETATOP||supportflags&NETATOPBPF) )
+		if ((pv->showtype == MPROCNET  && !(supportflags&NETATOP||supportflags&NETATOPBPF)) ||
+		    (pv->showtype == MPROCFLOW && !(supportflags&NETATOPBPF))                       )
 		{
 			pv->showtype     = MPROCGEN;
 			pv->showresource = MPERCCPU;
@@ -1485,6 +1527,10 @@ prihead(int curlist, int totlist, struct procview *pv, count_t numcpu)
                 showprochead(cmdprocs, curlist, totlist, pv);
                 break;
 
+           case MPROCFLOW:
+                showprochead(flowprocs, curlist, totlist, pv);
+                break;
+
            case MPROCOWN:
                 showprochead(ownprocs, curlist, totlist, pv);
                 break;
@@ -1762,6 +1808,10 @@ priproc(struct tstat **proclist, int firstproc, int lastproc, int curline,
                         showprocline(cmdprocs, curstat, perc, nsecs, avgval);
                         break;
 
+                   case MPROCFLOW:
+                        showprocline(flowprocs, curstat, perc, nsecs, avgval);
+                        break;
+
                    case MPROCOWN:
                         showprocline(ownprocs, curstat, perc, nsecs, avgval);
                         break;
@@ -2520,6 +2570,10 @@ viewhascolumn(unsigned char viewtype, unsigned char viewsort)
                 viewline = cmdprocs;
                 break;
 
+           case MPROCFLOW:
+                viewline = flowprocs;
+                break;
+
            case MPROCOWN:
                 viewline = ownprocs;
                 break;
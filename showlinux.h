@@ -216,6 +216,12 @@ extern sys_printdef syspdef_CPUIPC;
 extern sys_printdef syspdef_CPUIIPC;
 extern sys_printdef syspdef_CPUCYCLE;
 extern sys_printdef syspdef_CPUICYCLE;
+extern sys_printdef syspdef_CPUCMISS;
+extern sys_printdef syspdef_CPUICMISS;
+extern sys_printdef syspdef_CPUBMISS;
+extern sys_printdef syspdef_CPUIBMISS;
+extern sys_printdef syspdef_CPUSTALL;
+extern sys_printdef syspdef_CPUISTALL;
 extern sys_printdef syspdef_CPLAVG1;
 extern sys_printdef syspdef_CPLAVG5;
 extern sys_printdef syspdef_CPLAVG15;
@@ -456,6 +462,7 @@ extern detail_printdef procprt_ST;
 extern detail_printdef procprt_EXC;
 extern detail_printdef procprt_S;
 extern detail_printdef procprt_COMMAND_LINE;
+extern detail_printdef procprt_NETFLOWS;
 extern detail_printdef procprt_NPROCS;
 extern detail_printdef procprt_RDDSK;
 extern detail_printdef procprt_WRDSK;
@@ -485,6 +492,9 @@ extern detail_printdef procprt_BLKDELAY;
 extern detail_printdef procprt_WCHAN;
 extern detail_printdef procprt_NVCSW;
 extern detail_printdef procprt_NIVCSW;
+extern detail_printdef procprt_CYCLES;
+extern detail_printdef procprt_IPC;
+extern detail_printdef procprt_LLCMISS;
 
 extern detail_printdef cgroupprt_CGROUP_PATH;
 extern detail_printdef cgroupprt_CGRNPROCS;
@@ -500,6 +510,20 @@ extern detail_printdef cgroupprt_CGRSWPMAX;
 extern detail_printdef cgroupprt_CGRDISKIO;
 extern detail_printdef cgroupprt_CGRDSKPSI;
 extern detail_printdef cgroupprt_CGRDSKWGT;
+extern detail_printdef cgroupprt_CGRMAJFLT;
+extern detail_printdef cgroupprt_CGRWSRFLT;
+extern detail_printdef cgroupprt_CGRACTFIL;
+extern detail_printdef cgroupprt_CGRINAFIL;
+extern detail_printdef cgroupprt_CGRSLAB;
+extern detail_printdef cgroupprt_CGRSOCK;
+extern detail_printdef cgroupprt_CGRTOPDSK;
+extern detail_printdef cgroupprt_CGRTHROTL;
+extern detail_printdef cgroupprt_CGRTHRTIM;
+extern detail_printdef cgroupprt_CGRNTASKS;
+extern detail_printdef cgroupprt_CGRTSKMAX;
+extern detail_printdef cgroupprt_CGRMEMHIGH;
+extern detail_printdef cgroupprt_CGRMEMMAXE;
+extern detail_printdef cgroupprt_CGROOMKIL;
 extern detail_printdef cgroupprt_CGRPID;
 extern detail_printdef cgroupprt_CGRCMD;
 
@@ -57,6 +57,7 @@
 #include <curses.h>
 #include <regex.h>
 #include <limits.h>
+#include <netinet/in.h>
 
 #include "atop.h"
 #include "photoproc.h"
@@ -64,6 +65,7 @@
 #include "cgroups.h"
 #include "showgeneric.h"
 #include "showlinux.h"
+#include "netatop.h"
 
 static void	format_bandw(char *, int, count_t);
 static void	gettotwidth(detail_printpair *, int *, int *, int *);
@@ -159,6 +161,7 @@ char *procprt_EXC_e(struct tstat *, int, int);
 char *procprt_S_a(struct tstat *, int, int);
 char *procprt_S_e(struct tstat *, int, int);
 char *procprt_COMMAND_LINE_ae(struct tstat *, int, int);
+char *procprt_NETFLOWS_ae(struct tstat *, int, int);
 char *procprt_NPROCS_ae(struct tstat *, int, int);
 char *procprt_RDDSK_a(struct tstat *, int, int);
 char *procprt_RDDSK_e(struct tstat *, int, int);
@@ -187,6 +190,12 @@ char *procprt_NVCSW_a(struct tstat *, int, int);
 char *procprt_NVCSW_e(struct tstat *, int, int);
 char *procprt_NIVCSW_a(struct tstat *, int, int);
 char *procprt_NIVCSW_e(struct tstat *, int, int);
+char *procprt_CYCLES_a(struct tstat *, int, int);
+char *procprt_CYCLES_e(struct tstat *, int, int);
+char *procprt_IPC_a(struct tstat *, int, int);
+char *procprt_IPC_e(struct tstat *, int, int);
+char *procprt_LLCMISS_a(struct tstat *, int, int);
+char *procprt_LLCMISS_e(struct tstat *, int, int);
 char *procprt_RESOURCE_ae(struct tstat *, int, int);
 
 char *cgroup_CGROUP_PATH(struct cgchainer *, struct tstat *,
@@ -217,6 +226,34 @@ char *cgroup_CGRDSKPSI(struct cgchainer *, struct tstat *,
 				int, int, count_t, int, int *);
 char *cgroup_CGRDSKWGT(struct cgchainer *, struct tstat *,
 				int, int, count_t, int, int *);
+char *cgroup_CGRMAJFLT(struct cgchainer *, struct tstat *,
+				int, int, count_t, int, int *);
+char *cgroup_CGRWSRFLT(struct cgchainer *, struct tstat *,
+				int, int, count_t, int, int *);
+char *cgroup_CGRACTFIL(struct cgchainer *, struct tstat *,
+				int, int, count_t, int, int *);
+char *cgroup_CGRINAFIL(struct cgchainer *, struct tstat *,
+				int, int, count_t, int, int *);
+char *cgroup_CGRSLAB(struct cgchainer *, struct tstat *,
+				int, int, count_t, int, int *);
+char *cgroup_CGRSOCK(struct cgchainer *, struct tstat *,
+				int, int, count_t, int, int *);
+char *cgroup_CGRTOPDSK(struct cgchainer *, struct tstat *,
+				int, int, count_t, int, int *);
+char *cgroup_CGRTHROTL(struct cgchainer *, struct tstat *,
+				int, int, count_t, int, int *);
+char *cgroup_CGRTHRTIM(struct cgchainer *, struct tstat *,
+				int, int, count_t, int, int *);
+char *cgroup_CGRNTASKS(struct cgchainer *, struct tstat *,
+				int, int, count_t, int, int *);
+char *cgroup_CGRTSKMAX(struct cgchainer *, struct tstat *,
+				int, int, count_t, int, int *);
+char *cgroup_CGRMEMHIGH(struct cgchainer *, struct tstat *,
+				int, int, count_t, int, int *);
+char *cgroup_CGRMEMMAXE(struct cgchainer *, struct tstat *,
+				int, int, count_t, int, int *);
+char *cgroup_CGROOMKIL(struct cgchainer *, struct tstat *,
+				int, int, count_t, int, int *);
 char *cgroup_CGRPID(struct cgchainer *, struct tstat *,
 				int, int, count_t, int, int *);
 char *cgroup_CGRCMD(struct cgchainer *, struct tstat *,
@@ -2838,6 +2875,90 @@ detail_printdef procprt_COMMAND_LINE =
     {0, "COMMAND-LINE (horizontal scroll with <- and -> keys)", "COMMAND-LINE", 
         .ac.doactiveconverts = procprt_COMMAND_LINE_ae, procprt_COMMAND_LINE_ae, compcmdline, 1, 0, 1};
 /***************************************************************/
+int compnetflows(const void *, const void *, void *);
+
+#define	MAXFLOWLINE	2048
+
+char *
+procprt_NETFLOWS_ae(struct tstat *curstat, int avgval, int nsecs)
+{
+        extern detail_printdef procprt_NETFLOWS;
+        extern int	startoffset;	// influenced by -> and <- keys
+
+        static char	buf[MAXFLOWLINE];
+
+	char			line[MAXFLOWLINE], raddr[64], snd[16], rcv[16];
+	char			*ps, *pr;
+	struct netperflow	*fp;
+	int			nflows = 0, f, len = 0;
+
+	if (curstat->gen.isproc)
+		nflows = netatop_bpf_findflows(curstat->gen.tgid, &fp);
+
+	line[0] = '\0';
+
+	/*
+	** per flow: protocol, remote address and port, local port
+	** and the number of sent/received bytes
+	*/
+	for (f=0; f < nflows && len < sizeof line; f++, fp++)
+	{
+		ps = val2memstr(fp->sndbytes, snd, BFORMAT, avgval, nsecs);
+		pr = val2memstr(fp->rcvbytes, rcv, BFORMAT, avgval, nsecs);
+
+		while (*ps == ' ')
+			ps++;
+
+		while (*pr == ' ')
+			pr++;
+
+		len += snprintf(line+len, sizeof line - len,
+			fp->family == AF_INET6 ? "%s%s [%s]:%d (:%d) %s/%s" :
+			                         "%s%s %s:%d (:%d) %s/%s",
+			f ? "  " : "",
+			fp->proto == IPPROTO_UDP ? "udp" : "tcp",
+			netatop_bpf_flowaddr(fp, raddr, sizeof raddr),
+			fp->rport, fp->lport, ps, pr);
+	}
+
+        int 	curwidth   = procprt_NETFLOWS.width < MAXFLOWLINE ?
+				procprt_NETFLOWS.width : MAXFLOWLINE-1;
+
+        int 	linelen    = strlen(line);
+        int 	curoffset  = startoffset <= linelen ? startoffset : linelen;
+
+        if (screen) 
+                snprintf(buf, sizeof buf, "%-*.*s", curwidth, curwidth, line+curoffset);
+        else
+                snprintf(buf, sizeof buf, "%s", line+curoffset);
+
+        return buf;
+}
+
+int
+compnetflows(const void *a, const void *b, void *dir)
+{
+	struct tstat		*ta = *(struct tstat **)a;
+	struct tstat		*tb = *(struct tstat **)b;
+	struct netperflow	*fp;
+	count_t			aval = 0, bval = 0;
+	int			n;
+
+	if (ta->gen.isproc)
+		for (n = netatop_bpf_findflows(ta->gen.tgid, &fp); n > 0; n--, fp++)
+			aval += fp->sndbytes + fp->rcvbytes;
+
+	if (tb->gen.isproc)
+		for (n = netatop_bpf_findflows(tb->gen.tgid, &fp); n > 0; n--, fp++)
+			bval += fp->sndbytes + fp->rcvbytes;
+
+	return (aval < bval ? -1 : aval > bval) * *(int *)dir;
+}
+
+detail_printdef procprt_NETFLOWS = 
+    {0, "NETWORK FLOWS (horizontal scroll with <- and -> keys)", "NETFLOWS", 
+        .ac.doactiveconverts = procprt_NETFLOWS_ae, procprt_NETFLOWS_ae, compnetflows, -1, 0, 1};
+/***************************************************************/
 int compnprocs(const void *, const void *, void *);
 
 char *
@@ -4139,6 +4260,109 @@ compnivcsw(const void *a, const void *b, void *dir)
 
 detail_printdef procprt_NIVCSW =
    {0, "NIVCSW", "NIVCSW", .ac.doactiveconverts = procprt_NIVCSW_a, procprt_NIVCSW_e, compnivcsw, -1, 6, 0};
+/***************************************************************/
+int compcycles(const void *, const void *, void *);
+
+char *
+procprt_CYCLES_a(struct tstat *curstat, int avgval, int nsecs)
+{
+	static char buf[64];
+
+	if (curstat->cpu.cycle == 0)
+		return "     -";
+
+        val2valstr(curstat->cpu.cycle, buf, 6, avgval, nsecs);
+	return buf;
+}
+
+char *
+procprt_CYCLES_e(struct tstat *curstat, int avgval, int nsecs)
+{
+	return "     -";
+}
+
+int
+compcycles(const void *a, const void *b, void *dir)
+{
+        register count_t aval = (*(struct tstat **)a)->cpu.cycle;
+        register count_t bval = (*(struct tstat **)b)->cpu.cycle;
+
+	return (aval < bval ? -1 : aval > bval) * *(int *)dir;
+}
+
+detail_printdef procprt_CYCLES =
+   {0, "CYCLES", "CYCLES", .ac.doactiveconverts = procprt_CYCLES_a, procprt_CYCLES_e, compcycles, -1, 6, 0};
+/***************************************************************/
+int compipc(const void *, const void *, void *);
+
+char *
+procprt_IPC_a(struct tstat *curstat, int avgval, int nsecs)
+{
+	static char buf[64];
+
+	if (curstat->cpu.cycle == 0)
+		return "    -";
+
+	snprintf(buf, sizeof buf, "%5.2f",
+		(float)curstat->cpu.instr / curstat->cpu.cycle);
+	return buf;
+}
+
+char *
+procprt_IPC_e(struct tstat *curstat, int avgval, int nsecs)
+{
+	return "    -";
+}
+
+int
+compipc(const void *a, const void *b, void *dir)
+{
+        register struct tstat *ta = *(struct tstat **)a;
+        register struct tstat *tb = *(struct tstat **)b;
+	double aval = ta->cpu.cycle ? (double)ta->cpu.instr / ta->cpu.cycle : 0;
+	double bval = tb->cpu.cycle ? (double)tb->cpu.instr / tb->cpu.cycle : 0;
+
+	if (aval < bval)
+		return -1 * *(int *)dir;
+	if (aval > bval)
+		return  1 * *(int *)dir;
+	return 0;
+}
+
+detail_printdef procprt_IPC =
+   {0, "  IPC", "IPC", .ac.doactiveconverts = procprt_IPC_a, procprt_IPC_e, compipc, -1, 5, 0};
+/***************************************************************/
+int compllcmiss(const void *, const void *, void *);
+
+char *
+procprt_LLCMISS_a(struct tstat *curstat, int avgval, int nsecs)
+{
+	static char buf[64];
+
+	if (curstat->cpu.cycle == 0)
+		return "     -";
+
+        val2valstr(curstat->cpu.llcmiss, buf, 6, avgval, nsecs);
+	return buf;
+}
+
+char *
+procprt_LLCMISS_e(struct tstat *curstat, int avgval, int nsecs)
+{
+	return "     -";
+}
+
+int
+compllcmiss(const void *a, const void *b, void *dir)
+{
+        register count_t aval = (*(struct tstat **)a)->cpu.llcmiss;
+        register count_t bval = (*(struct tstat **)b)->cpu.llcmiss;
+
+	return (aval < bval ? -1 : aval > bval) * *(int *)dir;
+}
+
+detail_printdef procprt_LLCMISS =
+   {0, "LLCMIS", "LLCMISS", .ac.doactiveconverts = procprt_LLCMISS_a, procprt_LLCMISS_e, compllcmiss, -1, 6, 0};
 
 /***************************************************************/
 /* CGROUP LEVEL FORMATTING                                     */
@@ -4806,6 +5030,298 @@ detail_printdef cgroupprt_CGRDSKWGT =
    {0, "IOWGT", "CGRDSKWGT", .ac.doactiveconvertc = cgroup_CGRDSKWGT, NULL, NULL, 0, 5, 0};
 /***************************************************************/
 char *
+cgroup_CGRMAJFLT(struct cgchainer *cgchain, struct tstat *tstat,
+		int avgval, int nsecs, count_t cputicks, int nrcpu, int *color)
+{
+        static char	buf[16];
+
+	if (!tstat)	// show cgroup info?
+	{
+		if (cgchain->cstat->mem.pgmajflt == -1)		// not defined?
+			return "     -";
+
+        	val2valstr(cgchain->cstat->mem.pgmajflt, buf, 6, avgval, nsecs);
+	}
+	else		// show process info
+	{
+        	val2valstr(tstat->mem.majflt, buf, 6, avgval, nsecs);
+	}
+
+       	return buf;
+}
+
+detail_printdef cgroupprt_CGRMAJFLT =
+   {0, "MAJFLT", "CGRMAJFLT", .ac.doactiveconvertc = cgroup_CGRMAJFLT, NULL, NULL, 0, 6, 0};
+/***************************************************************/
+char *
+cgroup_CGRWSRFLT(struct cgchainer *cgchain, struct tstat *tstat,
+		int avgval, int nsecs, count_t cputicks, int nrcpu, int *color)
+{
+        static char	buf[16];
+
+	if (tstat)	// process info?
+		return "      ";
+
+	// cgroup info
+	if (cgchain->cstat->mem.wsrefault == -1)	// not defined?
+		return "     -";
+
+       	val2valstr(cgchain->cstat->mem.wsrefault, buf, 6, avgval, nsecs);
+       	return buf;
+}
+
+detail_printdef cgroupprt_CGRWSRFLT =
+   {0, "WSRFLT", "CGRWSRFLT", .ac.doactiveconvertc = cgroup_CGRWSRFLT, NULL, NULL, 0, 6, 0};
+/***************************************************************/
+static char *
+cgroup_memval(count_t pages)
+{
+        static char	buf[16];
+
+	if (pages == -1)	// not defined?
+		return "     -";
+
+       	val2memstr(pages * pagesize, buf, BFORMAT, 0, 0);
+       	return buf;
+}
+
+char *
+cgroup_CGRACTFIL(struct cgchainer *cgchain, struct tstat *tstat,
+		int avgval, int nsecs, count_t cputicks, int nrcpu, int *color)
+{
+	if (tstat)	// process info?
+		return "      ";
+
+	return cgroup_memval(cgchain->cstat->mem.actfile);
+}
+
+detail_printdef cgroupprt_CGRACTFIL =
+   {0, "ACTFIL", "CGRACTFIL", .ac.doactiveconvertc = cgroup_CGRACTFIL, NULL, NULL, 0, 6, 0};
+/***************************************************************/
+char *
+cgroup_CGRINAFIL(struct cgchainer *cgchain, struct tstat *tstat,
+		int avgval, int nsecs, count_t cputicks, int nrcpu, int *color)
+{
+	if (tstat)	// process info?
+		return "      ";
+
+	return cgroup_memval(cgchain->cstat->mem.inactfile);
+}
+
+detail_printdef cgroupprt_CGRINAFIL =
+   {0, "INAFIL", "CGRINAFIL", .ac.doactiveconvertc = cgroup_CGRINAFIL, NULL, NULL, 0, 6, 0};
+/***************************************************************/
+char *
+cgroup_CGRSLAB(struct cgchainer *cgchain, struct tstat *tstat,
+		int avgval, int nsecs, count_t cputicks, int nrcpu, int *color)
+{
+	if (tstat)	// process info?
+		return "      ";
+
+	return cgroup_memval(cgchain->cstat->mem.slab);
+}
+
+detail_printdef cgroupprt_CGRSLAB =
+   {0, "  SLAB", "CGRSLAB", .ac.doactiveconvertc = cgroup_CGRSLAB, NULL, NULL, 0, 6, 0};
+/***************************************************************/
+char *
+cgroup_CGRSOCK(struct cgchainer *cgchain, struct tstat *tstat,
+		int avgval, int nsecs, count_t cputicks, int nrcpu, int *color)
+{
+	if (tstat)	// process info?
+		return "      ";
+
+	return cgroup_memval(cgchain->cstat->mem.sock);
+}
+
+detail_printdef cgroupprt_CGRSOCK =
+   {0, "  SOCK", "CGRSOCK", .ac.doactiveconvertc = cgroup_CGRSOCK, NULL, NULL, 0, 6, 0};
+/***************************************************************/
+char *
+cgroup_CGRTOPDSK(struct cgchainer *cgchain, struct tstat *tstat,
+		int avgval, int nsecs, count_t cputicks, int nrcpu, int *color)
+{
+        static char	buf[16];
+	char		dev[24];
+	struct cgperdsk	*pdp, *top = NULL;
+	int		i;
+
+	if (tstat)	// process info?
+		return "      ";
+
+	// cgroup info: physical disk with most data transferred
+	//
+	for (i=0, pdp=cgchain->cstat->dsk.disks;
+	     i < cgchain->cstat->dsk.ndisks; i++, pdp++)
+	{
+		if (pdp->rbytes + pdp->wbytes == 0)
+			continue;
+
+		if (!top || pdp->rbytes + pdp->wbytes > top->rbytes + top->wbytes)
+			top = pdp;
+	}
+
+	if (!top)
+		return "     -";
+
+	snprintf(dev, sizeof dev, "%d:%d", top->major, top->minor);
+	snprintf(buf, sizeof buf, "%6.6s", dev);
+
+       	return buf;
+}
+
+detail_printdef cgroupprt_CGRTOPDSK =
+   {0, "TOPDSK", "CGRTOPDSK", .ac.doactiveconvertc = cgroup_CGRTOPDSK, NULL, NULL, 0, 6, 0};
+/***************************************************************/
+char *
+cgroup_CGRTHROTL(struct cgchainer *cgchain, struct tstat *tstat,
+		int avgval, int nsecs, count_t cputicks, int nrcpu, int *color)
+{
+        static char	buf[16];
+
+	if (tstat)	// process info?
+		return "      ";
+
+	// cgroup info
+	if (cgchain->cstat->cpu.nrthrottled == -1)	// not defined?
+		return "     -";
+
+	if (cgchain->cstat->cpu.nrthrottled > 0)
+		*color = FGCOLORALMOST;
+
+       	val2valstr(cgchain->cstat->cpu.nrthrottled, buf, 6, avgval, nsecs);
+       	return buf;
+}
+
+detail_printdef cgroupprt_CGRTHROTL =
+   {0, "THROTL", "CGRTHROTL", .ac.doactiveconvertc = cgroup_CGRTHROTL, NULL, NULL, 0, 6, 0};
+/***************************************************************/
+char *
+cgroup_CGRTHRTIM(struct cgchainer *cgchain, struct tstat *tstat,
+		int avgval, int nsecs, count_t cputicks, int nrcpu, int *color)
+{
+        static char	buf[16];
+
+	if (tstat)	// process info?
+		return "      ";
+
+	// cgroup info
+	if (cgchain->cstat->cpu.thrtime == -1)		// not defined?
+		return "     -";
+
+       	val2cpustr(cgchain->cstat->cpu.thrtime/1000, buf);
+       	return buf;
+}
+
+detail_printdef cgroupprt_CGRTHRTIM =
+   {0, "THRTIM", "CGRTHRTIM", .ac.doactiveconvertc = cgroup_CGRTHRTIM, NULL, NULL, 0, 6, 0};
+/***************************************************************/
+char *
+cgroup_CGRNTASKS(struct cgchainer *cgchain, struct tstat *tstat,
+		int avgval, int nsecs, count_t cputicks, int nrcpu, int *color)
+{
+        static char	buf[16];
+	int		maxtasks = cgchain->cstat->conf.pidsmax;
+
+	if (tstat)	// process info?
+		return "      ";
+
+	// cgroup info
+	if (cgchain->cstat->gen.nrtasks == -1)		// not defined?
+		return "     -";
+
+	// color when (almost) limited by pids.max
+	//
+	if (maxtasks > 0 && cgchain->cstat->gen.nrtasks >= maxtasks * 0.9)
+		*color = FGCOLORCRIT;
+
+       	val2valstr(cgchain->cstat->gen.nrtasks, buf, 6, 0, 0);
+       	return buf;
+}
+
+detail_printdef cgroupprt_CGRNTASKS =
+   {0, "NTASKS", "CGRNTASKS", .ac.doactiveconvertc = cgroup_CGRNTASKS, NULL, NULL, 0, 6, 0};
+/***************************************************************/
+char *
+cgroup_CGRTSKMAX(struct cgchainer *cgchain, struct tstat *tstat,
+		int avgval, int nsecs, count_t cputicks, int nrcpu, int *color)
+{
+        static char	buf[16];
+
+	if (tstat)	// process info?
+		return "      ";
+
+	// cgroup info
+	switch (cgchain->cstat->conf.pidsmax)
+	{
+	   case -1:
+        	return "   max";
+	   case -2:
+        	return "     -";
+	   default:
+        	val2valstr(cgchain->cstat->conf.pidsmax, buf, 6, 0, 0);
+        	return buf;
+	}
+}
+
+detail_printdef cgroupprt_CGRTSKMAX =
+   {0, "TSKMAX", "CGRTSKMAX", .ac.doactiveconvertc = cgroup_CGRTSKMAX, NULL, NULL, 0, 6, 0};
+/***************************************************************/
+static char *
+cgroup_eventval(count_t events, int avgval, int nsecs, int *color)
+{
+        static char	buf[16];
+
+	if (events == -1)	// not defined?
+		return "     -";
+
+	if (events > 0)
+		*color = FGCOLORCRIT;
+
+       	val2valstr(events, buf, 6, avgval, nsecs);
+       	return buf;
+}
+
+char *
+cgroup_CGRMEMHIGH(struct cgchainer *cgchain, struct tstat *tstat,
+		int avgval, int nsecs, count_t cputicks, int nrcpu, int *color)
+{
+	if (tstat)	// process info?
+		return "      ";
+
+	return cgroup_eventval(cgchain->cstat->mem.evhigh, avgval, nsecs, color);
+}
+
+detail_printdef cgroupprt_CGRMEMHIGH =
+   {0, "HIGHEV", "CGRMEMHIGH", .ac.doactiveconvertc = cgroup_CGRMEMHIGH, NULL, NULL, 0, 6, 0};
+/***************************************************************/
+char *
+cgroup_CGRMEMMAXE(struct cgchainer *cgchain, struct tstat *tstat,
+		int avgval, int nsecs, count_t cputicks, int nrcpu, int *color)
+{
+	if (tstat)	// process info?
+		return "      ";
+
+	return cgroup_eventval(cgchain->cstat->mem.evmax, avgval, nsecs, color);
+}
+
+detail_printdef cgroupprt_CGRMEMMAXE =
+   {0, " MAXEV", "CGRMEMMAXE", .ac.doactiveconvertc = cgroup_CGRMEMMAXE, NULL, NULL, 0, 6, 0};
+/***************************************************************/
+char *
+cgroup_CGROOMKIL(struct cgchainer *cgchain, struct tstat *tstat,
+		int avgval, int nsecs, count_t cputicks, int nrcpu, int *color)
+{
+	if (tstat)	// process info?
+		return "      ";
+
+	return cgroup_eventval(cgchain->cstat->mem.evoomkill, avgval, nsecs, color);
+}
+
+detail_printdef cgroupprt_CGROOMKIL =
+   {0, "OOMKIL", "CGROOMKIL", .ac.doactiveconvertc = cgroup_CGROOMKIL, NULL, NULL, 0, 6, 0};
+/***************************************************************/
+char *
 cgroup_CGRPID(struct cgchainer *cgchain, struct tstat *tstat,
 		int avgval, int nsecs, count_t cputicks, int nrcpu, int *color)
 {
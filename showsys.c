@@ -941,6 +941,122 @@ sysprt_CPUICYCLE(struct sstat *sstat, extraparam *as, int badness, int *color)
 
 sys_printdef syspdef_CPUICYCLE = {"CPUICYCLE", sysprt_CPUICYCLE, sysval_IPCVALIDATE};
 /*******************************************************************/
+// common formatting of the extra perf events (perfextra):
+// 	misses as number (per second) and stalled cycles
+//	as percentage of cycles
+//
+static char *
+perfextrastr(char *buf, int bufsize, char *label, struct sstat *sstat,
+	     count_t value, count_t cycles, extraparam *as, int *color)
+{
+	int	lablen = strlen(label);
+
+	snprintf(buf, bufsize, "%s ", label);
+
+	if (sstat->cpu.all.cycle == 1)
+	{
+		*color = FGCOLORINFO;
+        	snprintf(buf+lablen+1, bufsize-lablen-1, "initial");
+		return buf;
+	}
+
+	if (cycles == 0)	// stalled cycles percentage?
+		val2valstr(value, buf+lablen+1, 11-lablen, as->avgval, as->nsecs);
+	else
+        	snprintf(buf+lablen+1, bufsize-lablen-1, "%*.1f%%",
+			10-lablen, value * 100.0 / cycles);
+
+        return buf;
+}
+
+static int
+sysval_CMISSVALIDATE(struct sstat *sstat)
+{
+	return sstat->cpu.perfextra & PERFCACHEMISS;
+}
+
+static int
+sysval_BMISSVALIDATE(struct sstat *sstat)
+{
+	return sstat->cpu.perfextra & PERFBRANCHMISS;
+}
+
+static int
+sysval_STALLVALIDATE(struct sstat *sstat)
+{
+	return sstat->cpu.perfextra & PERFSTALLCYC;
+}
+/*******************************************************************/
+static char *
+sysprt_CPUCMISS(struct sstat *sstat, extraparam *as, int badness, int *color) 
+{
+        static char buf[15];
+
+	return perfextrastr(buf, sizeof buf, "cmis", sstat,
+			sstat->cpu.all.cachemiss, 0, as, color);
+}
+
+sys_printdef syspdef_CPUCMISS = {"CPUCMISS", sysprt_CPUCMISS, sysval_CMISSVALIDATE};
+/*******************************************************************/
+static char *
+sysprt_CPUICMISS(struct sstat *sstat, extraparam *as, int badness, int *color) 
+{
+        static char buf[15];
+
+	return perfextrastr(buf, sizeof buf, "cmis", sstat,
+			sstat->cpu.cpu[as->index].cachemiss, 0, as, color);
+}
+
+sys_printdef syspdef_CPUICMISS = {"CPUICMISS", sysprt_CPUICMISS, sysval_CMISSVALIDATE};
+/*******************************************************************/
+static char *
+sysprt_CPUBMISS(struct sstat *sstat, extraparam *as, int badness, int *color) 
+{
+        static char buf[15];
+
+	return perfextrastr(buf, sizeof buf, "bmis", sstat,
+			sstat->cpu.all.branchmiss, 0, as, color);
+}
+
+sys_printdef syspdef_CPUBMISS = {"CPUBMISS", sysprt_CPUBMISS, sysval_BMISSVALIDATE};
+/*******************************************************************/
+static char *
+sysprt_CPUIBMISS(struct sstat *sstat, extraparam *as, int badness, int *color) 
+{
+        static char buf[15];
+
+	return perfextrastr(buf, sizeof buf, "bmis", sstat,
+			sstat->cpu.cpu[as->index].branchmiss, 0, as, color);
+}
+
+sys_printdef syspdef_CPUIBMISS = {"CPUIBMISS", sysprt_CPUIBMISS, sysval_BMISSVALIDATE};
+/*******************************************************************/
+static char *
+sysprt_CPUSTALL(struct sstat *sstat, extraparam *as, int badness, int *color) 
+{
+        static char buf[15];
+
+	return perfextrastr(buf, sizeof buf, "stal", sstat,
+			sstat->cpu.all.stallcyc,
+			sstat->cpu.all.cycle ? sstat->cpu.all.cycle : 1,
+			as, color);
+}
+
+sys_printdef syspdef_CPUSTALL = {"CPUSTALL", sysprt_CPUSTALL, sysval_STALLVALIDATE};
+/*******************************************************************/
+static char *
+sysprt_CPUISTALL(struct sstat *sstat, extraparam *as, int badness, int *color) 
+{
+        static char buf[15];
+	count_t	    cycles = sstat->cpu.cpu[as->index].cycle;
+
+	return perfextrastr(buf, sizeof buf, "stal", sstat,
+			sstat->cpu.cpu[as->index].stallcyc,
+			cycles ? cycles : 1, as, color);
+}
+
+sys_printdef syspdef_CPUISTALL = {"CPUISTALL", sysprt_CPUISTALL, sysval_STALLVALIDATE};
+/*******************************************************************/
 static char *
 sysprt_CPLAVG1(struct sstat *sstat, extraparam *notused, int badness, int *color) 
 {
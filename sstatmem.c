@@ -0,0 +1,315 @@
+/*
+** ATOP - System & Process Monitor
+**
+** The program 'atop' offers the possibility to view the activity of
+** the system on system-level as well as process-level.
+**
+** This source-file contains functions to manage the dynamically
+** allocated per-entity arrays (CPUs, disks, interfaces, ...) of the
+** struct sstat, and to convert a struct sstat into a contiguous
+** (packed) representation to be stored in a raw file and vice versa.
+** ==========================================================================
+** Date:        October 2026
+** --------------------------------------------------------------------------
+**
+** This program is free software; you can redistribute it and/or modify it
+** under the terms of the GNU General Public License as published by the
+** Free Software Foundation; either version 2, or (at your option) any
+** later version.
+**
+** This program is distributed in the hope that it will be useful, but
+** WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+** --------------------------------------------------------------------------
+**
+** Packed layout of a struct sstat (as stored in the raw file):
+**
+**	struct sstat   with all array pointers NULL and arrsize zero
+**	cpu.cpu        cpu.maxcpu               entries
+**	dsk.dsk        dsk.ndsk                 entries
+**	dsk.mdd        dsk.nmdd                 entries
+**	dsk.lvm        dsk.nlvm                 entries
+**	intf.intf      intf.nrintf              entries
+**	nfs.nfsmnt     nfs.nfsmounts.nrmounts   entries
+**	cfs.cont       cfs.nrcontainer          entries
+**	memnuma.numa   memnuma.nrnuma           entries
+**	cpunuma.numa   cpunuma.nrnuma           entries
+**
+** After unpacking, every array contains at least two zeroed entries
+** beyond the number of entries in use: one as terminator and one
+** because deviatsyst() might peek beyond the terminator of the
+** previous sample when resyncing disks.
+*/
+#include <sys/types.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "atop.h"
+#include "photosyst.h"
+
+#define	MINENTRIES	8	// minimum number of entries to allocate
+#define	SPAREENTRIES	2	// terminator and resync spare
+
+static struct sarray {
+	size_t	offset;		// offset of array pointer in struct sstat
+	size_t	elemsize;	// size of one array element
+	char	*name;
+} sarrays[NRSARRAYS] = {
+   [SACPU]    = {offsetof(struct sstat, cpu.cpu),
+			sizeof(struct percpu),		"cpu"},
+   [SADSK]    = {offsetof(struct sstat, dsk.dsk),
+			sizeof(struct perdsk),		"disk"},
+   [SAMDD]    = {offsetof(struct sstat, dsk.mdd),
+			sizeof(struct perdsk),		"md"},
+   [SALVM]    = {offsetof(struct sstat, dsk.lvm),
+			sizeof(struct perdsk),		"lvm"},
+   [SAINTF]   = {offsetof(struct sstat, intf.intf),
+			sizeof(struct perintf),		"interface"},
+   [SANFSMNT] = {offsetof(struct sstat, nfs.nfsmounts.nfsmnt),
+			sizeof(struct pernfsmount),	"nfs mount"},
+   [SACONT]   = {offsetof(struct sstat, cfs.cont),
+			sizeof(struct percontainer),	"container"},
+   [SAMEMNUMA]= {offsetof(struct sstat, memnuma.numa),
+			sizeof(struct mempernuma),	"memory numa"},
+   [SACPUNUMA]= {offsetof(struct sstat, cpunuma.numa),
+			sizeof(struct cpupernuma),	"cpu numa"},
+};
+
+#define	ARRPTR(ss, arr)	((void **)((char *)(ss) + sarrays[arr].offset))
+
+/*
+** get the number of entries in use for a particular array
+*/
+static long
+sstat_count(struct sstat *ss, int arr)
+{
+	switch (arr)
+	{
+	   case SACPU:
+		return ss->cpu.maxcpu;
+	   case SADSK:
+		return ss->dsk.ndsk;
+	   case SAMDD:
+		return ss->dsk.nmdd;
+	   case SALVM:
+		return ss->dsk.nlvm;
+	   case SAINTF:
+		return ss->intf.nrintf;
+	   case SANFSMNT:
+		return ss->nfs.nfsmounts.nrmounts;
+	   case SACONT:
+		return ss->cfs.nrcontainer;
+	   case SAMEMNUMA:
+		return ss->memnuma.nrnuma;
+	   case SACPUNUMA:
+		return ss->cpunuma.nrnuma;
+	}
+
+	return 0;
+}
+
+/*
+** take care that the given array can contain at least 'nentries'
+** entries; newly allocated entries are zeroed
+*/
+void
+sstat_reserve(struct sstat *ss, int arr, long nentries)
+{
+	void	**pp = ARRPTR(ss, arr);
+	size_t	esz  = sarrays[arr].elemsize;
+	long	oldsize = ss->arrsize[arr], newsize;
+
+	if (nentries <= oldsize)
+		return;
+
+	newsize = oldsize ? oldsize : MINENTRIES;
+
+	while (newsize < nentries)
+		newsize *= 2;
+
+	*pp = realloc(*pp, newsize * esz);
+
+	ptrverify(*pp, "Realloc failed for %ld %s entries\n",
+						newsize, sarrays[arr].name);
+
+	memset((char *)*pp + oldsize * esz, 0, (newsize - oldsize) * esz);
+
+	ss->arrsize[arr] = newsize;
+}
+
+/*
+** take care that all arrays of 'ss' can contain the entries
+** in use by 'ref' including the spare entries
+*/
+void
+sstat_reservelike(struct sstat *ss, struct sstat *ref)
+{
+	int	arr;
+
+	for (arr=0; arr < NRSARRAYS; arr++)
+		sstat_reserve(ss, arr, sstat_count(ref, arr) + SPAREENTRIES);
+}
+
+/*
+** clear all counters, but keep the allocated arrays (zeroed)
+*/
+void
+sstat_reset(struct sstat *ss)
+{
+	void	*ptrs[NRSARRAYS];
+	int	sizes[NRSARRAYS], arr;
+
+	for (arr=0; arr < NRSARRAYS; arr++)
+	{
+		ptrs[arr]  = *ARRPTR(ss, arr);
+		sizes[arr] = ss->arrsize[arr];
+	}
+
+	memset(ss, 0, sizeof *ss);
+
+	for (arr=0; arr < NRSARRAYS; arr++)
+	{
+		*ARRPTR(ss, arr)  = ptrs[arr];
+		ss->arrsize[arr]  = sizes[arr];
+
+		if (ptrs[arr])
+			memset(ptrs[arr], 0, sizes[arr] * sarrays[arr].elemsize);
+	}
+}
+
+/*
+** release the allocated arrays
+*/
+void
+sstat_free(struct sstat *ss)
+{
+	int	arr;
+
+	for (arr=0; arr < NRSARRAYS; arr++)
+	{
+		free(*ARRPTR(ss, arr));
+
+		*ARRPTR(ss, arr) = NULL;
+		ss->arrsize[arr] = 0;
+	}
+}
+
+/*
+** determine the length of the packed representation
+*/
+unsigned long
+sstat_packlen(struct sstat *ss)
+{
+	unsigned long	len = sizeof *ss;
+	int		arr;
+
+	for (arr=0; arr < NRSARRAYS; arr++)
+		len += sstat_count(ss, arr) * sarrays[arr].elemsize;
+
+	return len;
+}
+
+/*
+** store the packed representation in 'buf'
+** that should have a size of (at least) sstat_packlen() bytes
+*/
+void
+sstat_pack(struct sstat *ss, void *buf)
+{
+	struct sstat	*ps = buf;
+	char		*p  = (char *)buf + sizeof *ss;
+	size_t		len;
+	int		arr;
+
+	memcpy(ps, ss, sizeof *ss);
+
+	for (arr=0; arr < NRSARRAYS; arr++)
+	{
+		*ARRPTR(ps, arr) = NULL;
+		ps->arrsize[arr] = 0;
+
+		len = sstat_count(ss, arr) * sarrays[arr].elemsize;
+
+		if (len)
+		{
+			memcpy(p, *ARRPTR(ss, arr), len);
+			p += len;
+		}
+	}
+}
+
+/*
+** fill 'ss' from the packed representation in 'buf' with length 'buflen'
+** (the arrays already allocated for 'ss' are reused)
+**
+** return value: 1 (success) or 0 (inconsistent packed representation)
+*/
+int
+sstat_unpack(struct sstat *ss, void *buf, unsigned long buflen)
+{
+	struct sstat	*ps = buf;
+	char		*p  = (char *)buf + sizeof *ss;
+	unsigned long	len, totlen = sizeof *ss;
+	void		*ptrs[NRSARRAYS];
+	int		sizes[NRSARRAYS], arr;
+	long		cnt;
+
+	if (buflen < sizeof *ss)
+		return 0;
+
+	/*
+	** verify that the packed arrays fit exactly in the buffer
+	*/
+	for (arr=0; arr < NRSARRAYS; arr++)
+	{
+		cnt = sstat_count(ps, arr);
+
+		if (cnt < 0 || cnt > buflen / sarrays[arr].elemsize)
+			return 0;
+
+		totlen += cnt * sarrays[arr].elemsize;
+	}
+
+	if (totlen != buflen)
+		return 0;
+
+	/*
+	** copy the fixed part, but preserve own arrays
+	*/
+	sstat_reset(ss);
+	sstat_reservelike(ss, ps);
+
+	for (arr=0; arr < NRSARRAYS; arr++)
+	{
+		ptrs[arr]  = *ARRPTR(ss, arr);
+		sizes[arr] = ss->arrsize[arr];
+	}
+
+	memcpy(ss, ps, sizeof *ss);
+
+	for (arr=0; arr < NRSARRAYS; arr++)
+	{
+		*ARRPTR(ss, arr) = ptrs[arr];
+		ss->arrsize[arr] = sizes[arr];
+	}
+
+	for (arr=0; arr < NRSARRAYS; arr++)
+	{
+		len = sstat_count(ss, arr) * sarrays[arr].elemsize;
+
+		if (len)
+		{
+			memcpy(*ARRPTR(ss, arr), p, len);
+			p += len;
+		}
+	}
+
+	return 1;
+}
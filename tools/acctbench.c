@@ -0,0 +1,268 @@
+/*
+** ATOP - System & Process Monitor
+**
+** The program 'atop' offers the possibility to view the activity of
+** the system on system-level as well as process-level.
+**
+** This source-file contains a benchmark for reading the records of
+** exited processes from a process accounting file (e.g. generated by
+** acctgen) as atop does per sample with acctphotoproc(), i.e. in chunks
+** of records per read().
+** For comparison the records are also read with one read() per record,
+** as atop did before.
+**
+** The source file acctproc.c is included to open the given file as
+** accounting file, instead of switching on process accounting.
+**
+** Usage:
+**	acctbench [-n samples] filename
+**
+** The output shows the time needed per sample to read all records
+** of the file in both ways, with the number of records and a checksum
+** to verify that both ways give the same result.
+** ==========================================================================
+** Date:        October 2026
+** --------------------------------------------------------------------------
+**
+** This program is free software; you can redistribute it and/or modify it
+** under the terms of the GNU General Public License as published by the
+** Free Software Foundation; either version 2, or (at your option) any
+** later version.
+**
+** This program is distributed in the hope that it will be useful, but
+** WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU General Public License for more details.
+*/
+#include "acctproc.c"
+
+#include <stdarg.h>
+#include <time.h>
+
+static double		readchunks(struct tstat *, unsigned long,
+					unsigned long long *);
+static double		readrecords(struct tstat *, unsigned long,
+					unsigned long long *);
+static unsigned long long	checkproc(struct tstat *, unsigned long);
+
+time_t		pretime;
+int		supportflags;
+
+int
+main(int argc, char *argv[])
+{
+	struct tstat		*accproc;
+	struct stat		statacc;
+	unsigned long		nrecs;
+	unsigned long long	chunksum = 0, recsum = 0;
+	double			chunkms = 0.0, recms = 0.0;
+	int			c, s, nsamples = 10;
+
+	while ( (c = getopt(argc, argv, "n:")) != -1)
+	{
+		switch (c)
+		{
+		   case 'n':
+			nsamples = atoi(optarg);
+			break;
+		   default:
+			argc = 0;
+		}
+	}
+
+	if (argc - optind != 1 || nsamples <= 0)
+	{
+		fprintf(stderr, "Usage: acctbench [-n samples] filename\n");
+		exit(1);
+	}
+
+	/*
+	** use the file as accounting file (classic accounting)
+	*/
+	if ( (acctfd = open(argv[optind], O_RDONLY)) == -1)
+	{
+		perror(argv[optind]);
+		exit(2);
+	}
+
+	if (!acctvers(acctfd) || fstat(acctfd, &statacc) == -1)
+	{
+		fprintf(stderr, "%s: no accounting records\n", argv[optind]);
+		exit(2);
+	}
+
+	nrecs = statacc.st_size / acctrecsz;
+
+	if ( (accproc = calloc(nrecs, sizeof(struct tstat))) == NULL)
+	{
+		fprintf(stderr, "Malloc failed for %lu records\n", nrecs);
+		exit(2);
+	}
+
+	for (s=0; s < nsamples; s++)
+	{
+		chunkms += readchunks(accproc, nrecs, &chunksum);
+		recms   += readrecords(accproc, nrecs, &recsum);
+	}
+
+	printf("%7lu records (version %d): chunks %8.3f ms/sample, "
+	       "per record %8.3f ms/sample  (checksum %llx)\n",
+		nrecs, acctversion, chunkms / nsamples, recms / nsamples,
+		chunksum);
+
+	return chunksum == recsum ? 0 : 4;
+}
+
+/*
+** read all records as atop does now: the number of new records
+** is determined and read by acctphotoproc()
+**
+** return value: elapsed time in milliseconds
+*/
+static double
+readchunks(struct tstat *accproc, unsigned long nrecs,
+					unsigned long long *checksum)
+{
+	struct timespec	tstart, tend;
+	unsigned long	nexit;
+
+	acctsize = 0;			// as if all records are new
+	(void) lseek(acctfd, 0, SEEK_SET);
+
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+
+	nexit = acctprocnt();
+
+	if (nexit > nrecs)
+		nexit = nrecs;
+
+	nexit = acctphotoproc(accproc, nexit);
+
+	clock_gettime(CLOCK_MONOTONIC, &tend);
+
+	*checksum += checkproc(accproc, nexit);
+
+	return (tend.tv_sec  - tstart.tv_sec) * 1000.0 +
+	       (tend.tv_nsec - tstart.tv_nsec) / 1000000.0;
+}
+
+/*
+** read all records as atop did before: one read() per record
+**
+** return value: elapsed time in milliseconds
+*/
+static double
+readrecords(struct tstat *accproc, unsigned long nrecs,
+					unsigned long long *checksum)
+{
+	struct timespec	tstart, tend;
+	struct tstat	*api;
+	union {
+		struct acct	v2;
+		struct acct_v3	v3;
+	} acctrec;
+	unsigned long	nexit;
+
+	(void) lseek(acctfd, 0, SEEK_SET);
+
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+
+	for (nexit=0, api=accproc; nexit < nrecs; nexit++, api++)
+	{
+		if (read(acctfd, &acctrec, acctrecsz) < acctrecsz)
+			break;
+
+		if (acctversion == 2)
+			acctfill(api, &acctrec.v2);
+		else
+			acctfill_v3(api, &acctrec.v3);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &tend);
+
+	*checksum += checkproc(accproc, nexit);
+
+	return (tend.tv_sec  - tstart.tv_sec) * 1000.0 +
+	       (tend.tv_nsec - tstart.tv_nsec) / 1000000.0;
+}
+
+/*
+** checksum of the exited processes (also counting the processes)
+*/
+static unsigned long long
+checkproc(struct tstat *api, unsigned long nexit)
+{
+	unsigned long long	sum = nexit;
+	char			*p;
+
+	for (; nexit > 0; nexit--, api++)
+	{
+		sum = sum * 31 + api->gen.pid + api->gen.ruid * 3 +
+		      api->gen.btime * 5 + api->cpu.utime * 7 +
+		      api->cpu.stime * 11 + api->mem.minflt * 13 +
+		      api->mem.majflt * 17 + api->dsk.rio * 19 +
+		      api->gen.excode * 23;
+
+		for (p = api->gen.name; *p; p++)
+			sum = sum * 31 + (unsigned char)*p;
+	}
+
+	return sum;
+}
+
+/*
+** functions of atop that are used by acctproc.c
+*/
+void
+ptrverify(const void *ptr, const char *errormsg, ...)
+{
+	va_list	args;
+
+	if (!ptr)
+	{
+		va_start(args, errormsg);
+		vfprintf(stderr, errormsg, args);
+		va_end(args);
+
+		exit(13);
+	}
+}
+
+void
+mcleanstop(int exitcode, const char *errormsg, ...)
+{
+	va_list	args;
+
+	va_start(args, errormsg);
+	vfprintf(stderr, errormsg, args);
+	va_end(args);
+
+	exit(exitcode);
+}
+
+void
+safe_strcpy(char *dst, const char *src, size_t dstsize)
+{
+	if (dstsize == 0)
+		return;
+
+	strncpy(dst, src, dstsize - 1);
+	dst[dstsize - 1] = '\0';
+}
+
+int
+numeric(char *ns)
+{
+	return strspn(ns, "0123456789") == strlen(ns);
+}
+
+int
+droprootprivs(void)
+{
+	return 1;
+}
+
+void
+regainrootprivs(void)
+{
+}
@@ -0,0 +1,230 @@
+/*
+** ATOP - System & Process Monitor
+**
+** The program 'atop' offers the possibility to view the activity of
+** the system on system-level as well as process-level.
+**
+** This source-file contains a generator of synthetic process accounting
+** files with records in the layout of version 2 or version 3, as written
+** by the kernel for exited processes.
+** The fields of every record are derived from a seed and the sequence
+** number of the record, so every run generates the same file.
+** The records are appended to the file, so a growing accounting file
+** can be simulated by calling the generator repeatedly.
+**
+** Usage:
+**	acctgen [-v version] [-s seed] [-b firstseq] filename nrecords
+**
+**	-v	layout of the records: 2 or 3 (default 3)
+**	-s	seed for the synthetic values (default 1)
+**	-b	sequence number of the first record (default 0)
+** ==========================================================================
+** Date:        October 2026
+** --------------------------------------------------------------------------
+**
+** This program is free software; you can redistribute it and/or modify it
+** under the terms of the GNU General Public License as published by the
+** Free Software Foundation; either version 2, or (at your option) any
+** later version.
+**
+** This program is distributed in the hope that it will be useful, but
+** WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU General Public License for more details.
+*/
+#include <sys/types.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "atop.h"
+#include "photoproc.h"
+#include "acctproc.h"
+
+#define	GENCHUNK	1024	/* records per write */
+
+static char	*commands[] = {
+	"sh", "bash", "cc1", "as", "ld", "make", "sed", "awk", "grep",
+	"python3", "perl", "git", "cat", "sort", "runc", "containerd-shim",
+};
+
+#define	NCOMMANDS	(sizeof commands / sizeof commands[0])
+
+static unsigned int	seed = 1;
+
+static unsigned int	mix(unsigned int, unsigned int);
+static comp_t		acctcomp(unsigned long);
+static void		fill_v2(struct acct *, unsigned long);
+static void		fill_v3(struct acct_v3 *, unsigned long);
+
+int
+main(int argc, char *argv[])
+{
+	static union {
+		struct acct	v2[GENCHUNK];
+		struct acct_v3	v3[GENCHUNK];
+	} chunk;
+
+	unsigned long	nrecords, firstseq = 0, seq, n;
+	int		c, version = 3, i;
+	size_t		recsz;
+	FILE		*fp;
+
+	while ( (c = getopt(argc, argv, "v:s:b:")) != -1)
+	{
+		switch (c)
+		{
+		   case 'v':
+			version = atoi(optarg);
+			break;
+		   case 's':
+			seed = strtoul(optarg, NULL, 0);
+			break;
+		   case 'b':
+			firstseq = strtoul(optarg, NULL, 0);
+			break;
+		   default:
+			argc = 0;
+		}
+	}
+
+	if (argc - optind != 2 || (version != 2 && version != 3) ||
+	    (nrecords = strtoul(argv[optind+1], NULL, 0)) == 0)
+	{
+		fprintf(stderr, "Usage: acctgen [-v version] [-s seed] "
+		                "[-b firstseq] filename nrecords\n");
+		exit(1);
+	}
+
+	if ( (fp = fopen(argv[optind], "a")) == NULL)
+	{
+		perror(argv[optind]);
+		exit(2);
+	}
+
+	recsz = version == 2 ? sizeof(struct acct) : sizeof(struct acct_v3);
+
+	for (seq=firstseq; seq < firstseq + nrecords; seq += n)
+	{
+		n = firstseq + nrecords - seq;
+
+		if (n > GENCHUNK)
+			n = GENCHUNK;
+
+		memset(&chunk, 0, sizeof chunk);
+
+		for (i=0; i < n; i++)
+		{
+			if (version == 2)
+				fill_v2(&chunk.v2[i], seq + i);
+			else
+				fill_v3(&chunk.v3[i], seq + i);
+		}
+
+		if (fwrite(&chunk, recsz, n, fp) != n)
+		{
+			perror(argv[optind]);
+			exit(3);
+		}
+	}
+
+	if (fclose(fp) == EOF)
+	{
+		perror(argv[optind]);
+		exit(3);
+	}
+
+	return 0;
+}
+
+/*
+** synthetic record (version 2): no PID available
+*/
+static void
+fill_v2(struct acct *ap, unsigned long seq)
+{
+	unsigned int	h = mix(seed, seq);
+
+	ap->ac_version  = 2;
+	ap->ac_uid16    = h % 8 ? 1000 + h % 50 : 0;
+	ap->ac_gid16    = ap->ac_uid16;
+	ap->ac_uid      = ap->ac_uid16;
+	ap->ac_gid      = ap->ac_gid16;
+	ap->ac_btime    = 1790000000 + seq / 100;
+	ap->ac_etime    = acctcomp(h % 5000);
+	ap->ac_utime    = acctcomp((h >>  4) % 20000);
+	ap->ac_stime    = acctcomp((h >>  8) %  5000);
+	ap->ac_minflt   = acctcomp((h >> 12) % 100000);
+	ap->ac_majflt   = acctcomp((h >> 16) %    50);
+	ap->ac_rw       = acctcomp((h >> 20) %  2000);
+	ap->ac_exitcode = h % 16 ? 0 : 256;
+
+	strncpy(ap->ac_comm, commands[(h >> 24) % NCOMMANDS],
+						sizeof ap->ac_comm - 1);
+}
+
+/*
+** synthetic record (version 3): PIDs increase like they do for
+** short-lived processes
+*/
+static void
+fill_v3(struct acct_v3 *ap, unsigned long seq)
+{
+	unsigned int	h = mix(seed, seq);
+
+	ap->ac_version  = 3;
+	ap->ac_uid      = h % 8 ? 1000 + h % 50 : 0;
+	ap->ac_gid      = ap->ac_uid;
+	ap->ac_pid      = 1000 + seq % 4000000;
+	ap->ac_ppid     = 1000 + (seq - seq % 8) % 4000000;
+	ap->ac_btime    = 1790000000 + seq / 100;
+	ap->ac_etime    = h % 5000;
+	ap->ac_utime    = acctcomp((h >>  4) % 20000);
+	ap->ac_stime    = acctcomp((h >>  8) %  5000);
+	ap->ac_minflt   = acctcomp((h >> 12) % 100000);
+	ap->ac_majflt   = acctcomp((h >> 16) %    50);
+	ap->ac_rw       = acctcomp((h >> 20) %  2000);
+	ap->ac_exitcode = h % 16 ? 0 : 256;
+
+	strncpy(ap->ac_comm, commands[(h >> 24) % NCOMMANDS],
+						sizeof ap->ac_comm - 1);
+}
+
+/*
+** compress a value in the format of the kernel: 13 bits mantissa
+** and 3 bits base-8 exponent
+*/
+static comp_t
+acctcomp(unsigned long val)
+{
+	int	exp = 0;
+
+	while (val > 0x1fff && exp < 7)
+	{
+		val >>= 3;
+		exp++;
+	}
+
+	if (val > 0x1fff)
+		val = 0x1fff;
+
+	return (exp << 13) | val;
+}
+
+/*
+** integer hash of seed and value
+*/
+static unsigned int
+mix(unsigned int seed, unsigned int val)
+{
+	unsigned int	h = seed * 0x9e3779b9 ^ val;
+
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35;
+	h ^= h >> 16;
+
+	return h;
+}
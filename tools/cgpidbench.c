@@ -0,0 +1,258 @@
+/*
+** ATOP - System & Process Monitor
+**
+** The program 'atop' offers the possibility to view the activity of
+** the system on system-level as well as process-level.
+**
+** This source-file contains a benchmark for connecting every process
+** to its cgroup via the PID index of cgroups.c, as atop does once per
+** sample with cgfillref(): a synthetic deviation chain of cgroups with
+** their PID lists is built in memory, together with a task list
+** of processes and threads.
+** Per sample the index is built once for the new snapshot and all
+** tasks are searched; additionally the searches are measured with
+** an index that is reused (a second consumer in the same snapshot).
+**
+** The source file cgroups.c is included to invalidate the PID index
+** (a static function) like a new snapshot does.
+**
+** Usage:
+**	cgpidbench [-n samples] [-c tasks per cgroup] ntasks
+**
+** The output shows the time needed per sample, and the number of
+** processes connected to the proper cgroup with a checksum of the
+** cgroup indexes to verify that the results are reproducible.
+** ==========================================================================
+** Date:        October 2026
+** --------------------------------------------------------------------------
+**
+** This program is free software; you can redistribute it and/or modify it
+** under the terms of the GNU General Public License as published by the
+** Free Software Foundation; either version 2, or (at your option) any
+** later version.
+**
+** This program is distributed in the hope that it will be useful, but
+** WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU General Public License for more details.
+*/
+#include "cgroups.c"
+
+#include <stdarg.h>
+
+static double	lookup(struct devtstat *, struct cgchainer *, int, int, int,
+					unsigned long *, unsigned long long *);
+
+int	cgroupdepth;
+char	deviatonly;
+int	supportflags;
+
+unsigned int	pagesize;
+
+int
+main(int argc, char *argv[])
+{
+	struct devtstat		devtstat;
+	struct cgchainer	*devchain;
+	struct cstat		*cstats;
+	struct tstat		*tp;
+	pid_t			*pids, *pp;
+	unsigned long		found = 0, refound = 0;
+	unsigned long long	checksum = 0, rechecksum = 0;
+	double			buildms = 0.0, reusems = 0.0;
+	long			ntasks, nprocs, i;
+	int			c, s, ic, nsamples = 20, percgroup = 10;
+	int			ncgroups;
+
+	while ( (c = getopt(argc, argv, "n:c:")) != -1)
+	{
+		switch (c)
+		{
+		   case 'n':
+			nsamples = atoi(optarg);
+			break;
+		   case 'c':
+			percgroup = atoi(optarg);
+			break;
+		   default:
+			argc = 0;
+		}
+	}
+
+	if (argc - optind != 1 || (ntasks = atol(argv[optind])) <= 0 ||
+	    nsamples <= 0 || percgroup <= 0)
+	{
+		fprintf(stderr, "Usage: cgpidbench [-n samples] "
+		                "[-c tasks per cgroup] ntasks\n");
+		exit(1);
+	}
+
+	/*
+	** every fourth task is a thread of the process before;
+	** the processes are spread over the cgroups round-robin
+	** with PIDs that are not contiguous
+	*/
+	nprocs   = ntasks - ntasks / 4;
+	ncgroups = (ntasks + percgroup - 1) / percgroup;
+
+	devtstat.taskall  = calloc(ntasks, sizeof(struct tstat));
+	devtstat.ntaskall = ntasks;
+
+	devchain = calloc(ncgroups, sizeof(struct cgchainer));
+	cstats   = calloc(ncgroups, sizeof(struct cstat));
+	pids     = calloc(nprocs, sizeof(pid_t));
+
+	if (!devtstat.taskall || !devchain || !cstats || !pids)
+	{
+		fprintf(stderr, "Malloc failed for %ld tasks\n", ntasks);
+		exit(2);
+	}
+
+	for (i=0, tp=devtstat.taskall; i < ntasks; i++, tp++)
+	{
+		if (i % 4 == 3)		// thread
+		{
+			tp->gen.pid    = (tp-1)->gen.pid;
+			tp->gen.tgid   = (tp-1)->gen.pid;
+			tp->gen.isproc = 0;
+		}
+		else
+		{
+			tp->gen.pid    = 300 + i * 7;
+			tp->gen.tgid   = tp->gen.pid;
+			tp->gen.isproc = 1;
+
+			cstats[(i - i/4) % ncgroups].gen.nprocs++;
+		}
+	}
+
+	for (ic=0, pp=pids; ic < ncgroups; ic++)
+	{
+		devchain[ic].cstat    = &cstats[ic];
+		devchain[ic].proclist = pp;
+		devchain[ic].next     = ic+1 < ncgroups ? &devchain[ic+1] : NULL;
+
+		pp += cstats[ic].gen.nprocs;
+
+		cstats[ic].gen.nprocs = 0;	// refilled below
+	}
+
+	for (i=0, tp=devtstat.taskall; i < ntasks; i++, tp++)
+	{
+		if (tp->gen.isproc)
+		{
+			ic = (i - i/4) % ncgroups;
+			devchain[ic].proclist[cstats[ic].gen.nprocs++] = tp->gen.pid;
+		}
+	}
+
+	/*
+	** first lookup is not measured (allocation of the index)
+	*/
+	lookup(&devtstat, devchain, ncgroups, nprocs, 1, &found, &checksum);
+
+	found    = 0;
+	checksum = 0;
+
+	for (s=0; s < nsamples; s++)
+	{
+		buildms += lookup(&devtstat, devchain, ncgroups, nprocs, 1,
+						&found, &checksum);
+		reusems += lookup(&devtstat, devchain, ncgroups, nprocs, 0,
+						&refound, &rechecksum);
+	}
+
+	printf("%7ld tasks: %8.3f ms/sample (index built), %8.3f ms/sample "
+	       "(index reused)  (found %lu processes in %d cgroups, "
+	       "checksum %llx)\n", ntasks, buildms / nsamples,
+		reusems / nsamples, found / nsamples, ncgroups, checksum);
+
+	return found == nprocs * nsamples && refound == found &&
+	       rechecksum == checksum ? 0 : 4;
+}
+
+/*
+** connect all tasks to their cgroup, after invalidating the PID index
+** (new snapshot) or with the index as built before
+**
+** return value: elapsed time in milliseconds
+*/
+static double
+lookup(struct devtstat *devtstat, struct cgchainer *devchain, int ncgroups,
+	int nprocs, int newsnapshot, unsigned long *found,
+	unsigned long long *checksum)
+{
+	struct timespec	tstart, tend;
+	struct tstat	*tp;
+	unsigned long	i;
+
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+
+	if (newsnapshot)
+		cgpidinvalidate();
+
+	cgfillref(devtstat, devchain, ncgroups, nprocs);
+
+	clock_gettime(CLOCK_MONOTONIC, &tend);
+
+	/*
+	** only count processes that are connected to the proper cgroup
+	*/
+	for (i=0, tp=devtstat->taskall; i < devtstat->ntaskall; i++, tp++)
+	{
+		if (!tp->gen.isproc || tp->gen.cgroupix != (i - i/4) % ncgroups)
+			continue;
+
+		(*found)++;
+		*checksum = *checksum * 31 + tp->gen.cgroupix;
+	}
+
+	return (tend.tv_sec  - tstart.tv_sec) * 1000.0 +
+	       (tend.tv_nsec - tstart.tv_nsec) / 1000000.0;
+}
+
+/*
+** functions of atop that are used by cgroups.c
+*/
+void
+ptrverify(const void *ptr, const char *errormsg, ...)
+{
+	va_list	args;
+
+	if (!ptr)
+	{
+		va_start(args, errormsg);
+		vfprintf(stderr, errormsg, args);
+		va_end(args);
+
+		exit(13);
+	}
+}
+
+void
+mcleanstop(int exitcode, const char *errormsg, ...)
+{
+	va_list	args;
+
+	va_start(args, errormsg);
+	vfprintf(stderr, errormsg, args);
+	va_end(args);
+
+	exit(exitcode);
+}
+
+void
+safe_strcpy(char *dst, const char *src, size_t dstsize)
+{
+	if (dstsize == 0)
+		return;
+
+	strncpy(dst, src, dstsize - 1);
+	dst[dstsize - 1] = '\0';
+}
+
+int
+isdisk_major(unsigned int major)
+{
+	return major == 8 ? DSKTYPE : NONTYPE;
+}
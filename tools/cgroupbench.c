@@ -0,0 +1,410 @@
+/*
+** ATOP - System & Process Monitor
+**
+** The program 'atop' offers the possibility to view the activity of
+** the system on system-level as well as process-level.
+**
+** This source-file contains a benchmark for the gathering of the
+** cgroup metrics per sample: a synthetic cgroup tree (directories with
+** the usual cgroup v2 files) is created underneath the directory
+** CGROUPROOT, preferably on tmpfs, after which photocgroup() walks this
+** tree as atop does for /sys/fs/cgroup.
+** The tree resembles a systemd host running containers: the top level
+** slices system.slice, user.slice, machine.slice and kubepods.slice
+** with nested cgroups underneath.
+**
+** The source file cgroups.c is included to redirect CGROUPROOT and to
+** verify the results with its static variables; CGROUPROOT has to be
+** defined while compiling (see the Makefile).
+**
+** Usage:
+**	cgroupbench [-n samples] [-f fanout] ncgroups
+**
+** The output shows the time needed for the first sample (building the
+** persistent tree with inotify watches), the time per later sample with
+** inotify and the time per sample when inotify is not used (the tree is
+** rebuilt for every sample), together with the number of cgroups and
+** processes found and a checksum of the counters to verify that every
+** method gives the same result.
+** ==========================================================================
+** Date:        October 2026
+** --------------------------------------------------------------------------
+**
+** This program is free software; you can redistribute it and/or modify it
+** under the terms of the GNU General Public License as published by the
+** Free Software Foundation; either version 2, or (at your option) any
+** later version.
+**
+** This program is distributed in the hope that it will be useful, but
+** WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU General Public License for more details.
+*/
+#include "cgroups.c"
+
+#include <stdarg.h>
+#include <ftw.h>
+#include <sys/stat.h>
+
+struct result {
+	unsigned long		ncgroups;
+	unsigned long		nprocs;
+	unsigned long long	checksum;
+};
+
+static void	maketree(long, int);
+static void	removetree(void);
+static void	makecgroup(char *, long);
+static void	writefile(char *, char *, char *, ...);
+static int	removeentry(const char *, const struct stat *, int,
+							struct FTW *);
+static double	sample(struct result *);
+
+int	cgroupdepth;
+char	deviatonly;
+int	supportflags;
+
+unsigned int	pagesize;
+
+int
+main(int argc, char *argv[])
+{
+	struct result	first = {0}, watched = {0}, rebuilt = {0};
+	double		firstms, watchms = 0.0, rebuildms = 0.0;
+	long		ncgroups;
+	int		c, s, nsamples = 20, fanout = 8, watching;
+
+	while ( (c = getopt(argc, argv, "n:f:")) != -1)
+	{
+		switch (c)
+		{
+		   case 'n':
+			nsamples = atoi(optarg);
+			break;
+		   case 'f':
+			fanout = atoi(optarg);
+			break;
+		   default:
+			argc = 0;
+		}
+	}
+
+	if (argc - optind != 1 || (ncgroups = atol(argv[optind])) < 4 ||
+	    nsamples <= 0 || fanout < 1)
+	{
+		fprintf(stderr, "Usage: cgroupbench [-n samples] [-f fanout] "
+		                "ncgroups (at least 4)\n");
+		exit(1);
+	}
+
+	pagesize = sysconf(_SC_PAGESIZE);
+
+	atexit(removetree);
+
+	maketree(ncgroups, fanout);
+
+	/*
+	** first sample: build the persistent tree with inotify watches
+	*/
+	firstms = sample(&first);
+
+	/*
+	** later samples: tree maintained via inotify
+	*/
+	for (s=0; s < nsamples; s++)
+		watchms += sample(&watched);
+
+	watching = cgtreevalid;	// inotify usable (enough watches)?
+
+	/*
+	** samples without inotify: tree rebuilt for every sample
+	*/
+	cgnowatch   = 1;
+	cgtreevalid = 0;
+
+	for (s=0; s < nsamples; s++)
+		rebuildms += sample(&rebuilt);
+
+	printf("%7ld cgroups: first %8.3f ms, with inotify %8.3f ms/sample, "
+	       "without inotify %8.3f ms/sample\n", ncgroups, firstms,
+		watchms / nsamples, rebuildms / nsamples);
+
+	printf("%7s  found %lu cgroups, %lu processes (checksum %llx)%s\n", "",
+		first.ncgroups, first.nprocs, first.checksum,
+		watching ? "" : " (inotify not usable)");
+
+	if (first.ncgroups != ncgroups + 1				||
+	    watched.ncgroups != first.ncgroups * nsamples		||
+	    watched.nprocs   != first.nprocs   * nsamples		||
+	    watched.checksum != first.checksum * nsamples		||
+	    memcmp(&watched, &rebuilt, sizeof watched) != 0		  )
+	{
+		fprintf(stderr, "different results: %lu/%lu cgroups, "
+		                "%lu/%lu processes with/without inotify\n",
+			watched.ncgroups / nsamples, rebuilt.ncgroups / nsamples,
+			watched.nprocs   / nsamples, rebuilt.nprocs   / nsamples);
+		return 4;
+	}
+
+	return 0;
+}
+
+/*
+** create the tree with ncgroups directories (apart from the top
+** directory): four top level slices, and every cgroup gets up to
+** 'fanout' children (breadth first) until all cgroups are created
+*/
+static void
+maketree(long ncgroups, int fanout)
+{
+	static char	*slices[] = {"system.slice", "user.slice",
+				     "machine.slice", "kubepods.slice"};
+	char		**paths, path[PATH_MAX];
+	long		n, parent;
+	int		i;
+
+	removetree();
+
+	paths = calloc(ncgroups, sizeof *paths);
+
+	ptrverify(paths, "Malloc failed for %ld cgroup paths\n", ncgroups);
+
+	makecgroup(CGROUPROOT, 0);
+
+	for (n=0; n < 4; n++)
+	{
+		snprintf(path, sizeof path, "%s/%s", CGROUPROOT, slices[n]);
+		paths[n] = strdup(path);
+		makecgroup(path, n+1);
+	}
+
+	for (parent=0; n < ncgroups; parent++)
+	{
+		for (i=0; i < fanout && n < ncgroups; i++, n++)
+		{
+			snprintf(path, sizeof path, "%s/cg%ld-%d.scope",
+						paths[parent], n, i);
+			paths[n] = strdup(path);
+			makecgroup(path, n+1);
+		}
+	}
+
+	for (n=0; n < ncgroups; n++)
+		free(paths[n]);
+
+	free(paths);
+}
+
+/*
+** create one cgroup directory with its files;
+** the values are derived from the sequence number of the cgroup
+*/
+static void
+makecgroup(char *path, long seq)
+{
+	char	procs[64], *p = procs;
+	int	i;
+
+	if (mkdir(path, 0755) == -1)
+	{
+		perror(path);
+		exit(2);
+	}
+
+	for (i=0; i < seq % 4; i++)
+		p += snprintf(p, procs + sizeof procs - p, "%ld\n",
+							100000 + seq * 4 + i);
+	*p = '\0';
+
+	writefile(path, "cgroup.procs", "%s", procs);
+	writefile(path, "cgroup.controllers", "cpu io memory pids\n");
+	writefile(path, "cpu.weight", "%ld\n", seq % 3 ? 100 : seq % 1000 + 1);
+	writefile(path, "cpu.max", seq % 5 ? "max 100000\n" : "50000 100000\n");
+	writefile(path, "memory.max", seq % 7 ? "max\n" : "1073741824\n");
+	writefile(path, "memory.swap.max", "max\n");
+	writefile(path, "pids.max", seq % 2 ? "max\n" : "4096\n");
+	writefile(path, "pids.current", "%ld\n", seq % 4 * 3);
+
+	writefile(path, "cpu.stat",
+		"usage_usec %ld\nuser_usec %ld\nsystem_usec %ld\n"
+		"core_sched.force_idle_usec 0\nnr_periods %ld\n"
+		"nr_throttled %ld\nthrottled_usec %ld\n"
+		"nr_bursts 0\nburst_usec 0\n",
+		seq * 3000, seq * 2000, seq * 1000, seq * 10, seq % 10,
+		seq % 10 * 1500);
+
+	writefile(path, "memory.current", "%ld\n", seq * 1048576);
+
+	writefile(path, "memory.stat",
+		"anon %ld\nfile %ld\nkernel %ld\nkernel_stack 16384\n"
+		"pagetables 65536\nsec_pagetables 0\npercpu 1024\n"
+		"sock %ld\nvmalloc 0\nshmem %ld\nzswap 0\nzswapped 0\n"
+		"file_mapped 4096\nfile_dirty 0\nfile_writeback 0\n"
+		"swapcached 0\nanon_thp 0\nfile_thp 0\nshmem_thp 0\n"
+		"inactive_anon 4096\nactive_anon %ld\ninactive_file %ld\n"
+		"active_file %ld\nunevictable 0\nslab_reclaimable 8192\n"
+		"slab_unreclaimable 8192\nslab %ld\n"
+		"workingset_refault_anon %ld\nworkingset_refault_file %ld\n"
+		"workingset_activate_anon 0\nworkingset_activate_file 0\n"
+		"workingset_restore_anon 0\nworkingset_restore_file 0\n"
+		"workingset_nodereclaim 0\npgscan 0\npgsteal 0\n"
+		"pgfault %ld\npgmajfault %ld\npgrefill 0\npgactivate 0\n"
+		"pgdeactivate 0\npglazyfree 0\npglazyfreed 0\nthp_fault_alloc 0\n"
+		"thp_collapse_alloc 0\n",
+		seq * 524288, seq * 262144, seq * 65536, seq * 4096,
+		seq * 8192, seq * 520192, seq * 131072, seq * 131072,
+		seq * 16384, seq % 10, seq % 20, seq * 100, seq % 30);
+
+	writefile(path, "memory.events",
+		"low 0\nhigh %ld\nmax %ld\noom %ld\noom_kill %ld\n"
+		"oom_group_kill 0\n",
+		seq % 11, seq % 13, seq % 17, seq % 19);
+
+	writefile(path, "io.stat",
+		"253:0 rbytes=%ld wbytes=%ld rios=%ld wios=%ld dbytes=0 dios=0\n"
+		"8:0 rbytes=%ld wbytes=%ld rios=%ld wios=%ld dbytes=0 dios=0\n",
+		seq * 40960, seq * 81920, seq * 10, seq * 20,
+		seq * 40960, seq * 81920, seq * 10, seq * 20);
+
+	writefile(path, "cpu.pressure",
+		"some avg10=0.00 avg60=0.00 avg300=0.00 total=%ld\n"
+		"full avg10=0.00 avg60=0.00 avg300=0.00 total=%ld\n",
+		seq * 700, seq * 300);
+
+	writefile(path, "memory.pressure",
+		"some avg10=0.00 avg60=0.00 avg300=0.00 total=%ld\n"
+		"full avg10=0.00 avg60=0.00 avg300=0.00 total=%ld\n",
+		seq * 70, seq * 30);
+
+	writefile(path, "io.pressure",
+		"some avg10=0.00 avg60=0.00 avg300=0.00 total=%ld\n"
+		"full avg10=0.00 avg60=0.00 avg300=0.00 total=%ld\n",
+		seq * 7, seq * 3);
+}
+
+static void
+writefile(char *dir, char *fname, char *format, ...)
+{
+	char	path[PATH_MAX];
+	FILE	*fp;
+	va_list	args;
+
+	snprintf(path, sizeof path, "%s/%s", dir, fname);
+
+	if ( (fp = fopen(path, "w")) == NULL)
+	{
+		perror(path);
+		exit(2);
+	}
+
+	va_start(args, format);
+	vfprintf(fp, format, args);
+	va_end(args);
+
+	fclose(fp);
+}
+
+/*
+** remove the tree (also when the benchmark fails)
+*/
+static void
+removetree(void)
+{
+	nftw(CGROUPROOT, removeentry, 16, FTW_DEPTH|FTW_PHYS);
+}
+
+static int
+removeentry(const char *path, const struct stat *sb, int type,
+						struct FTW *ftwbuf)
+{
+	remove(path);
+	return 0;
+}
+
+/*
+** gather the metrics of the entire tree as atop does per sample
+** and add the cgroups, processes and counters found to the result
+**
+** return value: elapsed time in milliseconds
+*/
+static double
+sample(struct result *res)
+{
+	struct timespec	tstart, tend;
+	struct cgchainer *cp;
+	struct cstat	*csp;
+	unsigned long	i;
+
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+
+	photocgroup();
+
+	clock_gettime(CLOCK_MONOTONIC, &tend);
+
+	for (i=0, cp=cgcurfirst; cp; cp = cp->next, i++)
+	{
+		csp = cp->cstat;
+
+		res->nprocs   += csp->gen.nprocs;
+		res->checksum += csp->cpu.utime + csp->cpu.stime * 3 +
+		                 csp->mem.anon * 5 + csp->mem.wsrefault * 7 +
+		                 csp->dsk.rbytes * 11 + csp->dsk.wios * 13 +
+		                 csp->cpu.somepres * 17 + csp->mem.current * 19 +
+		                 csp->gen.nrtasks * 23 + csp->conf.cpuweight * 29 +
+		                 csp->conf.memmax * 31 + csp->gen.namehash;
+
+		if (csp->gen.nprocs)
+			res->checksum += cp->proclist[csp->gen.nprocs-1];
+	}
+
+	res->ncgroups += i;
+
+	return (tend.tv_sec  - tstart.tv_sec) * 1000.0 +
+	       (tend.tv_nsec - tstart.tv_nsec) / 1000000.0;
+}
+
+/*
+** functions of atop that are used by cgroups.c
+*/
+void
+ptrverify(const void *ptr, const char *errormsg, ...)
+{
+	va_list	args;
+
+	if (!ptr)
+	{
+		va_start(args, errormsg);
+		vfprintf(stderr, errormsg, args);
+		va_end(args);
+
+		exit(13);
+	}
+}
+
+void
+mcleanstop(int exitcode, const char *errormsg, ...)
+{
+	va_list	args;
+
+	va_start(args, errormsg);
+	vfprintf(stderr, errormsg, args);
+	va_end(args);
+
+	exit(exitcode);
+}
+
+void
+safe_strcpy(char *dst, const char *src, size_t dstsize)
+{
+	if (dstsize == 0)
+		return;
+
+	strncpy(dst, src, dstsize - 1);
+	dst[dstsize - 1] = '\0';
+}
+
+int
+isdisk_major(unsigned int major)
+{
+	return major == 8 ? DSKTYPE : NONTYPE;
+}
@@ -0,0 +1,442 @@
+/*
+** ATOP - System & Process Monitor
+**
+** The program 'atop' offers the possibility to view the activity of
+** the system on system-level as well as process-level.
+**
+** This source-file contains a benchmark for the parsing of /proc/diskstats
+** on systems with thousands of devices: a synthetic diskstats file is
+** generated with disks, partitions, logical volumes, loop and ram
+** devices, and is parsed as atop does once per sample, i.e.
+** with diskstatline() and the disk name cache isdisk_cached().
+** For comparison the same file is parsed the way atop did before, i.e.
+** with a complete sscanf() per line and isdisk_name() for every line.
+**
+** The static functions of photosyst.c are used directly by including
+** the source file.
+**
+** Usage:
+**	diskstatbench [-n samples] [devices]
+**
+** The output shows the time needed per sample for both methods, the
+** number of disks, md devices and logical volumes found with a checksum
+** to verify that both methods give the same result, and the hits and
+** misses of the disk name cache.
+** ==========================================================================
+** Date:        October 2026
+** --------------------------------------------------------------------------
+**
+** This program is free software; you can redistribute it and/or modify it
+** under the terms of the GNU General Public License as published by the
+** Free Software Foundation; either version 2, or (at your option) any
+** later version.
+**
+** This program is distributed in the hope that it will be useful, but
+** WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU General Public License for more details.
+*/
+#include <stdarg.h>
+
+#include "photosyst.c"
+
+struct result {
+	long			ndsk;
+	long			nlvm;
+	long			nmdd;
+	unsigned long long	checksum;
+};
+
+static void	gendiskstats(FILE *, long);
+static void	letters(char *, size_t, const char *, long);
+static void	account(struct result *, int, struct perdsk *);
+static double	parseold(char *, struct result *);
+static double	parsenew(char *, struct result *);
+
+unsigned int	pagesize;
+int		supportflags;
+
+int
+main(int argc, char *argv[])
+{
+	char		path[] = "/tmp/diskstatsXXXXXX";
+	struct result	oldres = {0}, newres = {0};
+	double		oldms = 0.0, newms = 0.0;
+	long		ndevices = 5000;
+	int		c, s, fd, nsamples = 100;
+	FILE		*fp;
+
+	while ( (c = getopt(argc, argv, "n:")) != -1)
+	{
+		switch (c)
+		{
+		   case 'n':
+			nsamples = atoi(optarg);
+			break;
+		   default:
+			argc = 0;
+		}
+	}
+
+	if (argc - optind > 1 || nsamples <= 0 ||
+	    (argc - optind == 1 && (ndevices = atol(argv[optind])) <= 0))
+	{
+		fprintf(stderr, "Usage: diskstatbench [-n samples] [devices]\n");
+		exit(1);
+	}
+
+	if ( (fd = mkstemp(path)) == -1 || (fp = fdopen(fd, "w")) == NULL)
+	{
+		perror(path);
+		exit(2);
+	}
+
+	gendiskstats(fp, ndevices);
+	fclose(fp);
+
+	/*
+	** the first sample is not measured (compilation of the
+	** regular expressions and filling of the cache)
+	*/
+	parseold(path, &oldres);
+	parsenew(path, &newres);
+
+	memset(&oldres, 0, sizeof oldres);
+	memset(&newres, 0, sizeof newres);
+
+	for (s=0; s < nsamples; s++)
+	{
+		oldms += parseold(path, &oldres);
+		newms += parsenew(path, &newres);
+	}
+
+	unlink(path);
+
+	printf("%7ld devices: sscanf/isdisk_name %8.3f ms/sample, "
+	       "diskstatline/isdisk_cached %8.3f ms/sample\n",
+		ndevices, oldms / nsamples, newms / nsamples);
+
+	printf("%7s  found %ld disks, %ld md, %ld lvm (checksum %llx); "
+	       "cache %lu hits, %lu misses, %lu flushes (%.1f%% hits)\n", "",
+		newres.ndsk / nsamples, newres.nmdd / nsamples,
+		newres.nlvm / nsamples, newres.checksum,
+		dnhits, dnmisses, dnflushes,
+		dnhits + dnmisses ? dnhits * 100.0 / (dnhits + dnmisses) : 0.0);
+
+	if (memcmp(&oldres, &newres, sizeof oldres) != 0)
+	{
+		fprintf(stderr, "different results: %ld disks, %ld md, "
+		                "%ld lvm (checksum %llx) with sscanf\n",
+			oldres.ndsk / nsamples, oldres.nmdd / nsamples,
+			oldres.nlvm / nsamples, oldres.checksum);
+		return 4;
+	}
+
+	return 0;
+}
+
+/*
+** generate the lines of a diskstats file with the given number of
+** devices in a repeating pattern: a SCSI disk with four partitions,
+** an NVMe namespace with three partitions, an md device, two
+** dm-devices, two loop devices (one unused) and a ram device
+*/
+static void
+gendiskstats(FILE *fp, long ndevices)
+{
+	char	name[32];
+	long	n, k, r;
+	int	p;
+
+	for (n=0, k=0; n < ndevices; k++)
+	{
+		for (p=0; p <= 4 && n < ndevices; p++, n++)
+		{
+			letters(name, sizeof name, "sd", k);
+
+			if (p)
+				snprintf(name+strlen(name), 4, "%d", p);
+
+			r = k * 5 + p + 1;
+
+			fprintf(fp, "%4d %7ld %s %ld 0 %ld 0 %ld 0 %ld 0 0 %ld %ld "
+			            "0 0 0 0 0 0\n", 8, k * 16 + p, name,
+				r * 100, r * 800, r * 50, r * 400, r * 3, r * 4);
+		}
+
+		for (p=0; p <= 3 && n < ndevices; p++, n++)
+		{
+			if (p)
+				snprintf(name, sizeof name, "nvme%ldn1p%d", k, p);
+			else
+				snprintf(name, sizeof name, "nvme%ldn1", k);
+
+			r = k * 4 + p + 7;
+
+			fprintf(fp, "%4d %7ld %s %ld 0 %ld 0 %ld 0 %ld 0 0 %ld %ld "
+			            "0 0 0 0 0 0\n", 259, k * 4 + p, name,
+				r * 200, r * 1600, r * 70, r * 560, r * 5, r * 6);
+		}
+
+		if (n++ < ndevices)
+			fprintf(fp, "%4d %7ld md%ld %ld 0 %ld 0 %ld 0 %ld 0 0 %ld %ld "
+			            "0 0 0 0 0 0\n", 9, k, k,
+				k * 11 + 1, k * 88 + 8, k * 7 + 1, k * 56 + 8,
+				k + 1, k + 2);
+
+		for (p=0; p < 2 && n < ndevices; p++, n++)
+			fprintf(fp, "%4d %7ld dm-%ld %ld 0 %ld 0 %ld 0 %ld 0 0 %ld %ld "
+			            "0 0 0 0 0 0\n", 253, k * 2 + p, k * 2 + p,
+				k * 30 + p + 1, k * 240 + 8, k * 20 + p + 1,
+				k * 160 + 8, k + 3, k + 4);
+
+		for (p=0; p < 2 && n < ndevices; p++, n++)
+			fprintf(fp, "%4d %7ld loop%ld %ld 0 %ld 0 0 0 0 0 0 %ld %ld "
+			            "0 0 0 0 0 0\n", 7, k * 2 + p, k * 2 + p,
+				p ? 0 : k + 1, p ? 0 : k * 8 + 8, p ? 0 : k,
+				p ? 0 : k);
+
+		if (n++ < ndevices)
+			fprintf(fp, "%4d %7ld ram%ld 0 0 0 0 0 0 0 0 0 0 0 "
+			            "0 0 0 0 0 0\n", 1, k, k);
+	}
+}
+
+/*
+** compose a name of a prefix and letters, like sda, sdz, sdaa, ...
+*/
+static void
+letters(char *buf, size_t size, const char *prefix, long num)
+{
+	char	suffix[16], *p = suffix + sizeof suffix - 1;
+
+	*p = '\0';
+
+	do
+	{
+		*--p = 'a' + num % 26;
+		num  = num / 26 - 1;
+	} while (num >= 0 && p > suffix);
+
+	snprintf(buf, size, "%s%s", prefix, p);
+}
+
+/*
+** register a device that is shown by atop
+*/
+static void
+account(struct result *res, int type, struct perdsk *dp)
+{
+	char	*p;
+
+	switch (type)
+	{
+	   case DSKTYPE:
+		res->ndsk++;
+		break;
+	   case MDDTYPE:
+		res->nmdd++;
+		break;
+	   case LVMTYPE:
+		res->nlvm++;
+		break;
+	   default:
+		return;
+	}
+
+	res->checksum += dp->nread + dp->nrsect * 3 + dp->nwrite * 5 +
+	                 dp->nwsect * 7 + dp->io_ms * 11 + dp->avque * 13;
+
+	for (p = dp->name; *p; p++)
+		res->checksum = res->checksum * 31 + (unsigned char)*p;
+}
+
+/*
+** parse the diskstats file as atop did before: a complete sscanf()
+** per line and the regular expressions of isdisk_name() for every line
+**
+** return value: elapsed time in milliseconds
+*/
+static double
+parseold(char *path, struct result *res)
+{
+	struct timespec	tstart, tend;
+	struct perdsk	tmpdsk;
+	char		linebuf[256], diskname[256];
+	unsigned int	major, minor;
+	FILE		*fp;
+	int		nr;
+
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+
+	if ( (fp = fopen(path, "r")) == NULL)
+	{
+		perror(path);
+		exit(3);
+	}
+
+	while ( fgets(linebuf, sizeof(linebuf), fp) )
+	{
+		tmpdsk.ndisc = -1;
+
+		nr = sscanf(linebuf,
+		      "%u %u %255s "
+		      "%lld %*d %lld %*d "
+		      "%lld %*d %lld %*d "
+		      "%lld %lld %lld "
+		      "%lld %*d %lld %*d",
+			&major, &minor, diskname,
+			&tmpdsk.nread,  &tmpdsk.nrsect,
+			&tmpdsk.nwrite, &tmpdsk.nwsect,
+			&tmpdsk.inflight, &tmpdsk.io_ms, &tmpdsk.avque,
+			&tmpdsk.ndisc,  &tmpdsk.ndsect);
+
+		if (nr < 10)
+			continue;
+
+		if (tmpdsk.nread + tmpdsk.nwrite +
+		     (tmpdsk.ndisc == -1 ? 0 : tmpdsk.ndisc) == 0)
+			continue;
+
+		account(res, isdisk_name(major, minor, diskname,
+						&tmpdsk, MAXDKNAM), &tmpdsk);
+	}
+
+	fclose(fp);
+
+	clock_gettime(CLOCK_MONOTONIC, &tend);
+
+	return (tend.tv_sec  - tstart.tv_sec) * 1000.0 +
+	       (tend.tv_nsec - tstart.tv_nsec) / 1000000.0;
+}
+
+/*
+** parse the diskstats file as photosyst() does
+**
+** return value: elapsed time in milliseconds
+*/
+static double
+parsenew(char *path, struct result *res)
+{
+	struct timespec	tstart, tend;
+	struct perdsk	tmpdsk;
+	char		linebuf[256], *diskname;
+	count_t		cnt[DSCOUNTERS];
+	unsigned int	major, minor;
+	FILE		*fp;
+	int		nr;
+
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+
+	diskchange();
+
+	if ( (fp = fopen(path, "r")) == NULL)
+	{
+		perror(path);
+		exit(3);
+	}
+
+	while ( fgets(linebuf, sizeof(linebuf), fp) )
+	{
+		nr = diskstatline(linebuf, &major, &minor, &diskname, cnt);
+
+		if (nr < 11)
+			continue;
+
+		nr = isdisk_cached(major, minor, diskname, &tmpdsk, MAXDKNAM);
+
+		if (nr == NONTYPE)
+			continue;
+
+		tmpdsk.nread    = cnt[0];
+		tmpdsk.nrsect   = cnt[2];
+		tmpdsk.nwrite   = cnt[4];
+		tmpdsk.nwsect   = cnt[6];
+		tmpdsk.inflight = cnt[8];
+		tmpdsk.io_ms    = cnt[9];
+		tmpdsk.avque    = cnt[10];
+		tmpdsk.ndisc    = cnt[11];
+		tmpdsk.ndsect   = cnt[13];
+
+		if (tmpdsk.nread + tmpdsk.nwrite +
+		     (tmpdsk.ndisc == -1 ? 0 : tmpdsk.ndisc) == 0)
+			continue;
+
+		account(res, nr, &tmpdsk);
+	}
+
+	fclose(fp);
+
+	clock_gettime(CLOCK_MONOTONIC, &tend);
+
+	return (tend.tv_sec  - tstart.tv_sec) * 1000.0 +
+	       (tend.tv_nsec - tstart.tv_nsec) / 1000000.0;
+}
+
+/*
+** functions of atop that are used by photosyst.c
+*/
+void
+ptrverify(const void *ptr, const char *errormsg, ...)
+{
+	va_list	args;
+
+	if (!ptr)
+	{
+		va_start(args, errormsg);
+		vfprintf(stderr, errormsg, args);
+		va_end(args);
+
+		exit(13);
+	}
+}
+
+void
+mcleanstop(int exitcode, const char *errormsg, ...)
+{
+	va_list	args;
+
+	va_start(args, errormsg);
+	vfprintf(stderr, errormsg, args);
+	va_end(args);
+
+	exit(exitcode);
+}
+
+void
+safe_strcpy(char *dst, const char *src, size_t dstsize)
+{
+	if (dstsize == 0)
+		return;
+
+	strncpy(dst, src, dstsize - 1);
+	dst[dstsize - 1] = '\0';
+}
+
+int
+droprootprivs(void)
+{
+	return 1;
+}
+
+void
+regainrootprivs(void)
+{
+}
+
+int
+run_in_guest(void)
+{
+	return 0;
+}
+
+int
+getifprop(struct ifprop *ifp)
+{
+	return 0;
+}
+
+void
+initifprop(void)
+{
+}
@@ -0,0 +1,188 @@
+/*
+** ATOP - System & Process Monitor
+**
+** The program 'atop' offers the possibility to view the activity of
+** the system on system-level as well as process-level.
+**
+** This source-file contains a benchmark for the ingestion of the
+** counters of netatop-bpf per sample: the functions of netatopbpfif.c
+** are called as atop does, i.e. one transfer of all tasks followed by
+** a search for every task (and optionally for the flows of every task).
+** It is meant to be used with the stand-in daemon (netbpfstandin)
+** that serves the tasks with ids firstid up to firstid+ntasks-1.
+**
+** Usage:
+**	netbpfbench [-b firstid] [-f flows] [-n samples] socketpath ntasks
+**
+** The output shows the time needed per sample, and the number of
+** tasks and flows found with a checksum of the counters to verify
+** that the results are reproducible.
+** ==========================================================================
+** Date:        October 2026
+** --------------------------------------------------------------------------
+**
+** This program is free software; you can redistribute it and/or modify it
+** under the terms of the GNU General Public License as published by the
+** Free Software Foundation; either version 2, or (at your option) any
+** later version.
+**
+** This program is distributed in the hope that it will be useful, but
+** WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU General Public License for more details.
+*/
+#include <sys/types.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "atop.h"
+#include "netatop.h"
+
+int	supportflags;
+
+int
+main(int argc, char *argv[])
+{
+	struct timespec		tstart, tend;
+	struct taskcount	*tc;
+	struct netperflow	*fp;
+	unsigned long long	checksum = 0;
+	long			ntasks, found = 0, flows = 0, i;
+	int			c, s, nsamples = 20, nflows = 0;
+	pid_t			firstid = 1;
+	char			flowarg[16];
+	double			elapsed;
+
+	while ( (c = getopt(argc, argv, "b:f:n:")) != -1)
+	{
+		switch (c)
+		{
+		   case 'b':
+			firstid = atoi(optarg);
+			break;
+		   case 'f':
+			nflows = atoi(optarg);
+			break;
+		   case 'n':
+			nsamples = atoi(optarg);
+			break;
+		   default:
+			argc = 0;
+		}
+	}
+
+	if (argc - optind != 2 || (ntasks = atol(argv[optind+1])) <= 0 ||
+	    nsamples <= 0)
+	{
+		fprintf(stderr, "Usage: netbpfbench [-b firstid] [-f flows] "
+		                "[-n samples] socketpath ntasks\n");
+		exit(1);
+	}
+
+	if (nflows)
+	{
+		snprintf(flowarg, sizeof flowarg, "%d", nflows);
+		do_netflows("netflows", flowarg);
+	}
+
+	setenv("ATOPNETBPF", argv[optind], 1);
+
+	netatop_bpf_probe();
+
+	if (!(supportflags & NETATOPBPF))
+	{
+		fprintf(stderr, "no connection with %s\n", argv[optind]);
+		exit(2);
+	}
+
+	/*
+	** first transfer is not measured (allocation of the arrays)
+	*/
+	netatop_bpf_gettask();
+
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+
+	for (s=0; s < nsamples; s++)
+	{
+		netatop_bpf_gettask();
+
+		if (!(supportflags & NETATOPBPF))
+		{
+			fprintf(stderr, "connection lost\n");
+			exit(3);
+		}
+
+		for (i=0; i < ntasks; i++)
+		{
+			if ( (tc = netatop_bpf_findtask(firstid + i)) )
+			{
+				found++;
+				checksum += tc->tcpsndbytes + tc->udprcvpacks;
+			}
+
+			if (nflows)
+				flows += netatop_bpf_findflows(firstid + i, &fp);
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &tend);
+
+	elapsed = (tend.tv_sec  - tstart.tv_sec) * 1000.0 +
+	          (tend.tv_nsec - tstart.tv_nsec) / 1000000.0;
+
+	printf("%7ld tasks: %8.3f ms/sample  (found %ld tasks, %ld flows, "
+	       "checksum %llx)\n", ntasks, elapsed / nsamples,
+	       found / nsamples, flows / nsamples, checksum);
+
+	return found == ntasks * nsamples ? 0 : 4;
+}
+
+/*
+** functions of atop that are used by netatopbpfif.c
+*/
+void
+ptrverify(const void *ptr, const char *errormsg, ...)
+{
+	va_list	args;
+
+	if (!ptr)
+	{
+		va_start(args, errormsg);
+		vfprintf(stderr, errormsg, args);
+		va_end(args);
+
+		exit(13);
+	}
+}
+
+void
+mcleanstop(int exitcode, const char *errormsg, ...)
+{
+	va_list	args;
+
+	va_start(args, errormsg);
+	vfprintf(stderr, errormsg, args);
+	va_end(args);
+
+	exit(exitcode);
+}
+
+int
+numeric(char *ns)
+{
+	return strspn(ns, "0123456789") == strlen(ns);
+}
+
+void
+safe_strcpy(char *dst, const char *src, size_t dstsize)
+{
+	if (dstsize == 0)
+		return;
+
+	strncpy(dst, src, dstsize - 1);
+	dst[dstsize - 1] = '\0';
+}
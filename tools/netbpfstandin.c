@@ -0,0 +1,389 @@
+/*
+** ATOP - System & Process Monitor
+**
+** The program 'atop' offers the possibility to view the activity of
+** the system on system-level as well as process-level.
+**
+** This source-file contains a stand-in for the netatop-bpf daemon,
+** to exercise and benchmark the netatop-bpf interface of atop without
+** eBPF support and without root privileges.
+** The stand-in listens on a UNIX domain socket and answers every request
+** of atop with synthetic counters for a configurable number of tasks.
+** The counters are derived from a seed, the task id and the sequence
+** number of the request, so every run provides the same values.
+** Optionally the most active flows per task are replayed as well.
+**
+** Usage:
+**	netbpfstandin [-p] [-s seed] [-b firstid] [-f flows [-u]]
+**	              socketpath ntasks
+**
+**	-p	plain protocol (like older daemons): the request contents
+**		are ignored and the tasks are sent unsorted
+**	-s	seed for the synthetic counters (default 1)
+**	-b	id of the first task (default 1)
+**	-f	number of flows per task that is available (the feature
+**		'flows' is announced in the header of a bulk response)
+**	-u	send the flows unsorted (in descending order of id)
+**
+** Start atop with the environment variable ATOPNETBPF set to the
+** socket path to connect to the stand-in instead of netatop-bpf.
+** ==========================================================================
+** Date:        October 2026
+** --------------------------------------------------------------------------
+**
+** This program is free software; you can redistribute it and/or modify it
+** under the terms of the GNU General Public License as published by the
+** Free Software Foundation; either version 2, or (at your option) any
+** later version.
+**
+** This program is distributed in the hope that it will be useful, but
+** WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU General Public License for more details.
+*/
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+
+#include "netatop.h"
+
+static int		plain;		// boolean: plain protocol
+static unsigned int	seed = 1;
+static pid_t		firstid = 1;
+static long		ntasks;
+static int		nflows;		// flows per task (0: no flows)
+static int		unsorted;	// boolean: flows unsorted
+
+static struct netpertask	*tasks;	// response buffer (incl. header)
+
+static unsigned int	mix(unsigned int, unsigned int);
+static void		fillcounters(struct netpertask *, unsigned long);
+static long		filltasks(int, unsigned long);
+static int		sendflows(int, int, unsigned long);
+static void		fillflow(struct netperflow *, pid_t, int,
+							unsigned long);
+static int		sendall(int, void *, size_t);
+static int		listensock(char *);
+
+int
+main(int argc, char *argv[])
+{
+	struct netpertask	req;
+	unsigned long		reqnum = 0;
+	int			c, lsock, sock;
+	long			n;
+
+	while ( (c = getopt(argc, argv, "ps:b:f:u")) != -1)
+	{
+		switch (c)
+		{
+		   case 'p':
+			plain = 1;
+			break;
+		   case 's':
+			seed = strtoul(optarg, NULL, 0);
+			break;
+		   case 'b':
+			firstid = atoi(optarg);
+			break;
+		   case 'f':
+			nflows = atoi(optarg);
+			break;
+		   case 'u':
+			unsorted = 1;
+			break;
+		   default:
+			argc = 0;
+		}
+	}
+
+	if (argc - optind != 2 || (ntasks = atol(argv[optind+1])) <= 0 ||
+	    firstid <= 0 || nflows < 0)
+	{
+		fprintf(stderr, "Usage: netbpfstandin [-p] [-s seed] "
+		                "[-b firstid] [-f flows [-u]] "
+		                "socketpath ntasks\n");
+		exit(1);
+	}
+
+	if ( (tasks = calloc(ntasks+2, sizeof *tasks)) == NULL)
+	{
+		fprintf(stderr, "Malloc failed for %ld tasks\n", ntasks);
+		exit(2);
+	}
+
+	if ( (lsock = listensock(argv[optind])) == -1)
+		exit(3);
+
+	signal(SIGPIPE, SIG_IGN);
+
+	/*
+	** serve one client (atop) at a time
+	*/
+	while ( (sock = accept(lsock, NULL, NULL)) != -1 ||
+	        errno == EINTR)
+	{
+		if (sock == -1)
+			continue;
+
+		while (recv(sock, &req, sizeof req, MSG_WAITALL) == sizeof req)
+		{
+			reqnum++;
+
+			if (req.id == NETATOPBPF_FLOWS && nflows && !plain)
+			{
+				if (sendflows(sock, req.btime, reqnum) == -1)
+					break;
+				continue;
+			}
+
+			n = filltasks(!plain && req.id == NETATOPBPF_BULK,
+								reqnum);
+
+			if (sendall(sock, tasks, n * sizeof *tasks) == -1)
+				break;
+		}
+
+		close(sock);
+	}
+
+	perror("accept");
+	return 4;
+}
+
+/*
+** create the listening socket under a temporary name and rename
+** it afterwards, so clients never find a socket that does not
+** accept connections yet
+*/
+static int
+listensock(char *path)
+{
+	struct sockaddr_un	un;
+	char			tmppath[sizeof un.sun_path];
+	int			sock;
+
+	if (snprintf(tmppath, sizeof tmppath, "%s.tmp", path) >=
+							sizeof tmppath)
+	{
+		fprintf(stderr, "socket path %s too long\n", path);
+		return -1;
+	}
+
+	memset(&un, 0, sizeof un);
+	un.sun_family = AF_UNIX;
+	strcpy(un.sun_path, tmppath);
+
+	(void) unlink(tmppath);
+
+	if ( (sock = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+	{
+		perror("socket");
+		return -1;
+	}
+
+	if (bind(sock, (struct sockaddr *)&un, sizeof un) == -1 ||
+	    listen(sock, 4) == -1                                  ||
+	    rename(tmppath, path) == -1                              )
+	{
+		perror(path);
+		close(sock);
+		return -1;
+	}
+
+	return sock;
+}
+
+/*
+** fill the response buffer for the given request number,
+** either as bulk response or as plain response
+**
+** return value: number of records to be sent (incl. header and terminator)
+*/
+static long
+filltasks(int bulk, unsigned long reqnum)
+{
+	struct netpertask	*npt = tasks;
+	long			i;
+
+	memset(tasks, 0, (ntasks+2) * sizeof *tasks);
+
+	/*
+	** header of bulk response
+	*/
+	if (bulk)
+	{
+		npt->id    = NETATOPBPF_BULK;
+		npt->btime = ntasks;
+
+		if (nflows)
+			strcpy(npt->command, NETATOPBPF_FEATFLOWS);
+
+		npt++;
+	}
+
+	/*
+	** tasks in ascending order for a bulk response and in
+	** descending order for a plain response (to verify that
+	** the client sorts them itself)
+	*/
+	for (i=0; i < ntasks; i++, npt++)
+	{
+		npt->id = bulk ? firstid + i : firstid + ntasks - 1 - i;
+		fillcounters(npt, reqnum);
+	}
+
+	npt->id = 0;		// terminator
+
+	return npt - tasks + 1;
+}
+
+/*
+** send the flows of all tasks with at most 'maxflows' flows per task
+** (in chunks to limit the memory needed for large numbers of tasks)
+**
+** return value: 0 (success) or -1 (connection lost)
+*/
+#define	FLOWCHUNK	1024
+
+static int
+sendflows(int sock, int maxflows, unsigned long reqnum)
+{
+	static struct netperflow	chunk[FLOWCHUNK];
+	struct netperflow		*fp = chunk;
+	long				i;
+	int				f, n = nflows < maxflows ? nflows : maxflows;
+
+	for (i=0; i < ntasks; i++)
+	{
+		pid_t	id = unsorted ? firstid + ntasks - 1 - i : firstid + i;
+
+		for (f=0; f < n; f++)	// most active flow first
+		{
+			fillflow(fp++, id, f, reqnum);
+
+			if (fp == chunk + FLOWCHUNK)
+			{
+				if (sendall(sock, chunk, sizeof chunk) == -1)
+					return -1;
+				fp = chunk;
+			}
+		}
+	}
+
+	memset(fp++, 0, sizeof *fp);	// terminator
+
+	return sendall(sock, chunk, (fp - chunk) * sizeof *fp);
+}
+
+/*
+** synthetic flow with sequence number 'flownum' of a task, with
+** counters of the last interval (less packets for higher sequence
+** numbers); the remote address is taken from the documentation
+** ranges 192.0.2.0/24 and 2001:db8::/32
+*/
+static void
+fillflow(struct netperflow *fp, pid_t id, int flownum, unsigned long reqnum)
+{
+	unsigned int	h    = mix(seed ^ (flownum + 1), id);
+	unsigned int	t    = mix(seed, id);	// per task
+	unsigned int	rate = (t % 100 + 1) * (reqnum % 3 + 1);
+
+	memset(fp, 0, sizeof *fp);
+
+	fp->id     = id;
+	fp->proto  = h & 1 ? IPPROTO_UDP : IPPROTO_TCP;
+	fp->family = h & 2 ? AF_INET6    : AF_INET;
+	fp->lport  = 1024 + (h >> 2) % 60000;
+	fp->rport  = (h >> 8) % 1024 + 1;
+
+	if (fp->family == AF_INET)
+	{
+		fp->raddr[0] = 192;
+		fp->raddr[2] = 2;
+		fp->raddr[3] = h >> 24;
+	}
+	else
+	{
+		fp->raddr[0]  = 0x20;
+		fp->raddr[1]  = 0x01;
+		fp->raddr[2]  = 0x0d;
+		fp->raddr[3]  = 0xb8;
+		fp->raddr[14] = h >> 16;
+		fp->raddr[15] = h >> 24;
+	}
+
+	fp->sndpacks = (unsigned long long)rate * (nflows - flownum);
+	fp->rcvpacks = fp->sndpacks * 2;
+	fp->sndbytes = fp->sndpacks * (64 + (t >> 8) % 1400);
+	fp->rcvbytes = fp->rcvpacks * (64 + (t >> 8) % 1400);
+}
+
+/*
+** synthetic counters of a task: every task has its own fixed rate
+** per request, so the counters are cumulative and the deviations
+** between two requests are constant
+*/
+static void
+fillcounters(struct netpertask *npt, unsigned long reqnum)
+{
+	unsigned int	h = mix(seed, npt->id);
+
+	snprintf(npt->command, sizeof npt->command, "task%u", h % 1000);
+
+	npt->tc.tcpsndpacks = (unsigned long long)(h         % 1000) * reqnum;
+	npt->tc.tcprcvpacks = (unsigned long long)((h >> 10) % 1000) * reqnum;
+	npt->tc.udpsndpacks = (unsigned long long)((h >> 20) %  100) * reqnum;
+	npt->tc.udprcvpacks = (unsigned long long)((h >> 24) %  100) * reqnum;
+
+	npt->tc.tcpsndbytes = npt->tc.tcpsndpacks * (64 + h % 1400);
+	npt->tc.tcprcvbytes = npt->tc.tcprcvpacks * (64 + (h >> 8) % 1400);
+	npt->tc.udpsndbytes = npt->tc.udpsndpacks * (32 + (h >> 16) % 512);
+	npt->tc.udprcvbytes = npt->tc.udprcvpacks * (32 + (h >> 4) % 512);
+}
+
+/*
+** integer hash of seed and value
+*/
+static unsigned int
+mix(unsigned int seed, unsigned int val)
+{
+	unsigned int	h = seed * 0x9e3779b9 ^ val;
+
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35;
+	h ^= h >> 16;
+
+	return h;
+}
+
+static int
+sendall(int sock, void *buf, size_t len)
+{
+	char	*p = buf;
+	ssize_t	n;
+
+	while (len > 0)
+	{
+		if ( (n = send(sock, p, len, 0)) == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+
+		p   += n;
+		len -= n;
+	}
+
+	return 0;
+}
@@ -0,0 +1,223 @@
+/*
+** ATOP - System & Process Monitor
+**
+** The program 'atop' offers the possibility to view the activity of
+** the system on system-level as well as process-level.
+**
+** This source-file contains a benchmark for matching exited processes
+** without PID (version 2 of the accounting record) against the process
+** database, as deviattask() does per sample: the process database is
+** filled with the tasks of the previous sample, the tasks that are
+** still alive are taken from the RESIDUE-list via pdb_gettask(), and
+** every exited process is searched via pdb_srchresidue() on name, real
+** uid/gid and start time and removed from the process database.
+**
+** Usage:
+**	pdbbench [-n samples] [-a alive] nexits
+**
+** The output shows the time needed per sample for matching the exited
+** processes (the residue search and the removal), and the number of
+** exited processes found with a checksum to verify that the results
+** are reproducible.
+** ==========================================================================
+** Date:        October 2026
+** --------------------------------------------------------------------------
+**
+** This program is free software; you can redistribute it and/or modify it
+** under the terms of the GNU General Public License as published by the
+** Free Software Foundation; either version 2, or (at your option) any
+** later version.
+**
+** This program is distributed in the hope that it will be useful, but
+** WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU General Public License for more details.
+*/
+#include <sys/types.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "atop.h"
+#include "photoproc.h"
+
+static void	fillpdb(long, long);
+static void	maketask(struct tstat *, long);
+static double	sample(long, long, struct tstat *, unsigned long *,
+					unsigned long long *);
+
+int
+main(int argc, char *argv[])
+{
+	struct tstat		*exits;
+	unsigned long		found = 0;
+	unsigned long long	checksum = 0;
+	double			elapsed = 0.0;
+	long			nexits, nalive = 10000, i;
+	int			c, s, nsamples = 10;
+
+	while ( (c = getopt(argc, argv, "n:a:")) != -1)
+	{
+		switch (c)
+		{
+		   case 'n':
+			nsamples = atoi(optarg);
+			break;
+		   case 'a':
+			nalive = atol(optarg);
+			break;
+		   default:
+			argc = 0;
+		}
+	}
+
+	if (argc - optind != 1 || (nexits = atol(argv[optind])) <= 0 ||
+	    nsamples <= 0 || nalive < 0)
+	{
+		fprintf(stderr, "Usage: pdbbench [-n samples] [-a alive] "
+		                "nexits\n");
+		exit(1);
+	}
+
+	/*
+	** the accounting records of the exited processes carry no PID;
+	** the tasks are numbered with the alive tasks first
+	*/
+	exits = calloc(nexits, sizeof(struct tstat));
+
+	ptrverify(exits, "Malloc failed for %ld exited processes\n", nexits);
+
+	for (i=0; i < nexits; i++)
+	{
+		maketask(&exits[i], nalive + i);
+		exits[i].gen.pid = 0;
+	}
+
+	for (s=0; s < nsamples; s++)
+		elapsed += sample(nalive, nexits, exits, &found, &checksum);
+
+	printf("%7ld exits: %8.3f ms/sample  (%ld alive, found %lu exits, "
+	       "checksum %llx)\n", nexits, elapsed / nsamples, nalive,
+		found / nsamples, checksum);
+
+	return found == nexits * nsamples ? 0 : 4;
+}
+
+/*
+** one sample: fill the process database with the tasks of the previous
+** sample, take the alive tasks and match the exited processes
+**
+** return value: elapsed time in milliseconds for the matching
+*/
+static double
+sample(long nalive, long nexits, struct tstat *exits, unsigned long *found,
+					unsigned long long *checksum)
+{
+	struct timespec	tstart, tend;
+	struct tstat	tstat;
+	struct pinfo	*pinfo;
+	long		i;
+
+	fillpdb(nalive, nexits);
+
+	pdb_makeresidue();
+
+	for (i=0; i < nalive; i++)
+	{
+		maketask(&tstat, i);
+		pdb_gettask(tstat.gen.pid, 1, tstat.gen.btime, &pinfo);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &tstart);
+
+	for (i=0; i < nexits; i++)
+	{
+		if (pdb_srchresidue(&exits[i], &pinfo))
+		{
+			(*found)++;
+			*checksum = *checksum * 31 + pinfo->tstat.gen.pid;
+
+			pdb_deltask(pinfo->tstat.gen.pid,
+				    pinfo->tstat.gen.isproc);
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &tend);
+
+	pdb_cleanresidue();
+
+	/*
+	** remove the alive tasks as well to start the next sample
+	** with an empty process database
+	*/
+	for (i=0; i < nalive; i++)
+	{
+		maketask(&tstat, i);
+		pdb_deltask(tstat.gen.pid, 1);
+	}
+
+	return (tend.tv_sec  - tstart.tv_sec) * 1000.0 +
+	       (tend.tv_nsec - tstart.tv_nsec) / 1000000.0;
+}
+
+/*
+** add the alive tasks and the tasks that will exit
+** to the process database
+*/
+static void
+fillpdb(long nalive, long nexits)
+{
+	struct pinfo	*pinfo;
+	long		i;
+
+	for (i=0; i < nalive + nexits; i++)
+	{
+		pinfo = calloc(1, sizeof(struct pinfo));
+
+		ptrverify(pinfo, "Malloc failed for process %ld\n", i);
+
+		maketask(&pinfo->tstat, i);
+		pdb_addtask(pinfo->tstat.gen.pid, pinfo);
+	}
+}
+
+/*
+** synthetic task: many tasks share their name, user and start time
+** (like the short-lived processes of a build), so the residue search
+** has to deal with duplicate keys
+*/
+static void
+maketask(struct tstat *tp, long num)
+{
+	memset(tp, 0, sizeof *tp);
+
+	tp->gen.pid    = 1000 + num;
+	tp->gen.tgid   = tp->gen.pid;
+	tp->gen.isproc = 1;
+	tp->gen.ruid   = 1000 + num % 20;
+	tp->gen.rgid   = tp->gen.ruid;
+	tp->gen.btime  = 1790000000 + num / 200;
+
+	snprintf(tp->gen.name, sizeof tp->gen.name, "cmd%ld", num % 97);
+}
+
+/*
+** functions of atop that are used by procdbase.c
+*/
+void
+ptrverify(const void *ptr, const char *errormsg, ...)
+{
+	va_list	args;
+
+	if (!ptr)
+	{
+		va_start(args, errormsg);
+		vfprintf(stderr, errormsg, args);
+		va_end(args);
+
+		exit(13);
+	}
+}
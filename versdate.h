@@ -0,0 +1,4 @@
+#ifndef __ATOP_VERSDATA__
+#define __ATOP_VERSDATA__
+#define	ATOPDATE	"2026/10/18 14:22:10"
+#endif
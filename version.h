@@ -1,7 +1,7 @@
 #ifndef __ATOP_VERSION__
 #define __ATOP_VERSION__
 
-#define	ATOPVERS	"2.13.0"
+#define	ATOPVERS	"2.14.0"
 
 char *getstrvers(void);
 unsigned short getnumvers(void);